@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Cold/Common.h"
+#include "Cold/Executable.h"
+#include "Cold/Instruction.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace cold::aot {
+
+    // Translates a program into C++ source for a shared object that coldemu loads through AotEngine. Every basic block
+    // becomes a function, register arithmetic and branches are inlined and everything touching memory or the host is
+    // handed back to the processor, so the module behaves exactly like the interpreter
+    class Translator {
+    public:
+        explicit Translator(const cold::Executable& executable);
+        ~Translator() = default;
+
+        [[nodiscard]] std::string translate();
+
+        [[nodiscard]] u32 getBlockCount() const { return static_cast<u32>(mLeaders.size()); }
+
+    private:
+        void emitBlock(std::ostringstream& out, const u32 begin, const u32 end) const;
+        void emitInstruction(std::ostringstream& out, const u32 pc) const;
+        void emitCallback(std::ostringstream& out, const u32 pc) const; // Runs the instruction through the processor
+
+        [[nodiscard]] static std::string getCondition(const cold::Instruction& instr); // Empty for unconditional branches
+
+        std::vector<cold::Instruction> mCode;
+        std::vector<std::string> mText; // Disassembly of every instruction, for comments
+        std::vector<u32> mLeaders; // Sorted first instructions of the blocks
+    };
+
+}
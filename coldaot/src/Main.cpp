@@ -0,0 +1,56 @@
+#include <string>
+#include <fstream>
+#include <iostream>
+
+#include <argparse/argparse.hpp>
+
+#include "Cold/Aot/Translator.h"
+#include "Cold/Executable.h"
+#include "Cold/MappedFile.h"
+
+int main(int argc, char** argv) {
+    argparse::ArgumentParser args("coldaot");
+    args.add_argument("-i", "--input")
+        .help("input file")
+        .required();
+
+    args.add_argument("-o", "--output")
+        .help("C++ output file")
+        .required();
+
+    try {
+        args.parse_args(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << args;
+        return 1;
+    }
+
+    const std::string inputFile = args.get<std::string>("--input");
+    const std::string outputFile = args.get<std::string>("--output");
+
+    try {
+        const cold::MappedFile file(inputFile);
+        const cold::Executable executable = cold::Executable::load(file.getBytes());
+        if (executable.code.empty()) {
+            throw std::runtime_error("Program has no code");
+        }
+
+        cold::aot::Translator translator(executable);
+        const std::string source = translator.translate();
+
+        std::ofstream output(outputFile);
+        if (!output.is_open()) {
+            throw std::runtime_error("Failed to open file: " + outputFile);
+        }
+
+        output << source;
+
+        std::cout << "Translated " << executable.code.size() << " instructions in " << translator.getBlockCount() << " blocks to " << outputFile << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,253 @@
+#include "Cold/Aot/Translator.h"
+#include "Cold/AotModule.h"
+#include "Cold/ControlFlowGraph.h"
+#include "Cold/Disassembly/Disassembler.h"
+
+#include <algorithm>
+
+using Type = cold::Instruction::Type;
+
+namespace {
+
+    std::string hex(const u64 value) {
+        std::ostringstream out;
+        out << "0x" << std::hex << std::uppercase << value;
+        return out.str();
+    }
+
+}
+
+cold::aot::Translator::Translator(const cold::Executable& executable)
+    : mCode(executable.code)
+    , mText()
+    , mLeaders()
+{
+    const cold::disassembly::Disassembler disassembler(mCode);
+    for (const cold::Instruction& instr : mCode) {
+        mText.push_back(disassembler.disassemble(instr));
+    }
+
+    // The assembler's block index saves building the control flow graph again, raw images have none. Also split at the entry
+    const u32 size = static_cast<u32>(mCode.size());
+    if (executable.blockStarts.empty()) {
+        const cold::ControlFlowGraph cfg(mCode);
+        for (const cold::ControlFlowGraph::BasicBlock& block : cfg.getBlocks()) {
+            mLeaders.push_back(block.begin);
+        }
+    }
+
+    for (const u32 start : executable.blockStarts) {
+        if (start < size) {
+            mLeaders.push_back(start);
+        }
+    }
+
+    if (executable.entry < size) {
+        mLeaders.push_back(executable.entry);
+    }
+
+    std::sort(mLeaders.begin(), mLeaders.end());
+    mLeaders.erase(std::unique(mLeaders.begin(), mLeaders.end()), mLeaders.end());
+}
+
+std::string cold::aot::Translator::translate() {
+    std::ostringstream out;
+
+    out << "// Generated by coldaot, compile into a shared object and run it with coldemu --engine aot:PATH\n";
+    out << "#include \"Cold/AotModule.h\"\n\n";
+    out << "namespace {\n\n";
+    out << "    using namespace cold::aot;\n\n";
+
+    const u32 size = static_cast<u32>(mCode.size());
+    for (u32 i = 0; i < mLeaders.size(); i++) {
+        this->emitBlock(out, mLeaders[i], i + 1 < mLeaders.size() ? mLeaders[i + 1] : size);
+    }
+
+    // Direct branches and returns through the link register all land in this switch
+    out << "    u64 run(Context& c, const u64 maxInstructions, const bool stopAtBranch) {\n";
+    out << "        u64 executed = 0;\n";
+    out << "        c.atBranch = false;\n\n";
+    out << "        for (;;) {\n";
+    out << "            switch (*c.pc) {\n";
+
+    for (u32 i = 0; i < mLeaders.size(); i++) {
+        const u32 begin = mLeaders[i];
+        const u32 end = i + 1 < mLeaders.size() ? mLeaders[i + 1] : size;
+        const u32 length = end - begin;
+
+        out << "                case " << begin << ":\n";
+        out << "                    if (maxInstructions - executed < " << length << ") return executed;\n";
+        out << "                    executed += " << length << ";\n";
+        out << "                    if (!block" << begin << "(c)) return executed;\n";
+
+        if (mCode[end - 1].isBranch()) {
+            out << "                    if (stopAtBranch) { c.atBranch = true; return executed; }\n";
+        }
+
+        out << "                    break;\n";
+    }
+
+    out << "                default:\n";
+    out << "                    return executed;\n";
+    out << "            }\n";
+    out << "        }\n";
+    out << "    }\n\n";
+
+    out << "    const Module sModule = {\n";
+    out << "        .abiVersion = " << cold::aot::cAbiVersion << ",\n";
+    out << "        .codeSize = " << size << ",\n";
+    out << "        .codeHash = " << hex(cold::aot::hashCode(mCode)) << "ull,\n";
+    out << "        .run = &run\n";
+    out << "    };\n\n";
+    out << "}\n\n";
+
+    out << "COLD_AOT_EXPORT const cold::aot::Module* " << cold::aot::cEntryPoint << "() {\n";
+    out << "    return &sModule;\n";
+    out << "}\n";
+
+    return out.str();
+}
+
+void cold::aot::Translator::emitBlock(std::ostringstream& out, const u32 begin, const u32 end) const {
+    // Returns false once the processor finished, pc always holds the next instruction like after the interpreter's increment
+    out << "    bool block" << begin << "(Context& c) {\n";
+    out << "        u32* const r = c.gpr;\n";
+
+    for (u32 pc = begin; pc < end; pc++) {
+        this->emitInstruction(out, pc);
+    }
+
+    if (!mCode[end - 1].isBranch()) {
+        out << "        *c.pc = " << end << ";\n";
+    }
+
+    out << "        return true;\n";
+    out << "    }\n\n";
+}
+
+void cold::aot::Translator::emitInstruction(std::ostringstream& out, const u32 pc) const {
+    const cold::Instruction& instr = mCode[pc];
+    out << "        // @" << pc << ": " << mText[pc] << "\n";
+
+    if (!isInlined(instr)) {
+        this->emitCallback(out, pc);
+        return;
+    }
+
+    const auto [byte1, byte2, byte3] = instr.getTripleByteData();
+    const std::string o = "r[" + std::to_string(byte1) + "]";
+    const std::string a = "r[" + std::to_string(byte2) + "]";
+    const std::string b = "r[" + std::to_string(byte3) + "]";
+    const std::string imm = std::to_string(byte3) + "u";
+    const std::string imm16 = std::to_string(instr.getData() & 0xFFFF) + "u";
+
+    const auto binary = [&](const char* op) {
+        out << "        " << o << " = " << a << " " << op << " " << b << ";\n";
+    };
+
+    const auto immediate = [&](const char* op) {
+        out << "        " << o << " = " << a << " " << op << " " << imm << ";\n";
+    };
+
+    const auto floating = [&](const char* op) {
+        out << "        " << o << " = fromFloat(toFloat(" << a << ") " << op << " toFloat(" << b << "));\n";
+    };
+
+    // Relative targets wrap like the processor's u32 pc
+    const u32 target = static_cast<u32>(pc + instr.getS24Data());
+    const std::string condition = getCondition(instr);
+
+    switch (Type(instr.getType())) {
+        case Type::SETI: out << "        " << o << " = " << imm16 << ";\n"; break;
+
+        case Type::ADD: binary("+"); break;
+        case Type::SUB: binary("-"); break;
+        case Type::MUL: binary("*"); break;
+        case Type::AND: binary("&"); break;
+        case Type::OR: binary("|"); break;
+        case Type::XOR: binary("^"); break;
+
+        case Type::ADDI: immediate("+"); break;
+        case Type::SUBI: immediate("-"); break;
+        case Type::MULI: immediate("*"); break;
+        case Type::ANDI: immediate("&"); break;
+        case Type::ORI: immediate("|"); break;
+        case Type::XORI: immediate("^"); break;
+        case Type::SHIFTL: immediate("<<"); break;
+        case Type::SHIFTR: immediate(">>"); break;
+
+        case Type::NOT: out << "        " << o << " = ~" << a << ";\n"; break;
+        case Type::SET: out << "        " << o << " = " << a << ";\n"; break;
+
+        case Type::FADD: floating("+"); break;
+        case Type::FSUB: floating("-"); break;
+        case Type::FMUL: floating("*"); break;
+        case Type::FDIV: floating("/"); break;
+
+        case Type::CMP: out << "        *c.cr = compare(" << o << ", " << a << ");\n"; break;
+        case Type::FCMP: out << "        *c.cr = compare(toFloat(" << o << "), toFloat(" << a << "));\n"; break;
+        case Type::CMPI: out << "        *c.cr = compare(" << o << ", " << imm16 << ");\n"; break;
+
+        case Type::MFLR: out << "        " << o << " = *c.lr;\n"; break;
+        case Type::MTLR: out << "        *c.lr = " << o << ";\n"; break;
+
+        case Type::B: case Type::BGT: case Type::BGE: case Type::BLT: case Type::BLE: case Type::BEQ: case Type::BNE:
+            if (condition.empty()) {
+                out << "        *c.pc = " << target << "u;\n";
+            } else {
+                out << "        *c.pc = " << condition << " ? " << target << "u : " << pc + 1 << "u;\n";
+            }
+            break;
+
+        case Type::BL: case Type::BGTL: case Type::BGEL: case Type::BLTL: case Type::BLEL: case Type::BEQL: case Type::BNEL:
+            if (condition.empty()) {
+                out << "        *c.lr = " << pc << "u;\n";
+                out << "        *c.pc = " << target << "u;\n";
+            } else {
+                out << "        if (" << condition << ") {\n";
+                out << "            *c.lr = " << pc << "u;\n";
+                out << "            *c.pc = " << target << "u;\n";
+                out << "        } else {\n";
+                out << "            *c.pc = " << pc + 1 << "u;\n";
+                out << "        }\n";
+            }
+            break;
+
+        case Type::BLR: case Type::BGTLR: case Type::BGELR: case Type::BLTLR: case Type::BLELR: case Type::BEQLR: case Type::BNELR:
+            if (condition.empty()) {
+                out << "        *c.pc = *c.lr + 1;\n";
+            } else {
+                out << "        *c.pc = " << condition << " ? *c.lr + 1 : " << pc + 1 << "u;\n";
+            }
+            break;
+
+        default:
+            this->emitCallback(out, pc);
+            break;
+    }
+}
+
+void cold::aot::Translator::emitCallback(std::ostringstream& out, const u32 pc) const {
+    out << "        *c.pc = " << pc << ";\n";
+    out << "        if (c.execute(c.host, " << hex(mCode[pc].getData()) << ")) { *c.pc = " << pc + 1 << "; return false; }\n";
+}
+
+std::string cold::aot::Translator::getCondition(const cold::Instruction& instr) {
+    // Conditions follow the same order in the B, BL and BLR families
+    u8 first = (u8)Type::B;
+    if (instr.isLinkBranch()) {
+        first = (u8)Type::BL;
+    } else if (instr.isReturnBranch()) {
+        first = (u8)Type::BLR;
+    }
+
+    switch (instr.getType() - first) {
+        case 1: return "(*c.cr & cGreaterThan)";
+        case 2: return "(*c.cr & (cGreaterThan | cEqual))";
+        case 3: return "(*c.cr & cLessThan)";
+        case 4: return "(*c.cr & (cLessThan | cEqual))";
+        case 5: return "(*c.cr & cEqual)";
+        case 6: return "!(*c.cr & cEqual)";
+        default: return "";
+    }
+}
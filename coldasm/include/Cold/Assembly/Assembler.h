@@ -18,11 +18,14 @@ namespace cold::assembly {
         ~Assembler() = default;
 
         std::vector<u8> assemble(const AssemblySource& source);
+        [[nodiscard]] cold::Instruction assembleInstruction(const std::string& line); // Branch targets must already be offsets
 
     private:
         using AssemblerFunc = void (Assembler::*)(std::vector<u8>& out, ParameterStream line);
         static const std::unordered_map<std::string, AssemblerFunc> sAssemblerFuncs;
 
+        void compileLine(std::vector<u8>& out, const std::string& line);
+
         void compileSETI(std::vector<u8>& out, ParameterStream line);
         void compileSYSCALL(std::vector<u8>& out, ParameterStream line);
         void compileADD(std::vector<u8>& out, ParameterStream line);
@@ -2,22 +2,62 @@
 
 #include "Cold/Common.h"
 
+#include <filesystem>
+#include <optional>
 #include <sstream>
+#include <string>
 #include <vector>
 
 namespace cold::assembly {
 
+    class Preprocessor;
+
     class AssemblySource {
     public:
-        AssemblySource(const std::string& sourceCode);
+        struct Label {
+            std::string name;
+            u32 pc; // Instruction the label is attached to
+        };
+
+        struct DataLabel {
+            std::string name;
+            u32 offset; // From the start of the data
+        };
+
+        AssemblySource(const std::string& sourceCode, cold::assembly::Preprocessor* preprocessor = nullptr, const std::filesystem::path& directory = {}); // Sharing a preprocessor shares its include cache
         ~AssemblySource() = default;
 
         [[nodiscard]] const std::vector<std::string>& getLines() const { return mLines; } // Returns lines after preprocessing
+        [[nodiscard]] const std::vector<Label>& getLabels() const { return mLabels; }
+        [[nodiscard]] u32 getEntry() const { return mEntry; } // Set with .entry LABEL, the first instruction otherwise
+
+        [[nodiscard]] const std::vector<u8>& getData() const { return mData; } // Bytes from .word, .byte, .float, .ascii and .space
+        [[nodiscard]] const std::vector<DataLabel>& getDataLabels() const { return mDataLabels; }
+        [[nodiscard]] u32 getDataAddress() const { return mDataAddress; } // Past the end of the unoptimized code
 
     private:
+        // A .word naming a data label, patched once the data address is known
+        struct DataReference {
+            u32 offset;
+            std::string label;
+        };
+
         void preprocess();
+        void expandFunctions();
+        void collectData();
+        void emitData(const std::string& directive, const std::string& operands);
+        void expandPseudoInstructions();
+        void collectLabels();
+        [[nodiscard]] u32 getDataLabelAddress(const std::string& name) const;
 
         std::vector<std::string> mLines;
+        std::vector<Label> mLabels;
+        std::optional<std::string> mEntryLabel;
+        u32 mEntry;
+        std::vector<u8> mData;
+        std::vector<DataLabel> mDataLabels;
+        std::vector<DataReference> mDataReferences;
+        u32 mDataAddress;
     };
 
 }
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Cold/Common.h"
+
+#include <string>
+#include <vector>
+
+namespace cold::assembly {
+
+    // Finds the shortest instruction sequence that loads a 32-bit constant into a register.
+    // A constant pool in the data would take only QMB and LDW, but neither runs inline in the tiered engine or coldaot,
+    // which makes it slower than even the five instruction fallback. LDW offsets are signed bytes, so a pool would also
+    // be limited to 31 words and have to sit in front of every other data directive
+    class ConstantMaterializer {
+    public:
+        static constexpr u32 cMaxSearchDepth = 4; // Steps after the initial SETI, longer constants use the byte-wise fallback
+
+        [[nodiscard]] static std::vector<std::string> materialize(const u8 reg, const u32 value);
+
+    private:
+        enum class Operation : u8 {
+            NOT,
+            SHIFTL,
+            ORI,
+            ADDI,
+            SUBI
+        };
+
+        struct Step {
+            Operation operation;
+            u32 imm;
+        };
+
+        static bool search(const u32 value, const u32 depth, const Operation previous, u32& base, std::vector<Step>& steps);
+    };
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Cold/Common.h"
+#include "Cold/Instruction.h"
+
+#include <optional>
+#include <vector>
+
+namespace cold::assembly {
+
+    // Peephole optimizer working on the assembled instruction stream, branch offsets are re-resolved after every change
+    class Optimizer {
+    public:
+        Optimizer() = default;
+        ~Optimizer() = default;
+
+        std::vector<u8> optimize(const std::vector<u8>& binary, std::vector<u32>* labels = nullptr); // Labels are moved along with their instructions
+
+        void setInlining(const bool inlining) { mInlining = inlining; } // Copies small leaf functions into their BL call sites first
+
+        [[nodiscard]] u32 getRemovedCount() const { return mRemovedCount; }
+        [[nodiscard]] u32 getInlinedCount() const { return mInlinedCount; }
+
+    private:
+        static constexpr s64 cMaxInlineSize = 8; // Instructions in a function body, without its BLR
+
+        struct Entry {
+            cold::Instruction instr;
+            s64 target;         // Absolute branch target, only valid for relative branches
+            bool removed;
+        };
+
+        bool removeRedundantMoves(std::vector<Entry>& program);
+        bool removeOverwrittenWrites(std::vector<Entry>& program);
+        bool forwardStoresToLoads(std::vector<Entry>& program, const std::vector<bool>& leaders);
+
+        void inlineLeafCalls(std::vector<Entry>& program);
+        [[nodiscard]] static std::optional<s64> findInlineEnd(const std::vector<Entry>& program, const s64 entry); // Index of the closing BLR
+        [[nodiscard]] static std::vector<bool> findLiveLinks(const std::vector<Entry>& program); // Whether lr may be read before it is written, by pc
+
+        void compact(std::vector<Entry>& program);
+
+        std::vector<u32>* mLabels = nullptr;
+        u32 mRemovedCount = 0;
+        u32 mInlinedCount = 0;
+        bool mInlining = false;
+    };
+
+}
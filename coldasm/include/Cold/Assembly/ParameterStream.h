@@ -14,6 +14,7 @@ namespace cold::assembly {
         [[nodiscard]] s32 getRegisterParam();
         [[nodiscard]] std::string getStringParam();
         [[nodiscard]] s32 getImmediateParam();
+        [[nodiscard]] u32 getLargeImmediateParam(); // Full 32-bit integers and f32 literals (bit pattern)
 
     private:
         const std::string mTxt;
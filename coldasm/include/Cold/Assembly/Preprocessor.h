@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Cold/Common.h"
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cold::assembly {
+
+    // Expands .include, .macro, .equ and conditional blocks. Included files are read once and kept for every source processed afterwards
+    class Preprocessor {
+    public:
+        Preprocessor() = default;
+        ~Preprocessor() = default;
+
+        // Includes are resolved relative to directory
+        [[nodiscard]] std::vector<std::string> process(const std::vector<std::string>& lines, const std::filesystem::path& directory);
+
+        [[nodiscard]] static std::vector<std::string> normalize(const std::string& sourceCode); // Drops comments and empty lines, splits on semicolons and collapses spaces
+        [[nodiscard]] static std::size_t findUnquoted(const std::string& str, const char c, const std::size_t pos = 0); // Skips character and string literals
+
+    private:
+        struct Macro {
+            std::vector<std::string> parameters;
+            std::vector<std::string> body;
+            std::filesystem::path directory; // Includes in the body are relative to the file that defined it
+        };
+
+        struct Conditional {
+            bool active;    // Lines are kept
+            bool taken;     // A branch of this block was already active
+        };
+
+        void processLines(const std::vector<std::string>& lines, const std::filesystem::path& directory, std::vector<std::string>& out, const u32 depth);
+        void expandMacro(const std::string& name, const Macro& macro, const std::string& arguments, std::vector<std::string>& out, const u32 depth);
+        [[nodiscard]] const std::vector<std::string>& loadInclude(const std::filesystem::path& path);
+        [[nodiscard]] std::string substituteConstants(const std::string& line) const;
+        [[nodiscard]] bool evaluateCondition(const std::string& condition) const;
+
+        std::unordered_map<std::string, std::vector<std::string>> mIncludeCache; // Normalized lines by canonical path
+        std::unordered_map<std::string, Macro> mMacros; // By upper case name
+        std::unordered_map<std::string, std::string> mConstants;
+        std::vector<std::string> mIncludeStack;
+        u32 mExpansionCount = 0; // Replaces \@ so labels in macro bodies stay unique
+    };
+
+}
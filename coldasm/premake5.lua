@@ -23,6 +23,8 @@ project "coldasm"
 
     files {
         "src/**.cpp",
+        "../coldemu/src/ControlFlowGraph.cpp",
+        "../coldemu/src/Executable.cpp",
     }
 
     flags {
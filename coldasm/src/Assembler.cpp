@@ -34,18 +34,29 @@ std::vector<u8> coldasm::Assembler::assemble(const AssemblySource& source) {
     std::vector<u8> out;
 
     for (const auto& line : source.getLines()) {
-        const std::string mnemonic = line.substr(0, line.find(' '));
+        this->compileLine(out, line);
+    }
 
-        const auto it = sAssemblerFuncs.find(toUpper(mnemonic));
-        if (it == sAssemblerFuncs.end()) {
-            throw std::runtime_error("Unknown mnemonic: " + mnemonic);
-        }
+    return out;
+}
+
+cold::Instruction coldasm::Assembler::assembleInstruction(const std::string& line) {
+    std::vector<u8> out;
+    this->compileLine(out, line);
+
+    return cold::Instruction::fromBigEndian(out.data());
+}
+
+void coldasm::Assembler::compileLine(std::vector<u8>& out, const std::string& line) {
+    const std::string mnemonic = line.substr(0, line.find(' '));
 
-        const auto [_, func] = *it;
-        (this->*func)(out, ParameterStream{ line });
+    const auto it = sAssemblerFuncs.find(toUpper(mnemonic));
+    if (it == sAssemblerFuncs.end()) {
+        throw std::runtime_error("Unknown mnemonic: " + mnemonic);
     }
 
-    return out;
+    const auto [_, func] = *it;
+    (this->*func)(out, ParameterStream{ line });
 }
 
 const std::unordered_map<std::string, coldasm::Assembler::AssemblerFunc> coldasm::Assembler::sAssemblerFuncs = {
@@ -192,7 +203,17 @@ void coldasm::Assembler::compileSYSCALL(std::vector<u8>& out, ParameterStream li
         { "HALT", cold::Instruction::SyscallType::HALT },
         { "QMB", cold::Instruction::SyscallType::QMB },
         { "IPRINT", cold::Instruction::SyscallType::IPRINT },
-        { "FPRINT", cold::Instruction::SyscallType::FPRINT }
+        { "FPRINT", cold::Instruction::SyscallType::FPRINT },
+        { "ALLOC", cold::Instruction::SyscallType::ALLOC },
+        { "FREE", cold::Instruction::SyscallType::FREE },
+        { "REALLOC", cold::Instruction::SyscallType::REALLOC },
+        { "OPEN", cold::Instruction::SyscallType::OPEN },
+        { "READ", cold::Instruction::SyscallType::READ },
+        { "WRITE", cold::Instruction::SyscallType::WRITE },
+        { "CLOSE", cold::Instruction::SyscallType::CLOSE },
+        { "MMAP", cold::Instruction::SyscallType::MMAP },
+        { "GROW", cold::Instruction::SyscallType::GROW },
+        { "PRINTS", cold::Instruction::SyscallType::PRINTS }
     };
 
     const cold::Instruction::SyscallType type = syscallTypes.find(line.getStringParam())->second;
@@ -204,6 +225,13 @@ void coldasm::Assembler::compileSYSCALL(std::vector<u8>& out, ParameterStream li
         case cold::Instruction::SyscallType::QMB:
         case cold::Instruction::SyscallType::IPRINT:
         case cold::Instruction::SyscallType::FPRINT:
+        case cold::Instruction::SyscallType::FREE:
+        case cold::Instruction::SyscallType::OPEN:
+        case cold::Instruction::SyscallType::READ:
+        case cold::Instruction::SyscallType::WRITE:
+        case cold::Instruction::SyscallType::CLOSE:
+        case cold::Instruction::SyscallType::MMAP:
+        case cold::Instruction::SyscallType::GROW:
         case cold::Instruction::SyscallType::PRINT: {
             s32 reg = line.getRegisterParam();
 
@@ -213,6 +241,18 @@ void coldasm::Assembler::compileSYSCALL(std::vector<u8>& out, ParameterStream li
             break;
         }
 
+        case cold::Instruction::SyscallType::ALLOC:
+        case cold::Instruction::SyscallType::REALLOC:
+        case cold::Instruction::SyscallType::PRINTS: {
+            s32 reg = line.getRegisterParam();
+            s32 sizeReg = line.getRegisterParam();
+
+            out << (u8)reg;
+            out << (u8)sizeReg;
+
+            break;
+        }
+
         case cold::Instruction::SyscallType::HALT: {
             out << '\0' << '\0';
 
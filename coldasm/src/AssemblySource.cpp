@@ -1,141 +1,431 @@
 #include "Cold/Assembly/AssemblySource.h"
+#include "Cold/Assembly/Assembler.h"
+#include "Cold/Assembly/ConstantMaterializer.h"
+#include "Cold/Assembly/ParameterStream.h"
+#include "Cold/Assembly/Preprocessor.h"
+
+#include "Cold/Instruction.h"
 
 #include <algorithm>
+#include <bit>
+#include <cctype>
+#include <ranges>
+#include <stdexcept>
 
 namespace coldasm = cold::assembly;
 
-coldasm::AssemblySource::AssemblySource(const std::string& sourceCode)
-    : mLines()
-{
-    std::stringstream codeStream(sourceCode);
+namespace {
+
+    // Calling convention of .func: r0 is the stack pointer, r1 is scratch for the prologue and epilogue, r14 to r31 survive calls
+    constexpr u32 cFirstCalleeSaved = 14;
+    constexpr u32 cLastCalleeSaved = 31;
+
+    std::string toUpper(const std::string& str) {
+        const auto strRange = str | std::views::transform([](const unsigned char c) { return (char)std::toupper(c); });
+        return std::string(strRange.begin(), strRange.end());
+    }
+
+    std::string trim(const std::string& str) {
+        const std::size_t begin = str.find_first_not_of(' ');
+        if (begin == std::string::npos) {
+            return {};
+        }
+
+        return str.substr(begin, str.find_last_not_of(' ') - begin + 1);
+    }
+
+    bool isLabelName(const std::string& str) {
+        return !str.empty() && (std::isalpha(static_cast<unsigned char>(str[0])) || str[0] == '_');
+    }
 
-    for (std::string line; std::getline(codeStream, line);) {
-        mLines.push_back(line);
+    void appendWord(std::vector<u8>& data, const u32 word) {
+        data.push_back(static_cast<u8>(word >> 24));
+        data.push_back(static_cast<u8>(word >> 16));
+        data.push_back(static_cast<u8>(word >> 8));
+        data.push_back(static_cast<u8>(word));
     }
 
+}
+
+coldasm::AssemblySource::AssemblySource(const std::string& sourceCode, Preprocessor* preprocessor, const std::filesystem::path& directory)
+    : mLines()
+    , mLabels()
+    , mEntryLabel()
+    , mEntry(0)
+    , mData()
+    , mDataLabels()
+    , mDataReferences()
+    , mDataAddress(0)
+{
+    Preprocessor localPreprocessor;
+    mLines = (preprocessor != nullptr ? *preprocessor : localPreprocessor).process(Preprocessor::normalize(sourceCode), directory);
+
     this->preprocess();
 }
 
 void coldasm::AssemblySource::preprocess() {
-    // Remove empty lines and comments
+    // Directives produce no instructions
+    for (auto it = mLines.begin(); it != mLines.end(); ) {
+        if (toUpper(it->substr(0, it->find(' '))) == ".ENTRY") {
+            mEntryLabel = it->substr(it->find(' ') + 1);
+            it = mLines.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    this->expandFunctions();
+    this->collectData();
+
+    // Pseudo-instructions can expand to several instructions, so they must be gone before branch offsets are computed.
+    // Data follows the code, and larger data addresses can need longer LI sequences, so expand until the address holds
+    const std::vector<std::string> unexpanded = mLines;
+    this->expandPseudoInstructions();
+
+    while (true) {
+        const std::size_t instructionCount = std::count_if(mLines.begin(), mLines.end(), [](const std::string& line) {
+            return line.back() != ':';
+        });
+
+        const u32 codeEnd = static_cast<u32>(instructionCount * sizeof(cold::Instruction));
+        if (codeEnd <= mDataAddress) {
+            break;
+        }
+
+        mDataAddress = codeEnd;
+        mLines = unexpanded;
+        this->expandPseudoInstructions();
+    }
+
+    for (const DataReference& reference : mDataReferences) {
+        const u32 address = this->getDataLabelAddress(reference.label);
+        for (u32 i = 0; i < 4; i++) {
+            mData[reference.offset + i] = static_cast<u8>(address >> (24 - 8 * i));
+        }
+    }
+
+    this->collectLabels();
+
+    // Resolve labels into offsets from the branch, numeric operands are already offsets
+    u32 pc = 0;
+    for (std::string& line : mLines) {
+        if (line.back() == ':') {
+            continue;
+        }
+
+        if (line[0] == 'B') {
+            // Ignore branch to link register (ends with 'LR')
+            // Get the mnemonic of the branch instruction (string before space)
+            const std::string mnemonic = line.substr(0, line.find(' '));
+            if (mnemonic.back() == 'R' && mnemonic[mnemonic.size() - 2] == 'L') {
+                pc++;
+                continue;
+            }
+
+            // Find the label the branch instruction wants to go to (string after space)
+            const std::string label = line.substr(line.find(' ') + 1);
+            const bool numeric = label.find_first_not_of("-0123456789") == std::string::npos;
+
+            if (!numeric) {
+                const auto labelIt = std::find_if(mLabels.begin(), mLabels.end(), [&label](const Label& candidate) {
+                    return candidate.name == label;
+                });
+
+                if (labelIt == mLabels.end()) {
+                    throw std::runtime_error("Could not find label: " + label);
+                }
+
+                // Replace the label with the offset
+                line = mnemonic + " " + std::to_string(static_cast<s64>(labelIt->pc) - pc);
+            }
+        }
+
+        pc++;
+    }
+
+    // Strip labels
     std::erase_if(mLines, [](const std::string& line) {
-        return line.empty() || line[0] == '#';
+        return line.back() == ':';
     });
+}
+
+void coldasm::AssemblySource::expandFunctions() {
+    std::vector<std::string> lines;
+    Assembler assembler;
 
-    // Split lines that contain semi-colons into multiple lines
     for (auto it = mLines.begin(); it != mLines.end(); ++it) {
-        auto& line = *it;
+        const std::size_t space = it->find(' ');
+        const std::string directive = toUpper(it->substr(0, space));
 
-        const size_t numSemicolons = std::count(line.begin(), line.end(), ';');
+        if (directive == ".ENDFUNC") {
+            throw std::runtime_error("Unexpected .endfunc");
+        }
 
-        if (numSemicolons == 0) {
+        if (directive != ".FUNC") {
+            lines.push_back(*it);
             continue;
         }
 
-        std::vector<std::string> newLines(numSemicolons + 1);
+        const std::string name = space == std::string::npos ? std::string() : trim(it->substr(space + 1));
+        if (name.empty()) {
+            throw std::runtime_error("Expected function name");
+        }
+
+        const auto end = std::find_if(it + 1, mLines.end(), [](const std::string& line) {
+            const std::string mnemonic = toUpper(line.substr(0, line.find(' ')));
+            return mnemonic == ".ENDFUNC" || mnemonic == ".FUNC";
+        });
+
+        if (end == mLines.end() || toUpper(end->substr(0, end->find(' '))) != ".ENDFUNC") {
+            throw std::runtime_error("Missing .endfunc for function: " + name);
+        }
+
+        // Find the registers the body writes and whether it needs the link register preserved
+        bool calls = false;
+        u32 written = 0;
+        for (auto line = it + 1; line != end; ++line) {
+            const std::string mnemonic = toUpper(line->substr(0, line->find(' ')));
+
+            if (line->back() == ':' || mnemonic[0] == '.') {
+                continue;
+            }
+
+            if (mnemonic == "LI") {
+                written |= 1u << ParameterStream{ *line }.getRegisterParam();
+            } else if (mnemonic[0] == 'B') {
+                // BL and its conditional forms end with L, returns end with LR
+                calls |= mnemonic.back() == 'L';
+            } else {
+                const cold::Instruction instr = assembler.assembleInstruction(*line);
+                calls |= instr.getType() == static_cast<u8>(cold::Instruction::Type::MTLR);
+
+                if (const std::optional<u8> outReg = instr.getOutputRegister()) {
+                    written |= 1u << *outReg;
+                }
+            }
+        }
+
+        std::vector<std::string> saved;
+        for (u32 reg = cFirstCalleeSaved; reg <= cLastCalleeSaved; reg++) {
+            if (written & 1u << reg) {
+                saved.push_back("r" + std::to_string(reg));
+            }
+        }
+
+        // Leaf functions that only touch scratch registers need no frame at all
+        const bool frame = calls || !saved.empty();
+        const std::string frameSize = std::to_string(4 * (saved.size() + (calls ? 1 : 0)));
+        const u32 firstSlot = calls ? 4 : 0;
 
-        std::size_t pos = 0;
-        for (std::size_t i = 0; i < numSemicolons; ++i) {
-            const std::size_t nextPos = line.find(';', pos);
-            newLines[i] = line.substr(pos, nextPos - pos);
-            pos = nextPos + 1;
+        std::vector<std::string> epilogue;
+        for (std::size_t i = saved.size(); i-- > 0;) {
+            epilogue.push_back("LDW " + saved[i] + ", r0, " + std::to_string(firstSlot + 4 * i));
         }
 
-        newLines[numSemicolons] = line.substr(pos);
+        if (calls) {
+            epilogue.insert(epilogue.end(), { "LDW r1, r0, 0", "MTLR r1" });
+        }
+
+        epilogue.push_back("ADDI r0, r0, " + frameSize);
+
+        lines.push_back(name + ":");
+
+        if (frame) {
+            lines.push_back("SUBI r0, r0, " + frameSize);
 
-        // Replace the old line with the first new line
-        *it = newLines[0];
+            if (calls) {
+                lines.insert(lines.end(), { "MFLR r1", "STW r1, r0, 0" });
+            }
 
-        // Insert the remaining new lines after the current line
-        it = mLines.insert(it + 1, newLines.begin() + 1, newLines.end());
+            for (std::size_t i = 0; i < saved.size(); i++) {
+                lines.push_back("STW " + saved[i] + ", r0, " + std::to_string(firstSlot + 4 * i));
+            }
+        }
+
+        // Returns restore the frame first, conditional ones branch to a shared copy of the epilogue
+        bool sharedEpilogue = false;
+        for (auto line = it + 1; line != end; ++line) {
+            const std::string mnemonic = toUpper(line->substr(0, line->find(' ')));
+
+            if (frame && mnemonic == "BLR") {
+                lines.insert(lines.end(), epilogue.begin(), epilogue.end());
+                lines.push_back(*line);
+            } else if (frame && mnemonic[0] == 'B' && mnemonic.ends_with("LR")) {
+                lines.push_back(mnemonic.substr(0, mnemonic.size() - 2) + " " + name + ".return");
+                sharedEpilogue = true;
+            } else {
+                lines.push_back(*line);
+            }
+        }
+
+        if (sharedEpilogue) {
+            lines.push_back(name + ".return:");
+            lines.insert(lines.end(), epilogue.begin(), epilogue.end());
+            lines.push_back("BLR");
+        }
+
+        it = end;
     }
 
-    // Remove spaces at the start of lines, and also remove double spaces
-    for (auto& line : mLines) {
-        std::size_t pos = 0;
-        while (line[pos] == ' ') {
-            ++pos;
+    mLines = std::move(lines);
+}
+
+void coldasm::AssemblySource::collectData() {
+    std::vector<std::string> code;
+    std::vector<std::string> labels; // Labels belong to whatever follows them, code or data
+
+    for (const std::string& line : mLines) {
+        if (line.back() == ':') {
+            labels.push_back(line);
+            continue;
         }
 
-        line = line.substr(pos);
+        const std::size_t space = line.find(' ');
+        const std::string mnemonic = toUpper(line.substr(0, space));
 
-        pos = 0;
-        while ((pos = line.find("  ", pos)) != std::string::npos) {
-            line.erase(pos, 1);
+        if (mnemonic[0] != '.') {
+            code.insert(code.end(), labels.begin(), labels.end());
+            code.push_back(line);
+            labels.clear();
+            continue;
+        }
+
+        for (const std::string& label : labels) {
+            mDataLabels.push_back({ .name = label.substr(0, label.size() - 1), .offset = static_cast<u32>(mData.size()) });
         }
+
+        labels.clear();
+        this->emitData(mnemonic, space == std::string::npos ? std::string() : line.substr(space + 1));
     }
 
-    // Resolve labels
-    for (auto it = mLines.begin(); it != mLines.end(); ++it) {
-        if ((*it)[0] == 'B') {
-            // Ignore branch to link register (ends with 'LR')
-            // Get the mnemonic of the branch instruction (string before space)
-            const std::string mnemonic = it->substr(0, it->find(' '));
-            if (mnemonic.back() == 'R' && mnemonic[mnemonic.size() - 2] == 'L') {
+    // Trailing labels point past the last instruction
+    code.insert(code.end(), labels.begin(), labels.end());
+    mLines = std::move(code);
+}
+
+void coldasm::AssemblySource::emitData(const std::string& directive, const std::string& operands) {
+    if (directive == ".ASCII") {
+        const std::string str = trim(operands);
+        if (str.size() < 2 || str.front() != '"' || str.back() != '"') {
+            throw std::runtime_error("Expected string literal: " + str);
+        }
+
+        for (std::size_t i = 1; i + 1 < str.size(); i++) {
+            if (str[i] != '\\') {
+                mData.push_back(static_cast<u8>(str[i]));
                 continue;
             }
 
-            // Find the label the branch instruction wants to go to (string after space)
-            const std::string label = it->substr(it->find(' ') + 1);
+            switch (str[++i]) {
+                case 'n': mData.push_back('\n'); break;
+                case 't': mData.push_back('\t'); break;
+                case 'r': mData.push_back('\r'); break;
+                case '0': mData.push_back('\0'); break;
+                case '\\': mData.push_back('\\'); break;
+                case '"': mData.push_back('"'); break;
+                case '\'': mData.push_back('\''); break;
+                default: throw std::runtime_error("Invalid escape sequence: " + str);
+            }
+        }
 
-            // Find the line with the label
-            const auto labelIt = std::find_if(mLines.begin(), mLines.end(), [&label](const std::string& line) {
-                return line.substr(0, line.find(' ')) == label + ':';
-            });
+        return;
+    }
 
-            if (labelIt == mLines.end()) {
-                throw std::runtime_error("Could not find label: " + label);
-            }
+    // Every other directive takes a comma separated list
+    std::vector<std::string> values;
+    for (std::size_t begin = 0; begin <= operands.size(); ) {
+        std::size_t end = Preprocessor::findUnquoted(operands, ',', begin);
+        if (end == std::string::npos) {
+            end = operands.size();
+        }
 
-            // Calculate the offset from the branch instruction to the label
-            const std::ptrdiff_t offset = std::distance(it, labelIt);
-            s64 jump = 0;
+        values.push_back(trim(operands.substr(begin, end - begin)));
+        begin = end + 1;
+    }
 
-            // Subtract number of labels between the branch instruction and the label
-            {
-                const auto first = std::min(it, labelIt);
-                const auto last = std::max(it, labelIt);
+    for (const std::string& value : values) {
+        if (value.empty()) {
+            throw std::runtime_error("Expected operand for " + directive);
+        }
 
-                const std::size_t numLabels = std::count_if(first, last, [](const std::string& line) {
-                    return line.back() == ':';
-                });
+        if (directive == ".BYTE") {
+            const u32 byte = ParameterStream{ value }.getLargeImmediateParam();
+            if (byte > 0xFF && byte < 0xFFFFFF80) {
+                throw std::runtime_error("Byte does not fit in 8 bits: " + value);
+            }
 
-                jump -= numLabels;
+            mData.push_back(static_cast<u8>(byte));
+        } else if (directive == ".WORD") {
+            if (isLabelName(value)) {
+                mDataReferences.push_back({ .offset = static_cast<u32>(mData.size()), .label = value });
+                appendWord(mData, 0);
+            } else {
+                appendWord(mData, ParameterStream{ value }.getLargeImmediateParam());
             }
+        } else if (directive == ".FLOAT") {
+            appendWord(mData, std::bit_cast<u32>(std::stof(value)));
+        } else if (directive == ".SPACE") {
+            mData.resize(mData.size() + ParameterStream{ value }.getLargeImmediateParam());
+        } else {
+            throw std::runtime_error("Unknown directive: " + directive);
+        }
+    }
+}
 
-            if (offset > 0) {
-                for (auto checkerIt = it; checkerIt != labelIt; checkerIt++) {
-                    const std::string& checkerLine = *checkerIt;
+void coldasm::AssemblySource::collectLabels() {
+    u32 pc = 0;
 
-                    // If the line ends with a colon, it's a label, so skip it
-                    if (checkerLine.back() == ':') {
-                        continue;
-                    }
+    for (const std::string& line : mLines) {
+        if (line.back() == ':') {
+            mLabels.push_back({ .name = line.substr(0, line.size() - 1), .pc = pc });
+        } else {
+            pc++;
+        }
+    }
 
-                    jump++;
-                }
-            } else {
-                for (auto checkerIt = it; checkerIt != labelIt; checkerIt--) {
-                    const std::string& checkerLine = *checkerIt;
+    if (mEntryLabel.has_value()) {
+        const auto label = std::find_if(mLabels.begin(), mLabels.end(), [this](const Label& candidate) {
+            return candidate.name == *mEntryLabel;
+        });
 
-                    // If the line ends with a colon, it's a label, so skip it
-                    if (checkerLine.back() == ':') {
-                        continue;
-                    }
+        if (label == mLabels.end()) {
+            throw std::runtime_error("Could not find entry label: " + *mEntryLabel);
+        }
 
-                    jump--;
-                }
+        mEntry = label->pc;
+    }
+}
 
-                jump += 2; // The branch instruction itself is not included in the offset
-            }
+void coldasm::AssemblySource::expandPseudoInstructions() {
+    for (auto it = mLines.begin(); it != mLines.end(); ++it) {
+        const std::string mnemonic = toUpper(it->substr(0, it->find(' ')));
+
+        if (mnemonic == "LI") {
+            // LI rX, <32-bit integer or float literal>
+            ParameterStream params{ *it };
+            const u8 reg = static_cast<u8>(params.getRegisterParam());
+
+            // Data labels load their address
+            const std::string operand = trim(it->substr(it->find(',') + 1));
+            const u32 value = isLabelName(operand) ? this->getDataLabelAddress(operand) : params.getLargeImmediateParam();
 
-            // Replace the label with the offset
-            *it = it->substr(0, it->find(' ')) + " " + std::to_string(jump);
+            const std::vector<std::string> sequence = ConstantMaterializer::materialize(reg, value);
+
+            *it = sequence[0];
+            it = mLines.insert(it + 1, sequence.begin() + 1, sequence.end());
+            it += static_cast<std::ptrdiff_t>(sequence.size()) - 2;
         }
     }
+}
 
-    // Strip labels
-    std::erase_if(mLines, [](const std::string& line) {
-        return line.back() == ':';
+u32 coldasm::AssemblySource::getDataLabelAddress(const std::string& name) const {
+    const auto label = std::find_if(mDataLabels.begin(), mDataLabels.end(), [&name](const DataLabel& candidate) {
+        return candidate.name == name;
     });
+
+    if (label == mDataLabels.end()) {
+        throw std::runtime_error("Could not find data label: " + name);
+    }
+
+    return mDataAddress + label->offset;
 }
@@ -0,0 +1,93 @@
+#include "Cold/Assembly/ConstantMaterializer.h"
+
+#include <bit>
+
+namespace coldasm = cold::assembly;
+
+std::vector<std::string> coldasm::ConstantMaterializer::materialize(const u8 reg, const u32 value) {
+    u32 base = value;
+    std::vector<Step> steps;
+
+    bool found = false;
+    for (u32 depth = 0; depth <= cMaxSearchDepth && !found; depth++) {
+        steps.clear();
+        found = search(value, depth, Operation::ORI, base, steps);
+    }
+
+    if (!found) {
+        // Every constant can be built from its upper half and two bytes
+        base = value >> 16;
+        steps = {
+            { Operation::SHIFTL, 8 },
+            { Operation::ORI, value >> 8 & 0xFF },
+            { Operation::SHIFTL, 8 },
+            { Operation::ORI, value & 0xFF }
+        };
+    }
+
+    const std::string r = "r" + std::to_string((u32)reg);
+
+    std::vector<std::string> lines = { "SETI " + r + ", " + std::to_string(base) };
+    for (const auto& step : steps) {
+        switch (step.operation) {
+            case Operation::NOT: lines.push_back("NOT " + r + ", " + r); break;
+            case Operation::SHIFTL: lines.push_back("SHIFTL " + r + ", " + r + ", " + std::to_string(step.imm)); break;
+            case Operation::ORI: lines.push_back("ORI " + r + ", " + r + ", " + std::to_string(step.imm)); break;
+            case Operation::ADDI: lines.push_back("ADDI " + r + ", " + r + ", " + std::to_string(step.imm)); break;
+            case Operation::SUBI: lines.push_back("SUBI " + r + ", " + r + ", " + std::to_string(step.imm)); break;
+        }
+    }
+
+    return lines;
+}
+
+bool coldasm::ConstantMaterializer::search(const u32 value, const u32 depth, const Operation previous, u32& base, std::vector<Step>& steps) {
+    // Works backwards from the value, undoing the last instruction of the sequence until a SETI immediate remains
+    if (value <= 0xFFFF) {
+        base = value;
+        return true;
+    }
+
+    if (depth == 0) {
+        return false;
+    }
+
+    const auto attempt = [&](const u32 previousValue, const Operation operation, const u32 imm) {
+        if (search(previousValue, depth - 1, operation, base, steps)) {
+            steps.push_back({ operation, imm });
+            return true;
+        }
+
+        return false;
+    };
+
+    if (previous != Operation::NOT && attempt(~value, Operation::NOT, 0)) {
+        return true;
+    }
+
+    // Consecutive shifts would have been merged, bits shifted out may have been zeros or ones
+    if (previous != Operation::SHIFTL) {
+        const u32 trailingZeros = static_cast<u32>(std::countr_zero(value));
+
+        for (u32 shift = trailingZeros; shift > 0; shift--) {
+            if (attempt(value >> shift, Operation::SHIFTL, shift) || attempt(value >> shift | ~0u << (32 - shift), Operation::SHIFTL, shift)) {
+                return true;
+            }
+        }
+    }
+
+    if ((value & 0xFF) != 0 && attempt(value & ~0xFFu, Operation::ORI, value & 0xFF)) {
+        return true;
+    }
+
+    if (value - 0xFFFF <= 0xFF && attempt(0xFFFF, Operation::ADDI, value - 0xFFFF)) {
+        return true;
+    }
+
+    const u32 roundUp = (0x100 - (value & 0xFF)) & 0xFF;
+    if (roundUp != 0 && attempt(value + roundUp, Operation::SUBI, roundUp)) {
+        return true;
+    }
+
+    return false;
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <filesystem>
 #include <fstream>
 #include <string>
 
@@ -5,8 +7,43 @@
 
 #include "Cold/Assembly/AssemblySource.h"
 #include "Cold/Assembly/Assembler.h"
+#include "Cold/Assembly/Optimizer.h"
+#include "Cold/Assembly/Preprocessor.h"
+#include "Cold/ControlFlowGraph.h"
+#include "Cold/Executable.h"
 
-void assemble(const std::string& inputPath, const std::string& outputPath) {
+cold::Executable buildExecutable(const std::vector<u8>& binary, const cold::assembly::AssemblySource& source, const std::vector<u32>& labelPcs, const u32 entry) {
+    cold::Executable executable;
+
+    for (std::size_t i = 0; i + sizeof(cold::Instruction) <= binary.size(); i += sizeof(cold::Instruction)) {
+        executable.code.push_back(cold::Instruction::fromBigEndian(binary.data() + i));
+    }
+
+    // LI sequences already hold data addresses, so the data stays where the unoptimized code ended
+    executable.data = source.getData();
+    executable.dataAddress = source.getData().empty() ? static_cast<u32>(binary.size()) : source.getDataAddress();
+    executable.entry = entry;
+
+    for (std::size_t i = 0; i < labelPcs.size(); i++) {
+        executable.symbols.push_back({ .name = source.getLabels()[i].name, .value = labelPcs[i], .kind = cold::Executable::SymbolKind::Code });
+    }
+
+    for (const auto& label : source.getDataLabels()) {
+        executable.symbols.push_back({ .name = label.name, .value = source.getDataAddress() + label.offset, .kind = cold::Executable::SymbolKind::Data });
+    }
+
+    // Saves coldaot from building the control flow graph again
+    const cold::ControlFlowGraph cfg(executable.code);
+    for (const auto& block : cfg.getBlocks()) {
+        executable.blockStarts.push_back(block.begin);
+    }
+
+    std::sort(executable.blockStarts.begin(), executable.blockStarts.end());
+
+    return executable;
+}
+
+void assemble(const std::string& inputPath, const std::string& outputPath, const u32 optimizationLevel, const bool raw) {
     std::ifstream inputFile(inputPath);
     if (!inputFile.is_open()) {
         throw std::runtime_error("Failed to open input file");
@@ -14,9 +51,40 @@ void assemble(const std::string& inputPath, const std::string& outputPath) {
 
     const std::string sourceCode{ std::istreambuf_iterator<char>(inputFile), {} };
 
-    cold::assembly::AssemblySource assemblySource(sourceCode);
+    // Includes are found next to the input
+    cold::assembly::Preprocessor preprocessor;
+    cold::assembly::AssemblySource assemblySource(sourceCode, &preprocessor, std::filesystem::path(inputPath).parent_path());
     cold::assembly::Assembler assembler;
-    const std::vector<u8> binary = assembler.assemble(assemblySource);
+    std::vector<u8> binary = assembler.assemble(assemblySource);
+
+    // The entry point rides along with the labels through the optimizer
+    std::vector<u32> labelPcs;
+    for (const auto& label : assemblySource.getLabels()) {
+        labelPcs.push_back(label.pc);
+    }
+
+    labelPcs.push_back(assemblySource.getEntry());
+
+    if (optimizationLevel > 0) {
+        cold::assembly::Optimizer optimizer;
+        optimizer.setInlining(optimizationLevel >= 2);
+        binary = optimizer.optimize(binary, &labelPcs);
+    }
+
+    const u32 entry = labelPcs.back();
+    labelPcs.pop_back();
+
+    if (raw && entry != 0) {
+        throw std::runtime_error("Raw images always start at the first instruction");
+    }
+
+    if (raw && !assemblySource.getData().empty()) {
+        throw std::runtime_error("Raw images cannot hold initialized data");
+    }
+
+    if (!raw) {
+        binary = buildExecutable(binary, assemblySource, labelPcs, entry).serialize();
+    }
 
     std::ofstream outputFile(outputPath, std::ios::binary);
     if (!outputFile.is_open()) {
@@ -38,6 +106,21 @@ int main(int argc, char** argv) {
         .help("output file")
         .required();
 
+    args.add_argument("-O", "--optimize")
+        .help("run the peephole optimizer")
+        .default_value(false)
+        .implicit_value(true);
+
+    args.add_argument("-O2", "--inline")
+        .help("also inline small leaf functions at their call sites")
+        .default_value(false)
+        .implicit_value(true);
+
+    args.add_argument("--raw")
+        .help("write a bare instruction image instead of an executable container")
+        .default_value(false)
+        .implicit_value(true);
+
     try {
         args.parse_args(argc, argv);
     } catch (const std::exception& e) {
@@ -48,9 +131,11 @@ int main(int argc, char** argv) {
 
     const std::string inputPath = args.get<std::string>("--input");
     const std::string outputPath = args.get<std::string>("--output");
+    const u32 optimizationLevel = args.get<bool>("--inline") ? 2 : args.get<bool>("--optimize") ? 1 : 0;
+    const bool raw = args.get<bool>("--raw");
 
     try {
-        assemble(inputPath, outputPath);
+        assemble(inputPath, outputPath, optimizationLevel, raw);
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
         return 1;
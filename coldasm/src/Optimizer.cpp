@@ -0,0 +1,466 @@
+#include "Cold/Assembly/Optimizer.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace coldasm = cold::assembly;
+
+namespace {
+
+    using Type = cold::Instruction::Type;
+
+    cold::Instruction makeInstruction(const Type type, const u8 byte1, const u8 byte2, const u8 byte3) {
+        cold::Instruction instr;
+        instr.setData((u32)type << 24 | (u32)byte1 << 16 | (u32)byte2 << 8 | byte3);
+        return instr;
+    }
+
+    // Instructions whose only effect is writing their output register
+    bool isPureWrite(const cold::Instruction& instr) {
+        switch (Type(instr.getType())) {
+            case Type::SETI:
+            case Type::ADD: case Type::ADDI:
+            case Type::SUB: case Type::SUBI:
+            case Type::MUL: case Type::MULI:
+            case Type::AND: case Type::ANDI:
+            case Type::OR: case Type::ORI:
+            case Type::XOR: case Type::XORI:
+            case Type::NOT:
+            case Type::SHIFTL: case Type::SHIFTR:
+            case Type::FADD: case Type::FSUB: case Type::FMUL: case Type::FDIV:
+            case Type::MFLR:
+            case Type::SET:
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+    u32 storeWidth(const Type type) {
+        switch (type) {
+            case Type::STB: return 1;
+            case Type::STH: return 2;
+            case Type::STW: return 4;
+            default: return 0;
+        }
+    }
+
+}
+
+std::vector<u8> coldasm::Optimizer::optimize(const std::vector<u8>& binary, std::vector<u32>* labels) {
+    mLabels = labels;
+
+    std::vector<Entry> program;
+    program.reserve(binary.size() / sizeof(cold::Instruction));
+
+    // Instructions are stored big endian
+    for (std::size_t i = 0; i + 3 < binary.size(); i += 4) {
+        cold::Instruction instr;
+        instr.setData((u32)binary[i] << 24 | (u32)binary[i + 1] << 16 | (u32)binary[i + 2] << 8 | binary[i + 3]);
+
+        const s64 pc = static_cast<s64>(program.size());
+        program.push_back({ .instr = instr, .target = instr.isRelativeBranch() ? pc + instr.getS24Data() : 0, .removed = false });
+    }
+
+    if (mInlining) {
+        this->inlineLeafCalls(program);
+    }
+
+    // Inlined bodies often leave moves and reloads the peephole passes can remove
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        changed |= this->removeRedundantMoves(program);
+        changed |= this->removeOverwrittenWrites(program);
+        this->compact(program);
+
+        // Forwarding is only valid within a basic block. Leaders come from the resolved targets since the
+        // instruction words still hold the offsets from before compaction and inlining
+        std::vector<bool> leaders(program.size(), false);
+        if (!leaders.empty()) {
+            leaders[0] = true;
+        }
+
+        for (std::size_t pc = 0; pc < program.size(); pc++) {
+            const Entry& entry = program[pc];
+            if (entry.instr.isRelativeBranch() && entry.target >= 0 && entry.target < (s64)program.size()) {
+                leaders[entry.target] = true;
+            }
+
+            if ((entry.instr.isBranch() || entry.instr.isHalt()) && pc + 1 < program.size()) {
+                leaders[pc + 1] = true;
+            }
+        }
+
+        changed |= this->forwardStoresToLoads(program, leaders);
+        this->compact(program);
+    }
+
+    std::vector<u8> out;
+    out.reserve(program.size() * sizeof(cold::Instruction));
+
+    for (std::size_t pc = 0; pc < program.size(); pc++) {
+        u32 data = program[pc].instr.getData();
+
+        if (program[pc].instr.isRelativeBranch()) {
+            const s64 offset = program[pc].target - (s64)pc;
+            if (offset < -0x800000 || offset > 0x7FFFFF) [[unlikely]] {
+                throw std::runtime_error("Branch offset out of range after optimization");
+            }
+
+            data = (data & 0xFF000000) | ((u32)offset & 0xFFFFFF);
+        }
+
+        out.push_back(data >> 24 & 0xFF);
+        out.push_back(data >> 16 & 0xFF);
+        out.push_back(data >> 8 & 0xFF);
+        out.push_back(data & 0xFF);
+    }
+
+    return out;
+}
+
+bool coldasm::Optimizer::removeRedundantMoves(std::vector<Entry>& program) {
+    bool changed = false;
+
+    for (auto& entry : program) {
+        const auto [outReg, inReg, value] = entry.instr.getTripleByteData();
+        const Type type = Type(entry.instr.getType());
+
+        bool identity = false;
+        switch (type) {
+            case Type::SET:
+                identity = true;
+                break;
+
+            case Type::ADDI: case Type::SUBI:
+            case Type::ORI: case Type::XORI:
+            case Type::SHIFTL: case Type::SHIFTR:
+                identity = value == 0;
+                break;
+
+            case Type::MULI:
+                identity = value == 1;
+                break;
+
+            default:
+                break;
+        }
+
+        if (!identity) {
+            continue;
+        }
+
+        if (outReg == inReg) {
+            // SET rX, rX and friends do nothing
+            entry.removed = true;
+        } else if (type != Type::SET) {
+            // ADDI rX, rY, 0 and friends are plain moves
+            entry.instr = makeInstruction(Type::SET, outReg, inReg, 0);
+        } else {
+            continue;
+        }
+
+        changed = true;
+    }
+
+    return changed;
+}
+
+bool coldasm::Optimizer::removeOverwrittenWrites(std::vector<Entry>& program) {
+    bool changed = false;
+
+    for (std::size_t i = 0; i + 1 < program.size(); i++) {
+        const cold::Instruction& current = program[i].instr;
+        const cold::Instruction& next = program[i + 1].instr;
+
+        if (program[i].removed || program[i + 1].removed || !isPureWrite(current)) {
+            continue;
+        }
+
+        // The next instruction always executes after this one, so if it overwrites the result without reading it, the write is dead
+        const std::optional<u8> outReg = current.getOutputRegister();
+        if (next.getOutputRegister() == outReg && !(next.getInputRegisterMask() & (1u << (*outReg & 0x1F)))) {
+            program[i].removed = true;
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+bool coldasm::Optimizer::forwardStoresToLoads(std::vector<Entry>& program, const std::vector<bool>& leaders) {
+    struct Slot {
+        u8 addrReg;
+        s8 offset;
+        u8 valueReg;
+    };
+
+    std::vector<Slot> slots; // Word slots whose value is known to be held in a register
+    bool changed = false;
+
+    const auto invalidateRegister = [&slots](const u8 reg) {
+        std::erase_if(slots, [reg](const Slot& slot) {
+            return slot.addrReg == reg || slot.valueReg == reg;
+        });
+    };
+
+    for (std::size_t pc = 0; pc < program.size(); pc++) {
+        if (leaders[pc]) {
+            slots.clear();
+        }
+
+        auto& entry = program[pc];
+        const Type type = Type(entry.instr.getType());
+        const auto [reg, addrReg, offsetUnsigned] = entry.instr.getTripleByteData();
+        const s8 offset = static_cast<s8>(offsetUnsigned);
+
+        if (type == Type::LDW) {
+            const auto it = std::find_if(slots.begin(), slots.end(), [&](const Slot& slot) {
+                return slot.addrReg == addrReg && slot.offset == offset;
+            });
+
+            if (it != slots.end()) {
+                const u8 valueReg = it->valueReg;
+
+                if (valueReg == reg) {
+                    entry.removed = true;
+                } else {
+                    entry.instr = makeInstruction(Type::SET, reg, valueReg, 0);
+                    invalidateRegister(reg);
+                }
+
+                changed = true;
+                continue;
+            }
+
+            invalidateRegister(reg);
+            if (reg != addrReg) {
+                slots.push_back({ .addrReg = addrReg, .offset = offset, .valueReg = reg });
+            }
+
+            continue;
+        }
+
+        if (const u32 width = storeWidth(type)) {
+            // Stores through another base register may alias anything
+            std::erase_if(slots, [&](const Slot& slot) {
+                return slot.addrReg != addrReg || (slot.offset < offset + (s32)width && offset < slot.offset + 4);
+            });
+
+            if (type == Type::STW) {
+                slots.push_back({ .addrReg = addrReg, .offset = offset, .valueReg = reg });
+            }
+
+            continue;
+        }
+
+        if (type == Type::SYSCALL) {
+            slots.clear();
+        }
+
+        if (const std::optional<u8> outReg = entry.instr.getOutputRegister()) {
+            invalidateRegister(*outReg);
+        }
+    }
+
+    return changed;
+}
+
+void coldasm::Optimizer::inlineLeafCalls(std::vector<Entry>& program) {
+    // Code may grow by half its size, small programs always get some room
+    const s64 budget = static_cast<s64>(program.size()) / 2 + cMaxInlineSize;
+    s64 growth = 0;
+
+    std::vector<Entry> result;
+    std::vector<bool> inlined; // Copied entries already hold targets in the new numbering
+    std::vector<s64> newIndex(program.size() + 1);
+
+    // An inlined call no longer sets lr, so the code after it must not read the value the BL left there
+    const std::vector<bool> liveLinks = findLiveLinks(program);
+
+    for (std::size_t i = 0; i < program.size(); i++) {
+        newIndex[i] = static_cast<s64>(result.size());
+
+        const Entry& call = program[i];
+        const bool candidate = Type(call.instr.getType()) == Type::BL && !liveLinks[i + 1];
+        const std::optional<s64> end = candidate ? findInlineEnd(program, call.target) : std::nullopt;
+
+        // The BL and the BLR both disappear
+        if (!end.has_value() || growth + (*end - call.target) - 1 > budget) {
+            result.push_back(call);
+            inlined.push_back(false);
+            continue;
+        }
+
+        const s64 base = static_cast<s64>(result.size());
+        const s64 after = base + (*end - call.target);
+
+        for (s64 j = call.target; j < *end; j++) {
+            Entry copy = program[j];
+            const Type type = Type(copy.instr.getType());
+
+            if (copy.instr.isReturnBranch()) {
+                // Conditional returns leave the inlined body instead
+                const Type branch = Type((u8)type - (u8)Type::BLR + (u8)Type::B);
+                copy.instr = makeInstruction(branch, 0, 0, 0);
+                copy.target = after;
+            } else if (copy.instr.isRelativeBranch()) {
+                copy.target = base + (copy.target - call.target);
+            }
+
+            result.push_back(copy);
+            inlined.push_back(true);
+        }
+
+        growth += (*end - call.target) - 1;
+        mInlinedCount++;
+    }
+
+    newIndex[program.size()] = static_cast<s64>(result.size());
+
+    for (std::size_t i = 0; i < result.size(); i++) {
+        Entry& entry = result[i];
+        if (inlined[i] || !entry.instr.isRelativeBranch()) {
+            continue;
+        }
+
+        // Branches out of the program keep their distance from it
+        if (entry.target > (s64)program.size()) {
+            entry.target = newIndex[program.size()] + (entry.target - (s64)program.size());
+        } else if (entry.target >= 0) {
+            entry.target = newIndex[entry.target];
+        }
+    }
+
+    if (mLabels != nullptr) {
+        for (u32& label : *mLabels) {
+            label = static_cast<u32>(newIndex[std::min<std::size_t>(label, program.size())]);
+        }
+    }
+
+    program = std::move(result);
+}
+
+std::optional<s64> coldasm::Optimizer::findInlineEnd(const std::vector<Entry>& program, const s64 entry) {
+    if (entry < 0) {
+        return std::nullopt;
+    }
+
+    // A leaf runs from its entry to the first BLR without touching the link register
+    std::optional<s64> end;
+    for (s64 pc = entry; pc < (s64)program.size() && pc - entry <= cMaxInlineSize; pc++) {
+        const cold::Instruction& instr = program[pc].instr;
+        const Type type = Type(instr.getType());
+
+        if (type == Type::BLR) {
+            end = pc;
+            break;
+        }
+
+        if (instr.isLinkBranch() || type == Type::MFLR || type == Type::MTLR) {
+            return std::nullopt;
+        }
+    }
+
+    if (!end.has_value()) {
+        return std::nullopt;
+    }
+
+    // Branches must stay inside the body, a branch to the BLR is a return
+    for (s64 pc = entry; pc < *end; pc++) {
+        if (program[pc].instr.isRelativeBranch() && (program[pc].target < entry || program[pc].target > *end)) {
+            return std::nullopt;
+        }
+    }
+
+    return end;
+}
+
+std::vector<bool> coldasm::Optimizer::findLiveLinks(const std::vector<Entry>& program) {
+    const s64 size = static_cast<s64>(program.size());
+
+    // Backward dataflow to a fixed point, running off the end finishes the program with lr dead
+    std::vector<bool> live(program.size() + 1, false);
+
+    const auto isLive = [&live, size](const s64 pc) {
+        return pc < 0 || pc > size || live[pc]; // Nothing is known about code outside the program
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        for (s64 pc = size - 1; pc >= 0; pc--) {
+            const Entry& entry = program[pc];
+            const Type type = Type(entry.instr.getType());
+
+            bool result;
+            if (type == Type::MFLR || entry.instr.isReturnBranch()) {
+                result = true;
+            } else if (type == Type::MTLR || type == Type::BL) {
+                result = false;
+            } else if (entry.instr.isLinkBranch()) {
+                // Taking the branch writes lr first
+                result = isLive(pc + 1);
+            } else if (entry.instr.isRelativeBranch()) {
+                result = isLive(entry.target) || (entry.instr.isConditionalBranch() && isLive(pc + 1));
+            } else {
+                result = isLive(pc + 1);
+            }
+
+            if (result && !live[pc]) {
+                live[pc] = true;
+                changed = true;
+            }
+        }
+    }
+
+    return live;
+}
+
+void coldasm::Optimizer::compact(std::vector<Entry>& program) {
+    // Map every old index (and the end) to its new index, removed instructions map to their successor
+    std::vector<s64> newIndex(program.size() + 1);
+    s64 next = 0;
+
+    for (std::size_t i = 0; i < program.size(); i++) {
+        newIndex[i] = next;
+        if (!program[i].removed) {
+            next++;
+        }
+    }
+    newIndex[program.size()] = next;
+
+    std::vector<Entry> result;
+    result.reserve(static_cast<std::size_t>(next));
+
+    for (std::size_t i = 0; i < program.size(); i++) {
+        Entry entry = program[i];
+
+        if (entry.removed) {
+            mRemovedCount++;
+            continue;
+        }
+
+        if (entry.instr.isRelativeBranch()) {
+            if (entry.target >= 0 && entry.target <= (s64)program.size()) {
+                entry.target = newIndex[entry.target];
+            } else {
+                entry.target = newIndex[i] + (entry.target - (s64)i);
+            }
+        }
+
+        result.push_back(entry);
+    }
+
+    if (mLabels != nullptr) {
+        for (u32& label : *mLabels) {
+            label = static_cast<u32>(newIndex[std::min<std::size_t>(label, program.size())]);
+        }
+    }
+
+    program = std::move(result);
+}
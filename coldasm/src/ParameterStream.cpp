@@ -1,6 +1,8 @@
 #include "Cold/Assembly/ParameterStream.h"
 #include "Cold/Processor.h"
 
+#include <bit>
+#include <limits>
 #include <ranges>
 #include <stdexcept>
 
@@ -108,17 +110,11 @@ s32 coldasm::ParameterStream::getImmediateParam() {
         // Negative literal
         if (imm[1] == '0' && imm[2] == 'x') {
             // Hexadecimal negative literal
-            char* literalNumbers = new char[imm.size() - 3];
-            std::copy(imm.begin() + 3, imm.end(), literalNumbers);
-            immVal = -std::stoi(literalNumbers, nullptr, 16);
-            delete[] literalNumbers;
+            immVal = -std::stoi(imm.substr(3), nullptr, 16);
         }
         else {
             // Decimal negative literal
-            char* literalNumbers = new char[imm.size() - 1];
-            std::copy(imm.begin() + 1, imm.end(), literalNumbers);
-            immVal = -std::stoi(literalNumbers, nullptr, 10);
-            delete[] literalNumbers;
+            immVal = -std::stoi(imm.substr(1), nullptr, 10);
         }
     }
     else {
@@ -131,3 +127,44 @@ s32 coldasm::ParameterStream::getImmediateParam() {
 
     return immVal;
 }
+
+u32 coldasm::ParameterStream::getLargeImmediateParam() {
+    const std::string remainder{ mRemainder };
+
+    const std::size_t immStart = remainder.find_first_of("-.0123456789\'");
+    if (immStart == std::string::npos) {
+        throw std::runtime_error("Expected immediate parameter");
+    }
+
+    // Character literals are never larger than a byte
+    if (remainder[immStart] == '\'') {
+        return static_cast<u32>(this->getImmediateParam());
+    }
+
+    std::size_t immEnd = remainder.find_first_of(" ,", immStart);
+    if (immEnd == std::string::npos) {
+        immEnd = remainder.size();
+    }
+
+    const std::string imm = remainder.substr(immStart, immEnd - immStart);
+    const bool hex = imm.find("0x") != std::string::npos;
+
+    u32 immVal = 0;
+    if (!hex && imm.find_first_of(".eEf") != std::string::npos) {
+        // Float literal, stored as its bit pattern
+        immVal = std::bit_cast<u32>(std::stof(imm));
+    } else {
+        const s64 value = std::stoll(imm, nullptr, hex ? 16 : 10);
+
+        if (value < std::numeric_limits<s32>::min() || value > std::numeric_limits<u32>::max()) {
+            throw std::runtime_error("Immediate does not fit in 32 bits: " + imm);
+        }
+
+        immVal = static_cast<u32>(value);
+    }
+
+    // Update remainder
+    mRemainder += immEnd;
+
+    return immVal;
+}
@@ -0,0 +1,402 @@
+#include "Cold/Assembly/Preprocessor.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <optional>
+#include <ranges>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+
+namespace coldasm = cold::assembly;
+
+namespace {
+
+    constexpr u32 cMaxDepth = 64; // Nested includes and macro expansions
+
+    std::string toUpper(const std::string& str) {
+        const auto strRange = str | std::views::transform([](const unsigned char c) { return (char)std::toupper(c); });
+        return std::string(strRange.begin(), strRange.end());
+    }
+
+    std::string trim(const std::string& str) {
+        const std::size_t begin = str.find_first_not_of(' ');
+        if (begin == std::string::npos) {
+            return {};
+        }
+
+        return str.substr(begin, str.find_last_not_of(' ') - begin + 1);
+    }
+
+    bool isIdentifierChar(const char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+    }
+
+    std::vector<std::string> splitArguments(const std::string& str) {
+        std::vector<std::string> arguments;
+        if (trim(str).empty()) {
+            return arguments;
+        }
+
+        for (std::size_t begin = 0; begin <= str.size(); ) {
+            std::size_t end = coldasm::Preprocessor::findUnquoted(str, ',', begin);
+            if (end == std::string::npos) {
+                end = str.size();
+            }
+
+            arguments.push_back(trim(str.substr(begin, end - begin)));
+            begin = end + 1;
+        }
+
+        return arguments;
+    }
+
+    s64 parseConditionValue(const std::string& str, const std::string& condition) {
+        const std::string value = trim(str);
+        const bool negative = !value.empty() && value[0] == '-';
+        const std::string digits = value.substr(negative ? 1 : 0);
+        const bool hex = digits.starts_with("0x");
+
+        std::size_t used = 0;
+        s64 result = 0;
+        try {
+            result = std::stoll(hex ? digits.substr(2) : digits, &used, hex ? 16 : 10);
+        } catch (const std::exception&) {
+            used = 0;
+        }
+
+        if (used == 0 || used != digits.size() - (hex ? 2 : 0)) {
+            throw std::runtime_error("Invalid condition: " + condition);
+        }
+
+        return negative ? -result : result;
+    }
+
+}
+
+std::vector<std::string> coldasm::Preprocessor::process(const std::vector<std::string>& lines, const std::filesystem::path& directory) {
+    // Definitions belong to one source, only the include cache is kept
+    mMacros.clear();
+    mConstants.clear();
+    mIncludeStack.clear();
+    mExpansionCount = 0;
+
+    std::vector<std::string> out;
+    this->processLines(lines, directory, out, 0);
+
+    return out;
+}
+
+std::vector<std::string> coldasm::Preprocessor::normalize(const std::string& sourceCode) {
+    std::vector<std::string> lines;
+    std::stringstream codeStream(sourceCode);
+
+    for (std::string line; std::getline(codeStream, line);) {
+        // Remove empty lines and comments
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        // Split lines that contain semi-colons into multiple lines, literals may contain them too
+        for (std::size_t begin = 0; begin <= line.size(); ) {
+            std::size_t end = findUnquoted(line, ';', begin);
+            if (end == std::string::npos) {
+                end = line.size();
+            }
+
+            std::string part = line.substr(begin, end - begin);
+            begin = end + 1;
+
+            // Remove spaces at the start of lines, and also remove double spaces outside of literals
+            part.erase(0, part.find_first_not_of(' '));
+
+            std::size_t pos = 0;
+            while ((pos = findUnquoted(part, ' ', pos)) != std::string::npos) {
+                if (pos + 1 < part.size() && part[pos + 1] == ' ') {
+                    part.erase(pos, 1);
+                } else {
+                    pos++;
+                }
+            }
+
+            if (!part.empty()) {
+                lines.push_back(std::move(part));
+            }
+        }
+    }
+
+    return lines;
+}
+
+std::size_t coldasm::Preprocessor::findUnquoted(const std::string& str, const char c, const std::size_t pos) {
+    char quote = '\0';
+
+    for (std::size_t i = 0; i < str.size(); i++) {
+        if (quote != '\0') {
+            if (str[i] == '\\') {
+                i++;
+            } else if (str[i] == quote) {
+                quote = '\0';
+            }
+        } else if (i >= pos && str[i] == c) {
+            return i;
+        } else if (str[i] == '\'' || str[i] == '"') {
+            quote = str[i];
+        }
+    }
+
+    return std::string::npos;
+}
+
+void coldasm::Preprocessor::processLines(const std::vector<std::string>& lines, const std::filesystem::path& directory, std::vector<std::string>& out, const u32 depth) {
+    if (depth > cMaxDepth) [[unlikely]] {
+        throw std::runtime_error("Includes or macros nested too deeply");
+    }
+
+    std::vector<Conditional> conditionals;
+    std::optional<std::pair<std::string, Macro>> definition; // Macro being recorded
+
+    for (const std::string& line : lines) {
+        const std::size_t space = line.find(' ');
+        const std::string directive = toUpper(line.substr(0, space));
+        const std::string operands = space == std::string::npos ? std::string() : trim(line.substr(space + 1));
+
+        // Macro bodies are kept as written and only evaluated when expanded
+        if (definition.has_value()) {
+            if (directive == ".ENDM") {
+                mMacros[definition->first] = std::move(definition->second);
+                definition.reset();
+            } else if (directive == ".MACRO") {
+                throw std::runtime_error("Nested macro definition: " + operands);
+            } else {
+                definition->second.body.push_back(line);
+            }
+
+            continue;
+        }
+
+        const bool active = conditionals.empty() || conditionals.back().active;
+
+        if (directive == ".IF" || directive == ".IFDEF" || directive == ".IFNDEF") {
+            bool condition = false;
+            if (active && directive == ".IF") {
+                condition = this->evaluateCondition(this->substituteConstants(operands));
+            } else if (active) {
+                const bool defined = mConstants.contains(operands) || mMacros.contains(toUpper(operands));
+                condition = defined == (directive == ".IFDEF");
+            }
+
+            // Blocks inside a skipped block are skipped entirely, including their .else
+            conditionals.push_back({ .active = active && condition, .taken = !active || condition });
+            continue;
+        }
+
+        if (directive == ".ELSE") {
+            if (conditionals.empty()) {
+                throw std::runtime_error("Unexpected .else");
+            }
+
+            conditionals.back().active = !conditionals.back().taken;
+            conditionals.back().taken = true;
+            continue;
+        }
+
+        if (directive == ".ENDIF") {
+            if (conditionals.empty()) {
+                throw std::runtime_error("Unexpected .endif");
+            }
+
+            conditionals.pop_back();
+            continue;
+        }
+
+        if (!active) {
+            continue;
+        }
+
+        if (directive == ".MACRO") {
+            const std::size_t nameEnd = operands.find(' ');
+            const std::string name = operands.substr(0, nameEnd);
+            if (name.empty()) {
+                throw std::runtime_error("Expected macro name");
+            }
+
+            Macro macro{ .parameters = splitArguments(nameEnd == std::string::npos ? std::string() : operands.substr(nameEnd + 1)), .body = {}, .directory = directory };
+            definition.emplace(toUpper(name), std::move(macro));
+        } else if (directive == ".ENDM") {
+            throw std::runtime_error("Unexpected .endm");
+        } else if (directive == ".EQU") {
+            const std::size_t comma = operands.find(',');
+            if (comma == std::string::npos) {
+                throw std::runtime_error("Expected .equ NAME, VALUE: " + line);
+            }
+
+            mConstants[trim(operands.substr(0, comma))] = this->substituteConstants(trim(operands.substr(comma + 1)));
+        } else if (directive == ".INCLUDE") {
+            if (operands.size() < 2 || operands.front() != '"' || operands.back() != '"') {
+                throw std::runtime_error("Expected quoted include path: " + line);
+            }
+
+            const std::filesystem::path path = std::filesystem::weakly_canonical(directory / operands.substr(1, operands.size() - 2));
+            if (std::find(mIncludeStack.begin(), mIncludeStack.end(), path.string()) != mIncludeStack.end()) {
+                throw std::runtime_error("Recursive include: " + path.string());
+            }
+
+            const std::vector<std::string>& included = this->loadInclude(path);
+
+            mIncludeStack.push_back(path.string());
+            this->processLines(included, path.parent_path(), out, depth + 1);
+            mIncludeStack.pop_back();
+        } else if (const auto macro = mMacros.find(directive); macro != mMacros.end()) {
+            this->expandMacro(macro->first, macro->second, operands, out, depth + 1);
+        } else {
+            out.push_back(this->substituteConstants(line));
+        }
+    }
+
+    if (definition.has_value()) {
+        throw std::runtime_error("Missing .endm for macro: " + definition->first);
+    }
+
+    if (!conditionals.empty()) {
+        throw std::runtime_error("Missing .endif");
+    }
+}
+
+void coldasm::Preprocessor::expandMacro(const std::string& name, const Macro& macro, const std::string& arguments, std::vector<std::string>& out, const u32 depth) {
+    const std::vector<std::string> values = splitArguments(arguments);
+    if (values.size() != macro.parameters.size()) {
+        throw std::runtime_error("Macro " + name + " expects " + std::to_string(macro.parameters.size()) + " arguments");
+    }
+
+    const std::string unique = std::to_string(++mExpansionCount);
+
+    // \name is replaced by the argument and \@ by a number unique to this expansion
+    std::vector<std::string> body;
+    for (const std::string& line : macro.body) {
+        std::string expanded;
+
+        for (std::size_t i = 0; i < line.size(); ) {
+            if (line[i] != '\\' || i + 1 == line.size()) {
+                expanded += line[i++];
+                continue;
+            }
+
+            if (line[i + 1] == '@') {
+                expanded += unique;
+                i += 2;
+                continue;
+            }
+
+            std::size_t end = i + 1;
+            while (end < line.size() && isIdentifierChar(line[end])) {
+                end++;
+            }
+
+            const auto parameter = std::find(macro.parameters.begin(), macro.parameters.end(), line.substr(i + 1, end - i - 1));
+            if (parameter == macro.parameters.end()) {
+                // Escape sequences in literals are left alone
+                expanded += line[i++];
+                continue;
+            }
+
+            expanded += values[parameter - macro.parameters.begin()];
+            i = end;
+        }
+
+        body.push_back(std::move(expanded));
+    }
+
+    // The body may redefine the macro while it is expanded
+    const std::filesystem::path directory = macro.directory;
+    this->processLines(body, directory, out, depth);
+}
+
+const std::vector<std::string>& coldasm::Preprocessor::loadInclude(const std::filesystem::path& path) {
+    const auto cached = mIncludeCache.find(path.string());
+    if (cached != mIncludeCache.end()) {
+        return cached->second;
+    }
+
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open include file: " + path.string());
+    }
+
+    const std::string sourceCode{ std::istreambuf_iterator<char>(file), {} };
+
+    return mIncludeCache.emplace(path.string(), normalize(sourceCode)).first->second;
+}
+
+std::string coldasm::Preprocessor::substituteConstants(const std::string& line) const {
+    if (mConstants.empty()) {
+        return line;
+    }
+
+    std::string result;
+    char quote = '\0';
+
+    for (std::size_t i = 0; i < line.size(); ) {
+        const char c = line[i];
+
+        if (quote != '\0') {
+            if (c == '\\' && i + 1 < line.size()) {
+                result += line.substr(i, 2);
+                i += 2;
+                continue;
+            }
+
+            if (c == quote) {
+                quote = '\0';
+            }
+
+            result += c;
+            i++;
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+            result += c;
+            i++;
+        } else if (isIdentifierChar(c)) {
+            // Whole words only, numbers like 0x10 are never names
+            std::size_t end = i;
+            while (end < line.size() && isIdentifierChar(line[end])) {
+                end++;
+            }
+
+            const std::string word = line.substr(i, end - i);
+            const auto constant = std::isdigit(static_cast<unsigned char>(c)) ? mConstants.end() : mConstants.find(word);
+            result += constant != mConstants.end() ? constant->second : word;
+            i = end;
+        } else {
+            result += c;
+            i++;
+        }
+    }
+
+    return result;
+}
+
+bool coldasm::Preprocessor::evaluateCondition(const std::string& condition) const {
+    static constexpr const char* cOperators[] = { "==", "!=", "<=", ">=", "<", ">" };
+
+    for (const char* op : cOperators) {
+        const std::size_t pos = condition.find(op);
+        if (pos == std::string::npos) {
+            continue;
+        }
+
+        const std::string_view opView(op);
+        const s64 lhs = parseConditionValue(condition.substr(0, pos), condition);
+        const s64 rhs = parseConditionValue(condition.substr(pos + opView.size()), condition);
+
+        if (opView == "==") return lhs == rhs;
+        if (opView == "!=") return lhs != rhs;
+        if (opView == "<=") return lhs <= rhs;
+        if (opView == ">=") return lhs >= rhs;
+        if (opView == "<") return lhs < rhs;
+        return lhs > rhs;
+    }
+
+    return parseConditionValue(condition, condition) != 0;
+}
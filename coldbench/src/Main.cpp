@@ -0,0 +1,95 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <argparse/argparse.hpp>
+
+#include "Cold/VirtualMachine.h"
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    double microsecondsSince(const Clock::time_point start, const u32 count) {
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+        return static_cast<double>(elapsed.count()) / 1000.0 / count;
+    }
+
+    std::vector<cold::Instruction> haltProgram() {
+        cold::Instruction halt;
+        halt.setData((u32)cold::Instruction::Type::SYSCALL << 24 | (u32)cold::Instruction::SyscallType::HALT << 16);
+
+        return { halt };
+    }
+
+}
+
+void benchmarkFork(const u32 children) {
+    std::cout << std::setw(12) << "memory" << std::setw(16) << "fork (us)" << std::setw(22) << "first write (us)" << std::setw(20) << "bytes per child" << "\n";
+
+    for (u64 size = 64 * 1024; size <= 1024 * 1024 * 1024; size *= 4) {
+        cold::VirtualMachine parent(haltProgram(), static_cast<u32>(size));
+
+        std::vector<std::unique_ptr<cold::VirtualMachine>> forks;
+        forks.reserve(children);
+
+        const auto forkStart = Clock::now();
+        for (u32 i = 0; i < children; i++) {
+            forks.push_back(parent.fork());
+        }
+        const double forkLatency = microsecondsSince(forkStart, children);
+
+        // Each child dirties a single page, which is the only page it has to copy
+        const u32 address = static_cast<u32>(size / 2);
+        const auto writeStart = Clock::now();
+        for (auto& child : forks) {
+            child->getMemory().writeRW(address) = 1;
+        }
+        const double writeLatency = microsecondsSince(writeStart, children);
+
+        const cold::Memory& memory = forks.front()->getMemory();
+        const u64 bytesPerChild = (u64)memory.getPrivatePageCount() * cold::Memory::cPageSize + (u64)memory.getPageCount() * sizeof(void*) * 2;
+
+        std::cout << std::setw(12) << size << std::fixed << std::setprecision(2)
+                  << std::setw(16) << forkLatency << std::setw(22) << writeLatency << std::setw(20) << bytesPerChild << "\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    argparse::ArgumentParser args("coldbench");
+    args.add_argument("benchmark")
+        .help("benchmark to run (fork)");
+
+    args.add_argument("-n", "--iterations")
+        .help("iterations per measurement")
+        .default_value(100)
+        .scan<'i', s32>();
+
+    try {
+        args.parse_args(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << args;
+        return 1;
+    }
+
+    const std::string benchmark = args.get<std::string>("benchmark");
+    const u32 iterations = args.get<s32>("--iterations");
+
+    try {
+        if (benchmark == "fork") {
+            benchmarkFork(iterations);
+        } else {
+            std::cerr << "Unknown benchmark: " << benchmark << std::endl;
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
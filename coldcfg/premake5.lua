@@ -0,0 +1,59 @@
+project "coldcfg"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++20"
+    staticruntime "off"
+    vectorextensions "AVX2"
+
+    targetdir ("bin/%{prj.name}-%{cfg.buildcfg}/out")
+    objdir ("bin/%{prj.name}-%{cfg.buildcfg}/int")
+    debugdir "../workdir"
+
+    includedirs {
+        "../coldemu/include",
+        "../colddsm/include",
+
+        -- Libraries
+        "../vendor/argparse/include"
+    }
+
+    files {
+        "src/**.cpp",
+        "../coldemu/src/ControlFlowGraph.cpp",
+        "../coldemu/src/Executable.cpp",
+        "../coldemu/src/MappedFile.cpp",
+        "../colddsm/src/Disassembler.cpp",
+    }
+
+    flags {
+        "MultiProcessorCompile",
+        "ShadowedVariables",
+        "FatalWarnings"
+    }
+
+    filter "system:windows"
+        systemversion "latest"
+        defines {
+            "_CRT_SECURE_NO_WARNINGS"
+        }
+    
+    filter "configurations:Debug"
+        runtime "Debug"
+        optimize "off"
+        symbols "on"
+    
+    filter "configurations:Release"
+        runtime "Release"
+        optimize "speed"
+        symbols "on"
+        flags {
+            "LinkTimeOptimization"
+        }
+    
+    filter "configurations:Dist"
+        runtime "Release"
+        optimize "speed"
+        symbols "off"
+        flags {
+            "LinkTimeOptimization"
+        }
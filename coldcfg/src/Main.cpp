@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <argparse/argparse.hpp>
+
+#include "Cold/ControlFlowGraph.h"
+#include "Cold/Disassembly/Disassembler.h"
+#include "Cold/Executable.h"
+#include "Cold/MappedFile.h"
+#include <Cold/Instruction.h>
+
+std::vector<cold::Instruction> loadProgram(const std::string& inputFile) {
+    const cold::MappedFile file(inputFile);
+
+    return cold::Executable::load(file.getBytes()).code;
+}
+
+void printReport(const cold::ControlFlowGraph& cfg) {
+    const auto& blocks = cfg.getBlocks();
+
+    std::cout << "Blocks: " << blocks.size() << "\n";
+
+    std::cout << "Functions: " << cfg.getFunctions().size() << "\n";
+    for (const auto& function : cfg.getFunctions()) {
+        std::cout << "    @" << blocks[function.entry].begin << ": " << function.blocks.size() << " blocks, frame ";
+        if (function.frameSize.has_value()) {
+            std::cout << *function.frameSize << " bytes";
+        } else {
+            std::cout << "unknown";
+        }
+        std::cout << (function.recursive ? ", recursive" : "") << "\n";
+    }
+
+    std::cout << "Loops: " << cfg.getLoops().size() << "\n";
+    for (const auto& loop : cfg.getLoops()) {
+        std::cout << "    header @" << blocks[loop.header].begin << ", back edge from @" << blocks[loop.latch].end - 1 << "\n";
+    }
+
+    std::cout << "Unreachable code:\n";
+    for (const auto& block : blocks) {
+        if (!block.reachable) {
+            std::cout << "    [" << block.begin << ", " << block.end << ")\n";
+        }
+    }
+
+    for (const auto& invalid : cfg.getInvalidTargets()) {
+        std::cout << "Invalid branch target " << invalid.target << " at @" << invalid.pc << "\n";
+    }
+
+    std::cout << "Max stack depth: ";
+    if (cfg.getMaxStackDepth().has_value()) {
+        std::cout << *cfg.getMaxStackDepth() << " bytes\n";
+    } else {
+        const bool recursive = std::any_of(cfg.getFunctions().begin(), cfg.getFunctions().end(), [](const auto& function) {
+            return function.recursive;
+        });
+
+        std::cout << (recursive ? "unbounded (recursion)" : "unknown") << "\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    argparse::ArgumentParser args("coldcfg");
+    args.add_argument("-i", "--input")
+        .help("input file")
+        .required();
+
+    args.add_argument("-o", "--output")
+        .help("graph output file");
+
+    args.add_argument("-f", "--format")
+        .help("graph output format (dot or json)")
+        .default_value(std::string("dot"));
+
+    try {
+        args.parse_args(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << args;
+        return 1;
+    }
+
+    const std::string inputFile = args.get<std::string>("--input");
+    const std::string format = args.get<std::string>("--format");
+
+    if (format != "dot" && format != "json") {
+        std::cerr << "Unknown format: " << format << std::endl;
+        return 1;
+    }
+
+    try {
+        std::vector<cold::Instruction> program = loadProgram(inputFile);
+        const cold::ControlFlowGraph cfg(program);
+
+        printReport(cfg);
+
+        if (auto outputFile = args.present("--output")) {
+            std::ofstream output(*outputFile);
+            if (!output.is_open()) {
+                throw std::runtime_error("Failed to open file: " + *outputFile);
+            }
+
+            if (format == "json") {
+                output << cfg.toJson();
+            } else {
+                const cold::disassembly::Disassembler disassembler(program);
+
+                std::vector<std::string> instructionText;
+                for (const auto& instr : program) {
+                    instructionText.push_back(disassembler.disassemble(instr));
+                }
+
+                output << cfg.toDot(instructionText);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
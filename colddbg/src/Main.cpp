@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <argparse/argparse.hpp>
+
+#include "Cold/Disassembly/Disassembler.h"
+#include "Cold/History.h"
+#include "Cold/VirtualMachine.h"
+
+namespace {
+
+    const char* describe(const cold::History::StopReason reason) {
+        switch (reason) {
+            case cold::History::StopReason::Steps: return "stepped";
+            case cold::History::StopReason::Breakpoint: return "breakpoint";
+            case cold::History::StopReason::Watchpoint: return "watchpoint";
+            case cold::History::StopReason::Halted: return "halted";
+            case cold::History::StopReason::Fault: return "fault";
+            case cold::History::StopReason::Start: return "reached the start of the history";
+        }
+
+        return "";
+    }
+
+    u64 parseNumber(std::istream& in, const u64 fallback) {
+        std::string text;
+        if (!(in >> text)) {
+            return fallback;
+        }
+
+        return std::stoull(text, nullptr, 0);
+    }
+
+    void printHelp() {
+        std::cout << "s [n]        step n instructions forward\n"
+                  << "bs [n]       step n instructions back\n"
+                  << "c            continue forward to the next breakpoint or watched write\n"
+                  << "rc           continue backward to the previous breakpoint or watched write\n"
+                  << "b PC         set a breakpoint, d PC deletes it\n"
+                  << "w ADDR [n]   watch n bytes for writes, dw ADDR [n] deletes them\n"
+                  << "r            print registers\n"
+                  << "x ADDR [n]   print n bytes of memory\n"
+                  << "l            disassemble around the pc\n"
+                  << "i            print history information\n"
+                  << "q            quit\n";
+    }
+
+}
+
+std::vector<cold::Instruction> loadProgram(const std::string& inputFile) {
+    std::ifstream file(inputFile, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + inputFile);
+    }
+
+    file.seekg(0, std::ios::end);
+    const size_t fileSize = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    std::vector<cold::Instruction> program(fileSize / sizeof(cold::Instruction));
+    file.read(reinterpret_cast<char*>(program.data()), fileSize);
+
+    return program;
+}
+
+void printRegisters(cold::VirtualMachine& vm) {
+    cold::Processor::Registers& registers = vm.getProcessor().getRegisters();
+
+    for (u32 i = 0; i < cold::Processor::Registers::GPRArray::cGPRCount; i++) {
+        std::cout << std::setw(4) << ("r" + std::to_string(i)) << ": 0x" << std::hex << std::setw(8) << std::setfill('0') << registers.gpr[i] << std::setfill(' ') << std::dec
+                  << ((i % 4 == 3) ? "\n" : "  ");
+    }
+
+    std::cout << "  pc: " << registers.pc << "  lr: " << registers.lr << "  cr: 0x" << std::hex << registers.cr.getFlags() << std::dec << "\n";
+}
+
+void printListing(cold::VirtualMachine& vm, const cold::disassembly::Disassembler& disassembler, const std::vector<cold::Instruction>& code) {
+    const u32 pc = vm.getProcessor().getRegisters().pc;
+    const u32 begin = pc >= 4 ? pc - 4 : 0;
+    const u32 end = std::min<u32>(pc + 5, static_cast<u32>(code.size()));
+
+    for (u32 i = begin; i < end; i++) {
+        std::cout << (i == pc ? "-> @" : "   @") << i << ": " << disassembler.disassemble(code[i]) << "\n";
+    }
+}
+
+void printLocation(cold::VirtualMachine& vm, cold::History& history, const cold::disassembly::Disassembler& disassembler, const std::vector<cold::Instruction>& code) {
+    const u32 pc = vm.getProcessor().getRegisters().pc;
+
+    std::cout << "#" << history.getPosition() << " @" << pc << ": " << (pc < code.size() ? disassembler.disassemble(code[pc]) : "<outside code>");
+    if (history.getFault().has_value()) {
+        std::cout << "    ; fault: " << *history.getFault();
+    }
+    std::cout << std::endl;
+}
+
+int main(int argc, char** argv) {
+    argparse::ArgumentParser args("colddbg");
+    args.add_argument("-p", "--path")
+        .help("path to the program file")
+        .required();
+
+    args.add_argument("-m", "--memory")
+        .help("memory size in bytes, up to 4 GiB")
+        .default_value(static_cast<u64>(1024)) // 1 KB
+        .scan<'i', u64>();
+
+    args.add_argument("--max-replay")
+        .help("upper bound on the replay time of a reverse step in milliseconds")
+        .default_value(50)
+        .scan<'i', s32>();
+
+    try {
+        args.parse_args(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << args;
+        return 1;
+    }
+
+    try {
+        cold::VirtualMachine vm(loadProgram(args.get<std::string>("--path")), args.get<u64>("--memory"));
+        cold::History history(vm, std::chrono::milliseconds(args.get<s32>("--max-replay")));
+
+        std::vector<cold::Instruction> code = *vm.getMemory().getCode();
+        const cold::disassembly::Disassembler disassembler(code);
+
+        printLocation(vm, history, disassembler, code);
+
+        std::string line;
+        while (std::cout << "(colddbg) " << std::flush, std::getline(std::cin, line)) {
+            std::istringstream command(line);
+            std::string name;
+            command >> name;
+
+            try {
+                std::optional<cold::History::StopReason> reason;
+
+                if (name == "s") {
+                    reason = history.step(parseNumber(command, 1));
+                } else if (name == "bs") {
+                    reason = history.stepBack(parseNumber(command, 1));
+                } else if (name == "c") {
+                    reason = history.continueForward();
+                } else if (name == "rc") {
+                    reason = history.continueBackward();
+                } else if (name == "b" || name == "d") {
+                    const u32 pc = static_cast<u32>(parseNumber(command, vm.getProcessor().getRegisters().pc));
+                    name == "b" ? history.addBreakpoint(pc) : history.removeBreakpoint(pc);
+                } else if (name == "w" || name == "dw") {
+                    const u32 address = static_cast<u32>(parseNumber(command, 0));
+                    const u32 size = static_cast<u32>(parseNumber(command, 1));
+
+                    for (u32 i = 0; i < size; i++) {
+                        name == "w" ? history.addWatchpoint(address + i) : history.removeWatchpoint(address + i);
+                    }
+                } else if (name == "r") {
+                    printRegisters(vm);
+                } else if (name == "x") {
+                    const u32 address = static_cast<u32>(parseNumber(command, 0));
+                    const u32 size = static_cast<u32>(parseNumber(command, 16));
+
+                    for (u32 i = 0; i < size; i++) {
+                        if (i % 16 == 0) {
+                            std::cout << (i != 0 ? "\n" : "") << "0x" << std::hex << std::setw(8) << std::setfill('0') << address + i << ":";
+                        }
+
+                        std::cout << " " << std::setw(2) << (u32)vm.getMemory().readRW(address + i);
+                    }
+
+                    std::cout << std::setfill(' ') << std::dec << "\n";
+                } else if (name == "l") {
+                    printListing(vm, disassembler, code);
+                } else if (name == "i") {
+                    std::cout << "Position: " << history.getPosition() << "\n"
+                              << "Checkpoints: " << history.getCheckpointCount() << "\n"
+                              << "Checkpoint interval: " << history.getCheckpointInterval() << " instructions\n";
+                } else if (name == "q") {
+                    break;
+                } else if (!name.empty()) {
+                    printHelp();
+                }
+
+                if (reason.has_value()) {
+                    std::cout << describe(*reason) << "\n";
+                    printLocation(vm, history, disassembler, code);
+                }
+            } catch (const std::exception& e) {
+                std::cout << e.what() << std::endl;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -12,6 +12,7 @@ namespace cold::disassembly {
         ~Disassembler() = default;
 
         std::string disassemble() const;
+        std::string disassemble(const cold::Instruction& instr) const;
 
     private:
         using DisassemblerFunc = std::string (Disassembler::*)(const cold::Instruction& instruction) const;
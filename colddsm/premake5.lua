@@ -19,6 +19,8 @@ project "colddsm"
 
     files {
         "src/**.cpp",
+        "../coldemu/src/Executable.cpp",
+        "../coldemu/src/MappedFile.cpp",
     }
 
     flags {
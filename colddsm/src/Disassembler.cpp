@@ -28,19 +28,25 @@ std::string colddsm::Disassembler::disassemble() const {
     std::stringstream result;
 
     for (const auto instr : *mProgram) {
-        const auto type = instr.getType();
-
-        if (type >= (int)cold::Instruction::Type::Count) {
-            result << "Unknown opcode: 0x" << std::hex << instr.getData() << std::dec << "\n";
-        } else {
-            DisassemblerFunc disassembler = sDisassemblerFuncs[(int)type];
-            result << (this->*disassembler)(instr) << "\n";
-        }
+        result << this->disassemble(instr) << "\n";
     }
 
     return result.str();
 }
 
+std::string colddsm::Disassembler::disassemble(const cold::Instruction& instr) const {
+    const auto type = instr.getType();
+
+    if (type >= (int)cold::Instruction::Type::Count) {
+        std::stringstream result;
+        result << "Unknown opcode: 0x" << std::hex << instr.getData();
+        return result.str();
+    }
+
+    const DisassemblerFunc disassembler = sDisassemblerFuncs[(int)type];
+    return (this->*disassembler)(instr);
+}
+
 const colddsm::Disassembler::DisassemblerFunc colddsm::Disassembler::sDisassemblerFuncs[(int)cold::Instruction::Type::Count] = {
     &colddsm::Disassembler::disasmSETI,
     &colddsm::Disassembler::disasmSYSCALL,
@@ -142,6 +148,54 @@ std::string colddsm::Disassembler::disasmSYSCALL(const cold::Instruction& instr)
             break;
         }
 
+        case cold::Instruction::SyscallType::ALLOC:
+        case cold::Instruction::SyscallType::REALLOC: {
+            const u8 targetReg = instr.getData() >> 8 & 0xFF;
+            const u8 sizeReg = instr.getData() & 0xFF;
+
+            result += std::string(syscallType == cold::Instruction::SyscallType::ALLOC ? "ALLOC" : "REALLOC") + ", r" + std::to_string((u32)targetReg) + ", r" + std::to_string((u32)sizeReg);
+
+            break;
+        }
+
+        case cold::Instruction::SyscallType::PRINTS: {
+            const u8 addressReg = instr.getData() >> 8 & 0xFF;
+            const u8 lengthReg = instr.getData() & 0xFF;
+
+            result += "PRINTS, r" + std::to_string((u32)addressReg) + ", r" + std::to_string((u32)lengthReg);
+
+            break;
+        }
+
+        case cold::Instruction::SyscallType::FREE: {
+            const u8 targetReg = instr.getData() >> 8 & 0xFF;
+
+            result += "FREE, r" + std::to_string((u32)targetReg);
+
+            break;
+        }
+
+        case cold::Instruction::SyscallType::GROW: {
+            const u8 targetReg = instr.getData() >> 8 & 0xFF;
+
+            result += "GROW, r" + std::to_string((u32)targetReg);
+
+            break;
+        }
+
+        case cold::Instruction::SyscallType::OPEN:
+        case cold::Instruction::SyscallType::READ:
+        case cold::Instruction::SyscallType::WRITE:
+        case cold::Instruction::SyscallType::CLOSE:
+        case cold::Instruction::SyscallType::MMAP: {
+            static constexpr const char* cNames[] = { "OPEN", "READ", "WRITE", "CLOSE", "MMAP" };
+            const u8 targetReg = instr.getData() >> 8 & 0xFF;
+
+            result += std::string(cNames[(u32)syscallType - (u32)cold::Instruction::SyscallType::OPEN]) + ", r" + std::to_string((u32)targetReg);
+
+            break;
+        }
+
         case cold::Instruction::SyscallType::HALT: {
             result += "HALT";
 
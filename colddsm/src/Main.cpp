@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <map>
 #include <string>
 #include <fstream>
 #include <iostream>
@@ -6,39 +8,72 @@
 #include <argparse/argparse.hpp>
 
 #include "Cold/Disassembly/Disassembler.h"
+#include <Cold/Executable.h>
 #include <Cold/Instruction.h>
+#include <Cold/MappedFile.h>
 
 void disassemble(const std::string& inputFile, const std::string& outputFile) {
-    std::ifstream file(inputFile, std::ios::in | std::ios::binary);
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open file: " + inputFile);
+    // Load program, swapping every 4 bytes straight out of the mapped file
+    const cold::MappedFile file(inputFile);
+    cold::Executable executable = cold::Executable::load(file.getBytes());
+
+    // Disassemble program
+    std::ofstream output(outputFile);
+    if (!output.is_open()) {
+        throw std::runtime_error("Failed to open file: " + outputFile);
     }
 
-    file.seekg(0, std::ios::end);
-    const size_t fileSize = file.tellg();
-    file.seekg(0, std::ios::beg);
+    cold::disassembly::Disassembler disassembler(executable.code);
+
+    // Symbols come back as labels in front of their instructions or data
+    std::multimap<u32, std::string> labels;
+    std::multimap<u32, std::string> dataLabels;
+    for (const cold::Executable::Symbol& symbol : executable.symbols) {
+        if (symbol.kind == cold::Executable::SymbolKind::Code) {
+            labels.emplace(symbol.value, symbol.name);
+        } else {
+            dataLabels.emplace(symbol.value, symbol.name);
+        }
+    }
 
-    // Load program
-    std::vector<cold::Instruction> program(fileSize / sizeof(cold::Instruction));
-    file.read(reinterpret_cast<char*>(program.data()), fileSize);
+    if (executable.entry != 0) {
+        const auto entryLabel = std::find_if(labels.begin(), labels.end(), [&executable](const auto& label) {
+            return label.first == executable.entry;
+        });
 
-    file.close();
+        output << ".entry " << (entryLabel != labels.end() ? entryLabel->second : "@" + std::to_string(executable.entry)) << "\n";
+    }
 
-    // Endian swap every 4 bytes
-    for (cold::Instruction& instruction : program) {
-        u32 data = instruction.getData();
-        data = ((data >> 24) & 0xFF) | ((data << 8) & 0xFF0000) | ((data >> 8) & 0xFF00) | ((data << 24) & 0xFF000000);
-        instruction.setData(data);
+    for (u32 pc = 0; pc < executable.code.size(); pc++) {
+        const auto [first, last] = labels.equal_range(pc);
+        for (auto label = first; label != last; ++label) {
+            output << label->second << ":\n";
+        }
+
+        output << disassembler.disassemble(executable.code[pc]) << "\n";
     }
 
-    // Disassemble program
-    std::ofstream output(outputFile);
-    if (!output.is_open()) {
-        throw std::runtime_error("Failed to open file: " + outputFile);
+    // Data is written as bytes, a new line starts at every label
+    constexpr u32 cBytesPerLine = 16;
+    u32 lineLength = 0;
+    for (u32 offset = 0; offset < executable.data.size(); offset++) {
+        const auto [first, last] = dataLabels.equal_range(executable.dataAddress + offset);
+        if (first != last || lineLength == cBytesPerLine) {
+            output << (lineLength != 0 ? "\n" : "");
+            lineLength = 0;
+        }
+
+        for (auto label = first; label != last; ++label) {
+            output << label->second << ":\n";
+        }
+
+        output << (lineLength == 0 ? ".byte " : ", ") << static_cast<u32>(executable.data[offset]);
+        lineLength++;
     }
 
-    cold::disassembly::Disassembler disassembler(program);
-    output << disassembler.disassemble();
+    if (lineLength != 0) {
+        output << "\n";
+    }
 
     output.close();
 
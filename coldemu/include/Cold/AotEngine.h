@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Cold/AotModule.h"
+#include "Cold/Engine.h"
+#include "Cold/InterpreterEngine.h"
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cold {
+
+    // Runs a program translated ahead of time by coldaot and compiled into a shared object, code the module has no
+    // block for runs in the interpreter
+    class AotEngine : public Engine {
+    public:
+        static constexpr const char* cNamePrefix = "aot:"; // Engine names are the prefix followed by the module path
+
+        explicit AotEngine(const std::filesystem::path& path);
+        ~AotEngine() override = default;
+
+        u64 execute(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) override;
+        u64 executeBlock(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) override;
+
+        [[nodiscard]] const char* getName() const override { return mName.c_str(); }
+
+    private:
+        template <bool StopAtBlockEnd>
+        u64 run(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions);
+
+        void check(const cold::Memory& memory); // Refuses to run a module translated from different code
+
+        std::shared_ptr<void> mLibrary; // Unloaded with the last reference
+        const cold::aot::Module* mModule;
+        std::string mName;
+        cold::InterpreterEngine mFallback;
+        std::shared_ptr<const std::vector<cold::Instruction>> mCheckedCode;
+    };
+
+}
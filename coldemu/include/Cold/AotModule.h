@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Cold/Common.h"
+#include "Cold/Instruction.h"
+#include "Cold/Processor.h"
+
+#include <bit>
+#include <span>
+
+#ifdef _WIN32
+    #define COLD_AOT_EXPORT extern "C" __declspec(dllexport)
+#else
+    #define COLD_AOT_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+// Interface between coldemu and the shared objects compiled from coldaot output, both sides include this header
+namespace cold::aot {
+
+    static constexpr u32 cAbiVersion = 1;
+    static constexpr const char* cEntryPoint = "cold_aot_module"; // Exported function returning the Module
+
+    // Points into the processor the module runs on, so nothing is copied in or out
+    struct Context {
+        u32* gpr;
+        u32* cr;
+        u32* pc;
+        u32* lr;
+        void* host;
+        bool (*execute)(void* host, const u32 instruction); // Runs one instruction through the processor, returns whether it finished
+        bool atBranch; // Set when run stopped right after a branch
+    };
+
+    struct Module {
+        u32 abiVersion;
+        u32 codeSize; // Instructions
+        u64 codeHash;
+
+        // Runs whole blocks while they fit in the budget, returns at any pc it has no block for
+        u64 (*run)(Context& context, const u64 maxInstructions, const bool stopAtBranch);
+    };
+
+    using ModuleFunction = const Module* (*)();
+
+    using CompareFlags = cold::Processor::Registers::CompareRegister::Flags;
+    static constexpr u32 cGreaterThan = static_cast<u32>(CompareFlags::GreaterThan);
+    static constexpr u32 cLessThan = static_cast<u32>(CompareFlags::LessThan);
+    static constexpr u32 cEqual = static_cast<u32>(CompareFlags::Equal);
+
+    [[nodiscard]] inline u64 hashCode(const std::span<const cold::Instruction> code) {
+        // FNV-1a over the instruction words
+        u64 hash = 0xCBF29CE484222325;
+        for (const cold::Instruction& instr : code) {
+            hash = (hash ^ instr.getData()) * 0x100000001B3;
+        }
+
+        return hash;
+    }
+
+    template <typename T>
+    [[nodiscard]] inline u32 compare(const T a, const T b) {
+        return (a > b ? cGreaterThan : 0) | (a < b ? cLessThan : 0) | (a == b ? cEqual : 0);
+    }
+
+    [[nodiscard]] inline f32 toFloat(const u32 value) { return std::bit_cast<f32>(value); }
+    [[nodiscard]] inline u32 fromFloat(const f32 value) { return std::bit_cast<u32>(value); }
+
+    // Instructions the tiered compiler and coldaot run on the host, everything else goes through the processor.
+    // Register numbers the processor would reject and shifts the host leaves undefined fault or run exactly as the interpreter does
+    [[nodiscard]] inline bool isInlined(const cold::Instruction& instr) {
+        using Type = cold::Instruction::Type;
+        constexpr u32 cGPRCount = cold::Processor::Registers::GPRArray::cGPRCount;
+
+        const auto [byte1, byte2, byte3] = instr.getTripleByteData();
+
+        switch (Type(instr.getType())) {
+            case Type::SETI: case Type::MFLR: case Type::MTLR: case Type::CMPI:
+                return byte1 < cGPRCount;
+
+            case Type::ADDI: case Type::SUBI: case Type::MULI: case Type::ANDI: case Type::ORI: case Type::XORI:
+            case Type::NOT: case Type::SET: case Type::CMP: case Type::FCMP:
+                return byte1 < cGPRCount && byte2 < cGPRCount;
+
+            case Type::SHIFTL: case Type::SHIFTR:
+                return byte1 < cGPRCount && byte2 < cGPRCount && byte3 < 32;
+
+            case Type::ADD: case Type::SUB: case Type::MUL: case Type::AND: case Type::OR: case Type::XOR:
+            case Type::FADD: case Type::FSUB: case Type::FMUL: case Type::FDIV:
+                return byte1 < cGPRCount && byte2 < cGPRCount && byte3 < cGPRCount;
+
+            default:
+                return instr.isBranch();
+        }
+    }
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Cold/CompiledBlock.h"
+#include "Cold/MpmcQueue.h"
+#include "Cold/TranslationCache.h"
+
+#include <atomic>
+#include <memory>
+#include <semaphore>
+#include <thread>
+#include <vector>
+
+namespace cold {
+
+    // Pool of compiler threads fed through a bounded queue. Submitting never blocks the guest, a full queue just
+    // rejects the job and the block keeps running in its current tier
+    class CompileQueue {
+    public:
+        static constexpr u32 cCapacity = 1024;
+        static constexpr u32 cMaxThreads = 4;
+
+        explicit CompileQueue(const u32 threadCount);
+        ~CompileQueue(); // Pending jobs are dropped
+
+        CompileQueue(const CompileQueue&) = delete;
+        CompileQueue& operator=(const CompileQueue&) = delete;
+
+        [[nodiscard]] static CompileQueue& getShared(); // Started on first use, sized to the host
+
+        [[nodiscard]] bool submit(std::shared_ptr<cold::TranslationCache> cache, const u32 pc, const cold::CompiledBlock::Tier tier);
+
+        [[nodiscard]] u32 getThreadCount() const { return static_cast<u32>(mThreads.size()); }
+
+    private:
+        struct Job {
+            std::shared_ptr<cold::TranslationCache> cache; // Keeps the image alive until the block is published
+            u32 pc = 0;
+            cold::CompiledBlock::Tier tier = cold::CompiledBlock::Tier::Interpreted;
+        };
+
+        void compilerLoop();
+
+        cold::MpmcQueue<Job> mJobs;
+        std::counting_semaphore<> mPending; // One count per queued job, plus one per thread when stopping
+        std::atomic<bool> mStopping;
+        std::vector<std::thread> mThreads;
+    };
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Cold/Common.h"
+#include "Cold/Instruction.h"
+#include "Cold/Processor.h"
+
+#include <memory>
+#include <vector>
+
+namespace cold {
+
+    // Straight run of instructions from an entry pc up to and including the first branch, lowered once for one tier.
+    // Blocks never change after they are built, so any number of threads may run the same block at once
+    class CompiledBlock {
+    public:
+        enum class Tier : u8 {
+            Interpreted, // No block, every instruction is fetched and checked
+            Predecoded, // Every instruction calls its resolved handler
+            Compiled // Register operations run inline on the raw register file, compares fuse with their branch
+        };
+
+        static constexpr u32 cMaxLength = 64; // Longer runs are split into several blocks
+
+        // Null when pc cannot start a block, the interpreter then raises whatever fault the instruction has
+        [[nodiscard]] static std::unique_ptr<CompiledBlock> compile(const std::vector<cold::Instruction>& code, const u32 pc, const Tier tier);
+
+        // Runs the whole block, fewer than getLength instructions only when the processor finished
+        u64 execute(cold::Processor& processor) const;
+
+        [[nodiscard]] u32 getBegin() const { return mBegin; }
+        [[nodiscard]] u32 getLength() const { return mLength; }
+        [[nodiscard]] Tier getTier() const { return mTier; }
+        [[nodiscard]] bool endsWithBranch() const { return mEndsWithBranch; }
+
+    private:
+        enum class Op : u8 {
+            Handler, // Runs the instruction through the processor
+
+            SetI,
+            Add, Sub, Mul, And, Or, Xor,
+            AddI, SubI, MulI, AndI, OrI, XorI,
+            ShiftL, ShiftR,
+            Not, Set,
+            FAdd, FSub, FMul, FDiv,
+            Cmp, FCmp, CmpI,
+            Mflr, Mtlr,
+
+            Branch, BranchLink, BranchReturn,
+            CmpBranch, CmpIBranch // Compare followed by a relative branch
+        };
+
+        struct MicroOp {
+            Op op;
+            u8 o, a, b; // Register operands, already known to be in range
+            u32 imm; // Immediate, or the instruction word of handler ops
+            u32 pc; // Instruction the op starts at
+            u32 target; // Branch target
+            u8 mask; // Compare flags a conditional branch tests
+            bool invert; // Taken when none of mask is set, unconditional branches have an empty mask
+        };
+
+        CompiledBlock(const u32 begin, const Tier tier);
+
+        void lower(const cold::Instruction& instr, const u32 pc); // Appends the ops of one instruction
+        void fuse(); // Merges a trailing compare into the branch after it
+
+        std::vector<MicroOp> mOps;
+        u32 mBegin;
+        u32 mLength;
+        Tier mTier;
+        bool mEndsWithBranch;
+    };
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Cold/Common.h"
+#include "Cold/Instruction.h"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace cold {
+
+    // Static control-flow analysis of a program image. All addresses are instruction indices (pc values).
+    class ControlFlowGraph {
+    public:
+        static constexpr u32 cInvalidBlock = 0xFFFFFFFF;
+
+        struct BasicBlock {
+            u32 begin;                        // First instruction
+            u32 end;                          // One past the last instruction
+            std::vector<u32> successors;      // Intra-procedural successors (calls fall through to the return site)
+            std::vector<u32> predecessors;
+            std::vector<u32> callees;         // Functions called from the last instruction, if it is a BL variant
+            bool reachable = false;
+            bool loopHeader = false;
+        };
+
+        struct Function {
+            u32 entry;                        // Block index of the entry block
+            std::vector<u32> blocks;
+            std::vector<u32> callees;         // Function indices
+            std::optional<u32> frameSize;     // Largest stack pointer decrease within the function, unknown if r0 is not used as a stack
+            bool recursive = false;
+        };
+
+        struct Loop {
+            u32 header;                       // Block index
+            u32 latch;                        // Block index of the back edge source
+        };
+
+        struct InvalidTarget {
+            u32 pc;                           // Branch instruction
+            s64 target;
+        };
+
+    public:
+        explicit ControlFlowGraph(const std::vector<cold::Instruction>& program);
+        ~ControlFlowGraph() = default;
+
+        [[nodiscard]] const std::vector<BasicBlock>& getBlocks() const { return mBlocks; }
+        [[nodiscard]] const std::vector<Function>& getFunctions() const { return mFunctions; }
+        [[nodiscard]] const std::vector<Loop>& getLoops() const { return mLoops; }
+        [[nodiscard]] const std::vector<InvalidTarget>& getInvalidTargets() const { return mInvalidTargets; }
+
+        [[nodiscard]] u32 findBlock(const u32 pc) const; // Returns cInvalidBlock if pc is outside the program
+        [[nodiscard]] std::optional<u32> getMaxStackDepth() const { return mMaxStackDepth; } // Empty if unbounded or unknown
+
+        [[nodiscard]] std::string toDot(const std::vector<std::string>& instructionText = {}) const;
+        [[nodiscard]] std::string toJson() const;
+
+    private:
+        void buildBlocks(const std::vector<cold::Instruction>& program);
+        void buildFunctions();
+        void findLoops();
+        void computeStackDepth(const std::vector<cold::Instruction>& program);
+
+        std::vector<BasicBlock> mBlocks;
+        std::vector<u32> mBlockOfPc;
+        std::vector<Function> mFunctions;
+        std::vector<Loop> mLoops;
+        std::vector<InvalidTarget> mInvalidTargets;
+        std::optional<u32> mMaxStackDepth;
+    };
+
+}
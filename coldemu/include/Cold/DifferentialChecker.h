@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Cold/Common.h"
+#include "Cold/Instruction.h"
+#include "Cold/VirtualMachine.h"
+
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace cold {
+
+    // Runs one program on two engines in lockstep and compares them at every block boundary
+    class DifferentialChecker {
+    public:
+        struct Divergence {
+            u32 pc; // The first instruction whose effects differ
+            std::string description;
+        };
+
+        static constexpr u64 cSnapshotInterval = 4096; // Blocks between the snapshots a divergence is replayed from
+
+        DifferentialChecker(const std::vector<cold::Instruction>& program, const u64 memorySize, const std::string& engineA, const std::string& engineB);
+        ~DifferentialChecker() = default;
+
+        [[nodiscard]] std::optional<Divergence> run(const u64 maxInstructions);
+
+        [[nodiscard]] const std::vector<cold::Instruction>& getCode() const { return *mSides[0].vm->getMemory().getCode(); }
+        [[nodiscard]] u64 getBlockCount() const { return mBlockCount; }
+        [[nodiscard]] u64 getInstructionCount() const { return mSides[0].vm->getInstructionCount(); }
+        [[nodiscard]] const std::optional<std::string>& getFault() const { return mFault; } // Fault both engines agreed on
+
+    private:
+        struct Side {
+            std::unique_ptr<cold::VirtualMachine> vm;
+            std::ostringstream output;
+            std::optional<std::string> fault;
+            u64 executed;
+        };
+
+        void step(Side& side, const u64 maxInstructions, const bool wholeBlock);
+        [[nodiscard]] std::optional<std::string> compare();
+        [[nodiscard]] Divergence locate(const cold::VirtualMachine::Snapshot& snapshotA, const cold::VirtualMachine::Snapshot& snapshotB, const u64 blocks, u64 remaining, const u64 maxSteps);
+
+        Side mSides[2];
+        u64 mBlockCount;
+        std::optional<std::string> mFault;
+    };
+
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Cold/Common.h"
+
+#include <memory>
+#include <string>
+
+namespace cold {
+
+    class Memory;
+    class Processor;
+
+    // Executes guest code on a processor, every engine must behave exactly like the interpreter
+    class Engine {
+    public:
+        virtual ~Engine() = default;
+
+        // Both return the number of instructions executed, guest faults are thrown
+        virtual u64 execute(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) = 0;
+        virtual u64 executeBlock(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) = 0; // Also stops after a branch or halt
+
+        [[nodiscard]] virtual const char* getName() const = 0;
+
+        [[nodiscard]] static std::unique_ptr<Engine> create(const std::string& name);
+    };
+
+}
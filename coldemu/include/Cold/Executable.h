@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Cold/Common.h"
+#include "Cold/Instruction.h"
+
+#include <span>
+#include <string>
+#include <vector>
+
+namespace cold {
+
+    // Contents of a program file. coldasm writes a versioned container, a bare array of big-endian instructions loads as code only
+    struct Executable {
+        static constexpr u32 cMagic = 0x434F4C44; // "COLD", never a valid first instruction of a raw image
+        static constexpr u32 cVersion = 1;
+
+        enum class SectionType : u32 {
+            Code = 1,   // Big-endian instructions
+            Data,       // Bytes loaded at dataAddress
+            Symbols,
+            Blocks      // First instruction of every basic block
+        };
+
+        enum class SymbolKind : u8 {
+            Code,       // Value is an instruction index
+            Data        // Value is a byte address
+        };
+
+        struct Symbol {
+            std::string name;
+            u32 value;
+            SymbolKind kind;
+        };
+
+        std::vector<cold::Instruction> code; // Host byte order
+        std::vector<u8> data;
+        u32 dataAddress = 0; // At or past the end of the code, the heap starts after the data
+        u32 entry = 0;
+        std::vector<Symbol> symbols;
+        std::vector<u32> blockStarts; // Sorted, empty when the file carries no block index
+
+        [[nodiscard]] static Executable load(const std::span<const u8> image);
+        [[nodiscard]] std::vector<u8> serialize() const;
+
+        [[nodiscard]] static bool isContainer(const std::span<const u8> image); // Otherwise the image is raw code
+    };
+
+}
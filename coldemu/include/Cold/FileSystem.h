@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Cold/Common.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace cold {
+
+    // Host files a guest may reach, confined to one sandbox directory
+    class FileSystem {
+    public:
+        enum class OpenMode : u32 {
+            Read,
+            Write,  // Creates or truncates
+            Append  // Creates if missing
+        };
+
+        // A read-only view of a host file, unmapped once every guest page referring to it is gone
+        struct Mapping {
+            std::shared_ptr<const u8> data;
+            u32 length;
+        };
+
+        static constexpr u32 cMaxOpenFiles = 64;
+
+        FileSystem(const std::filesystem::path& root);
+        ~FileSystem();
+
+        FileSystem(const FileSystem&) = delete;
+        FileSystem& operator=(const FileSystem&) = delete;
+
+        // Failures are reported to the guest, so they return empty results instead of throwing
+        [[nodiscard]] std::optional<u32> open(const std::string& path, const OpenMode mode);
+        [[nodiscard]] std::optional<u32> read(const u32 fd, u8* data, const u32 length);
+        [[nodiscard]] std::optional<u32> write(const u32 fd, const u8* data, const u32 length);
+        [[nodiscard]] bool close(const u32 fd);
+        [[nodiscard]] std::optional<Mapping> map(const u32 fd, const u32 offset, const u32 length); // Maps the rest of the file when length is 0, offset must be page aligned
+
+    private:
+        struct OpenFile {
+            std::FILE* file;
+            std::filesystem::path path;
+        };
+
+        [[nodiscard]] std::optional<std::filesystem::path> resolve(const std::string& path) const;
+        [[nodiscard]] OpenFile* getFile(const u32 fd);
+
+        std::filesystem::path mRoot;
+        std::vector<OpenFile> mFiles; // Indexed by guest descriptor, slots with a null file are free
+    };
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Cold/Common.h"
+#include "Cold/PredecodedEngine.h"
+#include "Cold/VirtualMachine.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace cold {
+
+    // Serves the GDB remote serial protocol for one machine over a TCP port or a unix socket
+    class GdbStub {
+    public:
+        GdbStub(cold::VirtualMachine& vm, const std::string& endpoint); // Waits for a debugger to connect, a numeric endpoint is a local TCP port
+        ~GdbStub();
+
+        GdbStub(const GdbStub&) = delete;
+        GdbStub& operator=(const GdbStub&) = delete;
+
+        bool serve(); // Returns whether the debugger detached and left the program running
+
+    private:
+        enum class WatchKind {
+            Write,
+            Read,
+            Access
+        };
+
+        struct Watchpoint {
+            u32 address;
+            u32 length;
+            WatchKind kind;
+        };
+
+        [[nodiscard]] std::optional<std::string> receivePacket(); // Empty once the debugger disconnects
+        void sendPacket(const std::string& data);
+        void sendRaw(const std::string& data);
+        [[nodiscard]] bool pollInterrupt();
+
+        [[nodiscard]] std::string handlePacket(const std::string& packet);
+        [[nodiscard]] std::string handleQuery(const std::string& packet);
+        [[nodiscard]] std::string handleBreakpoint(const std::string& packet, const bool insert);
+        [[nodiscard]] std::string resume(const bool singleStep);
+        [[nodiscard]] std::string runUntilStop(const bool singleStep);
+        [[nodiscard]] std::string completeWatchedWrite(const u32 address);
+        [[nodiscard]] bool hasReadWatchpoints() const;
+        [[nodiscard]] std::string checkReadWatchpoints(); // Stop reply for a watched read by the next instruction, empty if none
+
+        [[nodiscard]] std::string readRegisters();
+        [[nodiscard]] bool writeRegisters(const std::string& data);
+        [[nodiscard]] std::optional<u32> readRegister(const u32 index);
+        [[nodiscard]] bool writeRegister(const u32 index, const u32 value);
+
+        [[nodiscard]] std::string readMemory(const u32 address, const u32 length);
+        [[nodiscard]] bool writeMemory(const u32 address, const std::string& data);
+
+        cold::VirtualMachine* mVM;
+        cold::PredecodedEngine* mEngine; // Owned by the machine
+        std::intptr_t mListener;
+        std::intptr_t mConnection;
+        std::string mReceived; // Bytes received but not yet consumed
+        std::string mLastReply; // Resent when the debugger rejects a packet
+        std::vector<Watchpoint> mWatchpoints;
+        std::optional<u32> mStopPc; // Where the debugger last saw the machine stop, resuming there runs through its breakpoint
+        bool mAcknowledge;
+        bool mDetached;
+    };
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Cold/Common.h"
+
+#include <array>
+#include <istream>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace cold {
+
+    class Memory;
+
+    // Size-class allocator for the guest heap, all bookkeeping lives on the host so guests cannot corrupt it
+    class Heap {
+    public:
+        static constexpr u32 cMinBlockShift = 4; // 16 bytes, also the alignment of every block
+        static constexpr u32 cClassCount = 32 - cMinBlockShift;
+        static constexpr u32 cGuardSize = 16;
+        static constexpr u8 cGuardByte = 0xFD;
+
+        struct Statistics {
+            u64 allocations;
+            u64 frees;
+            u64 reallocations;
+            u64 failures;       // Requests that did not fit below the stack
+            u32 blocksInUse;
+            u32 bytesInUse;     // Requested sizes, without class rounding or guards
+            u32 peakBytesInUse;
+            u32 heapSize;       // Bytes between the heap begin and its highest block
+        };
+
+        Heap() = default;
+        ~Heap() = default;
+
+        // Allocations fail with a null address instead of growing past limit, which is normally the stack pointer
+        [[nodiscard]] u32 allocate(cold::Memory& memory, const u32 size, const u32 limit);
+        void free(cold::Memory& memory, const u32 address);
+        [[nodiscard]] u32 reallocate(cold::Memory& memory, const u32 address, const u32 size, const u32 limit);
+
+        [[nodiscard]] u32 allocateMapping(cold::Memory& memory, const u32 size, const u32 limit); // Page aligned and never guarded
+        [[nodiscard]] u32 getMappingSize(const u32 address) const; // Zero unless address starts a block allocated for a mapping
+
+        void setDebug(const bool debug) { mDebug = debug; } // Surrounds new blocks with guard bytes that are checked when they are freed
+
+        [[nodiscard]] const Statistics& getStatistics() const { return mStatistics; }
+
+        void write(std::ostream& out) const;
+        void read(std::istream& in);
+
+    private:
+        struct Block {
+            u32 size;
+            u8 sizeClass;
+            bool guarded;
+            bool mapped;
+        };
+
+        [[nodiscard]] u32 allocateBlock(cold::Memory& memory, const u32 size, const u32 limit, const bool guarded);
+        void release(cold::Memory& memory, const std::unordered_map<u32, Block>::iterator block);
+        void writeGuards(cold::Memory& memory, const u32 address, const Block& block);
+        void checkGuards(const cold::Memory& memory, const u32 address, const Block& block) const;
+
+        [[nodiscard]] static u32 getBlockSize(const u8 sizeClass) { return 1u << (sizeClass + cMinBlockShift); }
+
+        std::array<std::vector<u32>, cClassCount> mFreeBlocks{}; // Block addresses per size class
+        std::unordered_map<u32, Block> mBlocks; // Live blocks by the address handed to the guest
+        u32 mBegin = 0; // Set on the first allocation
+        u32 mTop = 0;
+        Statistics mStatistics{};
+        bool mDebug = false;
+    };
+
+}
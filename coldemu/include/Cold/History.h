@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Cold/Common.h"
+#include "Cold/VirtualMachine.h"
+
+#include <chrono>
+#include <optional>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace cold {
+
+    // Lets a machine move backwards in time by restoring periodic checkpoints and replaying forward from them
+    class History {
+    public:
+        enum class StopReason {
+            Steps,      // The requested number of instructions was executed
+            Breakpoint,
+            Watchpoint,
+            Halted,
+            Fault,
+            Start       // Reverse execution reached the beginning of the history
+        };
+
+        History(cold::VirtualMachine& vm, const std::chrono::nanoseconds maxReplayTime);
+        ~History() = default;
+
+        StopReason step(const u64 count);
+        StopReason stepBack(const u64 count);
+        StopReason continueForward();
+        StopReason continueBackward(); // Stops at the latest earlier breakpoint hit or watched write
+
+        void addBreakpoint(const u32 pc) { mBreakpoints.insert(pc); }
+        void removeBreakpoint(const u32 pc) { mBreakpoints.erase(pc); }
+        void addWatchpoint(const u32 address) { mWatchpoints.insert(address); } // Watches the byte at address
+        void removeWatchpoint(const u32 address) { mWatchpoints.erase(address); }
+
+        void setOutput(std::ostream* output) { mOutput = output; }
+
+        [[nodiscard]] u64 getPosition() const { return mVM->getInstructionCount(); }
+        [[nodiscard]] u64 getCheckpointCount() const { return mCheckpoints.size(); }
+        [[nodiscard]] u64 getCheckpointInterval() const { return mInterval; }
+        [[nodiscard]] const std::optional<std::string>& getFault() const { return mFault; } // Set while positioned on a faulting instruction
+
+    private:
+        void seek(const u64 position); // Exact, restores the nearest earlier checkpoint and replays silently
+        bool advance(u64 count); // Returns false on a guest fault, the machine is then positioned on the faulting instruction
+        void locateFault(const u64 from, const std::string& message);
+        void takeCheckpoint();
+
+        [[nodiscard]] std::vector<u8> readWatched();
+        [[nodiscard]] bool hasEvents() const { return !mBreakpoints.empty() || !mWatchpoints.empty(); }
+
+        cold::VirtualMachine* mVM;
+        std::vector<cold::VirtualMachine::Snapshot> mCheckpoints; // Ordered by instruction count
+        std::chrono::nanoseconds mMaxReplayTime;
+        u64 mInterval;
+        u64 mFurthest; // Output is only produced for instructions beyond this point
+
+        std::set<u32> mBreakpoints;
+        std::set<u32> mWatchpoints;
+        std::ostream* mOutput;
+        std::optional<std::string> mFault;
+    };
+
+}
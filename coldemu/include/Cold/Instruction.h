@@ -2,6 +2,8 @@
 
 #include "Cold/Common.h"
 
+#include <optional>
+
 namespace cold {
 
     class Instruction {
@@ -64,6 +66,16 @@ namespace cold {
             QMB, // Query memory begin
             IPRINT,
             FPRINT,
+            ALLOC,
+            FREE,
+            REALLOC,
+            OPEN,  // The file syscalls take their arguments in consecutive registers from byte 2 and return in the first
+            READ,
+            WRITE,
+            CLOSE,
+            MMAP,
+            GROW,
+            PRINTS, // byte 2: address reg, byte 3: length reg
 
             Count
         };
@@ -73,6 +85,13 @@ namespace cold {
         [[nodiscard]] u32 getData() const { return mData; }
         void setData(const u32 data) { mData = data; }
 
+        // Program files store instructions big-endian
+        [[nodiscard]] static Instruction fromBigEndian(const u8* bytes) {
+            Instruction instr;
+            instr.mData = (u32)bytes[0] << 24 | (u32)bytes[1] << 16 | (u32)bytes[2] << 8 | (u32)bytes[3];
+            return instr;
+        }
+
         struct SingleRegBigImmData {
             u8 reg;
             u16 imm;
@@ -81,7 +100,7 @@ namespace cold {
         [[nodiscard]] SingleRegBigImmData getByteShortData() const {
             return {
                 .reg = (u8)(mData >> 16 & 0xFF),
-                .imm = (u8)(mData & 0xFFFF)
+                .imm = (u16)(mData & 0xFFFF)
             };
         }
 
@@ -105,6 +124,133 @@ namespace cold {
             return data;
         }
 
+        // Branch classification, relies on the B/BL/BLR families being contiguous in Type
+
+        [[nodiscard]] bool isBranch() const {
+            return this->getType() >= (u8)Type::B && this->getType() <= (u8)Type::BNELR;
+        }
+
+        [[nodiscard]] bool isRelativeBranch() const {
+            return this->getType() >= (u8)Type::B && this->getType() <= (u8)Type::BNEL;
+        }
+
+        [[nodiscard]] bool isLinkBranch() const {
+            return this->getType() >= (u8)Type::BL && this->getType() <= (u8)Type::BNEL;
+        }
+
+        [[nodiscard]] bool isReturnBranch() const {
+            return this->getType() >= (u8)Type::BLR && this->getType() <= (u8)Type::BNELR;
+        }
+
+        [[nodiscard]] bool isConditionalBranch() const {
+            const u8 type = this->getType();
+            return this->isBranch() && type != (u8)Type::B && type != (u8)Type::BL && type != (u8)Type::BLR;
+        }
+
+        [[nodiscard]] bool isHalt() const {
+            return this->getType() == (u8)Type::SYSCALL && SyscallType(mData >> 16 & 0xFF) == SyscallType::HALT;
+        }
+
+        // Returns the general purpose register written by this instruction, if any
+        [[nodiscard]] std::optional<u8> getOutputRegister() const {
+            switch (Type(this->getType())) {
+                case Type::SETI:
+                case Type::ADD: case Type::ADDI:
+                case Type::SUB: case Type::SUBI:
+                case Type::MUL: case Type::MULI:
+                case Type::AND: case Type::ANDI:
+                case Type::OR: case Type::ORI:
+                case Type::XOR: case Type::XORI:
+                case Type::NOT:
+                case Type::SHIFTL: case Type::SHIFTR:
+                case Type::FADD: case Type::FSUB: case Type::FMUL: case Type::FDIV:
+                case Type::LDB: case Type::LDH: case Type::LDW:
+                case Type::MFLR:
+                case Type::SET:
+                    return (u8)(mData >> 16 & 0xFF);
+
+                case Type::SYSCALL:
+                    switch (SyscallType(mData >> 16 & 0xFF)) {
+                        case SyscallType::QMB:
+                        case SyscallType::ALLOC:
+                        case SyscallType::REALLOC:
+                        case SyscallType::OPEN: case SyscallType::READ: case SyscallType::WRITE:
+                        case SyscallType::CLOSE: case SyscallType::MMAP:
+                        case SyscallType::GROW:
+                            return (u8)(mData >> 8 & 0xFF);
+
+                        default:
+                            return std::nullopt;
+                    }
+
+                default:
+                    return std::nullopt;
+            }
+        }
+
+        // Returns a bitmask of the general purpose registers read by this instruction
+        [[nodiscard]] u32 getInputRegisterMask() const {
+            const u32 byte1 = 1u << (mData >> 16 & 0x1F);
+            const u32 byte2 = 1u << (mData >> 8 & 0x1F);
+            const u32 byte3 = 1u << (mData & 0x1F);
+
+            switch (Type(this->getType())) {
+                case Type::SYSCALL:
+                    switch (SyscallType(mData >> 16 & 0xFF)) {
+                        case SyscallType::PRINT:
+                        case SyscallType::IPRINT:
+                        case SyscallType::FPRINT:
+                        case SyscallType::FREE:
+                            return byte2;
+
+                        case SyscallType::ALLOC:
+                            return byte3;
+
+                        case SyscallType::REALLOC:
+                        case SyscallType::PRINTS:
+                            return byte2 | byte3;
+
+                        case SyscallType::CLOSE:
+                        case SyscallType::GROW:
+                            return byte2;
+
+                        case SyscallType::OPEN:
+                            return byte2 | byte2 << 1;
+
+                        case SyscallType::READ: case SyscallType::WRITE:
+                        case SyscallType::MMAP:
+                            return byte2 | byte2 << 1 | byte2 << 2;
+
+                        default:
+                            return 0;
+                    }
+
+                case Type::ADD: case Type::SUB: case Type::MUL:
+                case Type::AND: case Type::OR: case Type::XOR:
+                case Type::FADD: case Type::FSUB: case Type::FMUL: case Type::FDIV:
+                    return byte2 | byte3;
+
+                case Type::ADDI: case Type::SUBI: case Type::MULI:
+                case Type::ANDI: case Type::ORI: case Type::XORI:
+                case Type::NOT:
+                case Type::SHIFTL: case Type::SHIFTR:
+                case Type::LDB: case Type::LDH: case Type::LDW:
+                case Type::SET:
+                    return byte2;
+
+                case Type::CMP: case Type::FCMP:
+                case Type::STB: case Type::STH: case Type::STW:
+                    return byte1 | byte2;
+
+                case Type::CMPI:
+                case Type::MTLR:
+                    return byte1;
+
+                default:
+                    return 0;
+            }
+        }
+
     private:
         u32 mData;
     };
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Cold/Engine.h"
+
+namespace cold {
+
+    // Fetches, checks and dispatches every instruction through Processor::sInstructionHandlers, this is the reference engine
+    class InterpreterEngine : public Engine {
+    public:
+        InterpreterEngine() = default;
+        ~InterpreterEngine() override = default;
+
+        u64 execute(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) override;
+        u64 executeBlock(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) override;
+
+        [[nodiscard]] const char* getName() const override { return "interpreter"; }
+    };
+
+}
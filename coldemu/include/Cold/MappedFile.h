@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Cold/Common.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <span>
+
+namespace cold {
+
+    // A whole host file mapped read-only, its pages are read straight from the page cache instead of being copied
+    class MappedFile {
+    public:
+        MappedFile(const std::filesystem::path& path);
+        ~MappedFile() = default;
+
+        [[nodiscard]] std::span<const u8> getBytes() const { return { mData.get(), mSize }; }
+        [[nodiscard]] const std::shared_ptr<const u8>& getData() const { return mData; } // Stays mapped while any copy is alive
+
+        // Views must start on a multiple of the granularity
+        [[nodiscard]] static u64 getGranularity();
+        [[nodiscard]] static std::shared_ptr<const u8> mapView(std::FILE* file, const u64 offset, const u64 length); // Null on failure
+
+    private:
+        std::shared_ptr<const u8> mData;
+        std::size_t mSize;
+    };
+
+}
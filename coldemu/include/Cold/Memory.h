@@ -1,28 +1,227 @@
 #pragma once
 
 #include "Cold/Common.h"
+#include "Cold/Heap.h"
 #include "Cold/Instruction.h"
 
+#include <algorithm>
+#include <array>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <span>
 #include <vector>
 #include <stdexcept>
 
 namespace cold {
 
+    // Raised by a write to a watched byte before memory is modified
+    class WatchpointHit : public std::runtime_error {
+    public:
+        WatchpointHit(const u32 address) : std::runtime_error("Watchpoint hit"), mAddress(address) {}
+
+        [[nodiscard]] u32 getAddress() const { return mAddress; }
+
+    private:
+        u32 mAddress;
+    };
+
+    // A span of memory written by something other than a guest store
+    struct WriteRange {
+        u32 address;
+        u32 length;
+    };
+
+    // Guest memory split into pages that can be shared copy-on-write between forked machines
     class Memory {
     public:
-        Memory(const s32 size);
+        static constexpr u32 cPageShift = 12;
+        static constexpr u32 cPageSize = 1 << cPageShift;
+        static constexpr u64 cMaxSize = 1ull << 32;
+
+    private:
+        using Page = std::array<u8, cPageSize>;
+
+    public:
+        // Shares the pages of a memory at one point in time, pages written afterwards are copied away from it
+        class Snapshot {
+        private:
+            friend class Memory;
+
+            std::vector<std::shared_ptr<Page>> mPages;
+            std::vector<u64> mReadOnlyPages;
+            cold::Heap mHeap;
+            u64 mSize = 0;
+            u64 mGeneration = 0; // Unique per snapshot, 0 for an empty one
+        };
+
+        Memory(const u64 size); // Pages are committed on their first write, so untouched memory costs only its page table entry
         ~Memory() = default;
 
-        void setCode(const std::vector<cold::Instruction>& program);
+        Memory(Memory&&) = default;
+        Memory& operator=(Memory&&) = default;
+
+        [[nodiscard]] Memory fork(); // Both memories share every page until one of them writes to it
 
-        [[nodiscard]] u8& readRW(const u32 address);
+        void setCode(std::vector<cold::Instruction> code);
+        void setData(const u32 address, const std::span<const u8> data); // Initialized data, RW memory starts at it and the heap after it
+        void setDataEnd(const u32 end) { mDataEnd = end; } // Reserves memory written by the host in front of the heap
+
+        [[nodiscard]] u8 readRW(const u32 address) const;
+        [[nodiscard]] u8& writeRW(const u32 address);
         [[nodiscard]] cold::Instruction readX(const u32 address) const;
 
-        [[nodiscard]] u32 getRWBegin() const { return mCodeSize; }
+        // Bulk copies in and out of the read write region, page by page
+        void read(const u32 address, u8* data, const u32 length) const;
+        void write(const u32 address, const u8* data, const u32 length);
+
+        // Hands the pages of [address, address + length) to visitor in place after one bounds check, until it returns false
+        template <typename Visitor>
+        void readSpans(const u32 address, const u32 length, Visitor&& visitor) const;
+
+        // Checks the whole range is writable before handing its pages to visitor, which returns how many bytes it filled.
+        // Stops at the first span that is not filled completely and returns the bytes written
+        template <typename Visitor>
+        u32 writeSpans(const u32 address, const u32 length, Visitor&& visitor);
+
+        void copy(const u32 destination, const u32 source, const u32 length); // The ranges must not overlap
+        void fill(const u32 address, const u8 value, const u32 length);
+
+        // Bulk writes, mappings and unmappings are appended to the log while one is set, guest stores never are
+        void setWriteLog(std::vector<cold::WriteRange>* log) { mWriteLog = log; }
+
+        [[nodiscard]] const std::shared_ptr<const std::vector<cold::Instruction>>& getCode() const { return mCode; }
+
+        [[nodiscard]] u32 getCodeSize() const { return mCodeSize; }
+        [[nodiscard]] u32 getRWBegin() const { return mRWBegin; }
+        [[nodiscard]] u32 getDataEnd() const { return std::max(mRWBegin, mDataEnd); }
+        [[nodiscard]] u64 getSize() const { return mSize; }
+        [[nodiscard]] u32 getPageCount() const { return static_cast<u32>(mPages.size()); }
+        [[nodiscard]] u32 getPrivatePageCount() const;
+
+        [[nodiscard]] u32 grow(const u32 bytes); // Returns the previous size, or 0 when the size limit would be exceeded
+        void setSizeLimit(const u64 limit); // Largest size grow may reach, the initial size by default
+        [[nodiscard]] u64 getSizeLimit() const { return mSizeLimit; }
+
+        // Guest heap carved out of the read write region, its state travels with snapshots and deltas
+        [[nodiscard]] u32 allocate(const u32 size, const u32 limit) { return mHeap.allocate(*this, size, limit); }
+        void free(const u32 address); // Also unmaps mappings
+        [[nodiscard]] u32 reallocate(const u32 address, const u32 size, const u32 limit) { return mHeap.reallocate(*this, address, size, limit); }
+        [[nodiscard]] u32 map(const std::shared_ptr<const u8>& data, const u32 length, const u32 limit); // Maps host memory read-only into a heap block without copying
+        [[nodiscard]] cold::Heap& getHeap() { return mHeap; }
+
+        [[nodiscard]] Snapshot snapshot();
+        void restore(const Snapshot& base); // Only dirty pages are touched when memory was last snapshotted or restored to base
+
+        void writeDelta(std::ostream& out, const Snapshot& base) const; // Compact encoding of the bytes that differ from base
+        void applyDelta(std::istream& in);
+
+        void clearDirtyPages(); // Restarts dirty tracking like a snapshot would, without copying the page table
+        [[nodiscard]] u32 getDirtyPageCount() const;
+        [[nodiscard]] std::vector<u32> getDirtyPages() const;
+        [[nodiscard]] u64 hashPages(const std::vector<u32>& pages) const;
+
+        // Watched pages are never private, so only their writes take the slow path that checks for hits
+        void addWatchpoint(const u32 address, const u32 length);
+        void removeWatchpoint(const u32 address, const u32 length);
+        void setWatchpointsEnabled(const bool enabled) { mWatchpointsEnabled = enabled; }
 
     private:
-        std::vector<u8> mMemory;
+        struct Watchpoint {
+            u32 address;
+            u32 length;
+        };
+
+        Memory(const Memory&) = default;
+
+        [[nodiscard]] bool isPrivate(const u32 page) const { return mPrivatePages[page >> 6] >> (page & 63) & 1; }
+        void makePrivate(const u32 page);
+        void markDirty(const u32 page);
+
+        [[nodiscard]] bool isWatched(const u32 page) const { return mWatchedPages[page >> 6] >> (page & 63) & 1; }
+        [[nodiscard]] bool isReadOnly(const u32 page) const { return mReadOnlyPages[page >> 6] >> (page & 63) & 1; }
+        void prepareWrite(const u32 page, const u32 address, const u32 length); // Slow path for pages that are not private
+        void checkWatchpoints(const u32 address, const u32 length) const;
+        void checkWritable(const u32 address, const u32 length) const; // Bounds, mappings and watchpoints of a whole range
+
+        void logWrite(const u32 address, const u32 length) {
+            if (mWriteLog != nullptr) [[unlikely]] {
+                mWriteLog->push_back({ .address = address, .length = length });
+            }
+        }
+        void updateWatchedPages();
+
+        void resize(const u64 size);
+        [[nodiscard]] static const std::shared_ptr<Page>& getZeroPage();
+
+        [[nodiscard]] std::vector<u32> getChangedPages(const Snapshot& base) const;
+
+        std::vector<std::shared_ptr<Page>> mPages;
+        std::vector<u64> mPrivatePages; // Bitmap of pages that may be written in place
+        std::vector<u64> mDirtyPages; // Bitmap of pages written since the latest snapshot
+        std::vector<u32> mDirtyList; // The same pages in the order they were first written, so clearing and listing scale with writes
+        std::vector<u64> mWatchedPages; // Bitmap of pages holding at least one watched byte
+        std::vector<u64> mReadOnlyPages; // Bitmap of pages mapped from host files, never private
+        std::vector<Watchpoint> mWatchpoints;
+        bool mWatchpointsEnabled;
+        std::vector<cold::WriteRange>* mWriteLog;
+        u64 mDirtyBase; // Generation of the snapshot the dirty bitmap is relative to, 0 for none
+        std::shared_ptr<const std::vector<cold::Instruction>> mCode;
+        cold::Heap mHeap;
+        u64 mSize;
+        u64 mSizeLimit;
         u32 mCodeSize;
+        u32 mRWBegin;
+        u32 mDataEnd;
     };
 
+    template <typename Visitor>
+    void Memory::readSpans(const u32 address, const u32 length, Visitor&& visitor) const {
+        if (static_cast<u64>(address) + length > mSize || address < mRWBegin) [[unlikely]] {
+            throw std::runtime_error("Out of bounds memory access");
+        }
+
+        for (u32 done = 0; done < length; ) {
+            const u32 current = address + done;
+            const u32 offset = current & (cPageSize - 1);
+            const u32 chunk = std::min(length - done, cPageSize - offset);
+
+            if (!visitor(std::span<const u8>(mPages[current >> cPageShift]->data() + offset, chunk))) {
+                return;
+            }
+
+            done += chunk;
+        }
+    }
+
+    template <typename Visitor>
+    u32 Memory::writeSpans(const u32 address, const u32 length, Visitor&& visitor) {
+        this->checkWritable(address, length);
+
+        u32 done = 0;
+        while (done < length) {
+            const u32 current = address + done;
+            const u32 page = current >> cPageShift;
+            const u32 offset = current & (cPageSize - 1);
+            const u32 chunk = std::min(length - done, cPageSize - offset);
+
+            if (!this->isPrivate(page)) {
+                this->makePrivate(page);
+            }
+
+            const u32 filled = std::min<u32>(visitor(std::span<u8>(mPages[page]->data() + offset, chunk)), chunk);
+            done += filled;
+
+            if (filled < chunk) {
+                break;
+            }
+        }
+
+        if (done != 0) {
+            this->logWrite(address, done);
+        }
+
+        return done;
+    }
+
 }
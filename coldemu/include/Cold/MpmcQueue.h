@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Cold/Common.h"
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace cold {
+
+    // Bounded lock-free queue for any number of producer and consumer threads. Every slot carries a sequence number
+    // that tells whether it is ready to be written or read on the current lap, so threads only contend on the indices
+    template <typename T>
+    class MpmcQueue {
+    public:
+        MpmcQueue(const u32 capacity)
+            : mSlots(std::make_unique<Slot[]>(capacity))
+            , mMask(capacity - 1)
+        {
+            if (capacity == 0 || (capacity & (capacity - 1)) != 0) [[unlikely]] {
+                throw std::runtime_error("Queue capacity must be a power of two");
+            }
+
+            for (u32 i = 0; i < capacity; i++) {
+                mSlots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        ~MpmcQueue() = default;
+
+        // Fails instead of waiting when the queue is full
+        [[nodiscard]] bool tryPush(T value) {
+            u64 head = mHead.load(std::memory_order_relaxed);
+
+            for (;;) {
+                Slot& slot = mSlots[head & mMask];
+                const u64 sequence = slot.sequence.load(std::memory_order_acquire);
+
+                if (sequence == head) {
+                    if (mHead.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) {
+                        slot.value = std::move(value);
+                        slot.sequence.store(head + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (sequence < head) {
+                    return false; // The slot still holds a value from the previous lap
+                } else {
+                    head = mHead.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        [[nodiscard]] bool tryPop(T& out) {
+            u64 tail = mTail.load(std::memory_order_relaxed);
+
+            for (;;) {
+                Slot& slot = mSlots[tail & mMask];
+                const u64 sequence = slot.sequence.load(std::memory_order_acquire);
+
+                if (sequence == tail + 1) {
+                    if (mTail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+                        out = std::move(slot.value);
+                        slot.value = T();
+                        slot.sequence.store(tail + mMask + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (sequence < tail + 1) {
+                    return false; // Nothing has been pushed into the slot yet
+                } else {
+                    tail = mTail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+    private:
+        struct Slot {
+            std::atomic<u64> sequence;
+            T value;
+        };
+
+        std::unique_ptr<Slot[]> mSlots;
+        const u64 mMask;
+
+        // Producers and consumers each get their own cache line
+        alignas(64) std::atomic<u64> mHead = 0;
+        alignas(64) std::atomic<u64> mTail = 0;
+    };
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Cold/Engine.h"
+#include "Cold/Instruction.h"
+#include "Cold/Processor.h"
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace cold {
+
+    // Resolves the handler of every instruction once, so the dispatch loop skips decoding and validation
+    class PredecodedEngine : public Engine {
+    public:
+        PredecodedEngine() = default;
+        ~PredecodedEngine() override = default;
+
+        u64 execute(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) override;
+        u64 executeBlock(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) override;
+
+        [[nodiscard]] const char* getName() const override { return "predecoded"; }
+
+        // Breakpoints swap a trap entry into the decoded stream, so code without them dispatches exactly as before
+        void insertBreakpoint(const u32 pc);
+        void removeBreakpoint(const u32 pc);
+        void clearBreakpoints();
+        [[nodiscard]] bool hasBreakpoint(const u32 pc) const { return mBreakpoints.contains(pc); }
+        [[nodiscard]] bool isStoppedAtBreakpoint() const { return mStoppedAtBreakpoint; } // Whether the last run ended on a trap
+
+        // The next run executes the instruction under the trap at pc if it starts there, for resuming from a reported stop
+        void setSkippedBreakpoint(const std::optional<u32> pc) { mSkippedBreakpoint = pc; }
+
+    private:
+        enum class Linkage : u8 {
+            None,
+            Call,
+            Return
+        };
+
+        struct Operation {
+            cold::Processor::InstructionHandler handler; // Null for invalid instructions and traps
+            cold::Instruction instr;
+            Linkage linkage; // Calls and returns keep a null handler and run through link
+        };
+
+        // Pushed by calls, a return whose link register matches the top resumes at the cached entry. Guests that move LR
+        // through MTLR just miss until calls and returns line up again
+        struct ReturnAddress {
+            u32 lr;
+            const Operation* operation; // Entry after the call, null when that is past the code
+        };
+
+        static constexpr u32 cReturnStackSize = 64; // Deeper calls overwrite the oldest entries
+
+        template <bool StopAtBlockEnd>
+        u64 run(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions);
+
+        void decode(const cold::Memory& memory);
+        void patch(const u32 pc);
+
+        [[nodiscard]] const Operation* link(cold::Processor& processor, const Operation& operation); // Conditional calls and returns, gives the entry a predicted return resumes at
+        void pushReturn(const u32 lr);
+        [[nodiscard]] const Operation* popReturn(const u32 lr); // Null on a misprediction
+
+        std::vector<Operation> mOperations;
+        std::shared_ptr<const std::vector<cold::Instruction>> mDecodedCode; // Code the operations were decoded from
+        std::unordered_map<u32, Operation> mBreakpoints; // Original operations of the trapped entries
+        std::array<ReturnAddress, cReturnStackSize> mReturnStack{};
+        u32 mReturnTop = 0;
+        std::optional<u32> mSkippedBreakpoint; // Consumed by the next run
+        bool mStoppedAtBreakpoint = false;
+    };
+
+}
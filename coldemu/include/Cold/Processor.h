@@ -3,10 +3,13 @@
 #include "Cold/Common.h"
 #include "Cold/Instruction.h"
 
+#include <memory>
+#include <ostream>
 #include <stdexcept>
 
 namespace cold {
 
+    class FileSystem;
     class Memory;
 
     class Processor {
@@ -43,6 +46,9 @@ namespace cold {
                     return static_cast<u32>(cr.mFlags) & static_cast<u32>(flag);
                 }
 
+                [[nodiscard]] u32 getFlags() const { return mFlags; }
+                void setFlags(const u32 flags) { mFlags = flags; }
+
             private:
                 friend class Processor;
 
@@ -66,6 +72,7 @@ namespace cold {
 
     public:
         Processor(Memory& memory);
+        Processor(Memory& memory, const Processor& state); // Copies the state of another processor onto a different memory
         ~Processor() = default;
 
         using InstructionHandler = void (Processor::*)(const cold::Instruction&);
@@ -73,6 +80,9 @@ namespace cold {
 
         [[nodiscard]] Registers& getRegisters() { return mRegisters; }
         [[nodiscard]] bool isFinished() const { return mFinished; }
+        void setFinished(const bool finished) { mFinished = finished; }
+        void setOutput(std::ostream* output) { mOutput = output; } // Guest output is discarded when null
+        void setFileSystem(std::shared_ptr<cold::FileSystem> fileSystem) { mFileSystem = std::move(fileSystem); } // File syscalls fail when null
 
     private:
         void handleSETI(const cold::Instruction& instr);
@@ -130,9 +140,13 @@ namespace cold {
         void handleMTLR(const cold::Instruction& instr);
         void handleSET(const cold::Instruction& instr);
 
+        [[nodiscard]] u32 handleFileSyscall(const Instruction::SyscallType type, const u8 reg);
+
     private:
         Registers mRegisters;
         Memory* mMemory;
+        std::ostream* mOutput;
+        std::shared_ptr<cold::FileSystem> mFileSystem; // Shared with forked processors
         bool mFinished;
     };
 
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Cold/Common.h"
+#include "Cold/Instruction.h"
+
+#include <random>
+#include <vector>
+
+namespace cold {
+
+    // Produces random but mostly well formed instruction streams for stress testing the engines
+    class ProgramGenerator {
+    public:
+        static constexpr u32 cBaseRegister = 1; // Holds the QMB address, loads and stores are mostly relative to it
+
+        ProgramGenerator(const u64 seed);
+        ~ProgramGenerator() = default;
+
+        [[nodiscard]] std::vector<cold::Instruction> generate(const u32 length); // Byte order matches .cold files
+
+    private:
+        [[nodiscard]] cold::Instruction randomInstruction(const u32 pc, const u32 length);
+
+        [[nodiscard]] u32 below(const u32 limit) { return static_cast<u32>(mRandom() % limit); }
+        [[nodiscard]] u8 randomRegister() { return static_cast<u8>(this->below(32)); }
+        [[nodiscard]] u8 randomOutputRegister(); // Rarely clobbers the base register
+
+        std::mt19937_64 mRandom;
+    };
+
+}
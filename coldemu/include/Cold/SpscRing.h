@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Cold/Common.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+
+namespace cold {
+
+    // Lock-free ring buffer for exactly one producer thread and one consumer thread
+    template <typename T>
+    class SpscRing {
+    public:
+        SpscRing(const u32 capacity)
+            : mSlots(std::make_unique<T[]>(capacity))
+            , mMask(capacity - 1)
+        {
+            if (capacity == 0 || (capacity & (capacity - 1)) != 0) [[unlikely]] {
+                throw std::runtime_error("Ring capacity must be a power of two");
+            }
+        }
+
+        ~SpscRing() = default;
+
+        // Producer side
+        [[nodiscard]] bool tryPush(const T& value) {
+            const u64 head = mHead.load(std::memory_order_relaxed);
+
+            if (head - mCachedTail > mMask) {
+                mCachedTail = mTail.load(std::memory_order_acquire);
+                if (head - mCachedTail > mMask) {
+                    return false;
+                }
+            }
+
+            mSlots[head & mMask] = value;
+            mHead.store(head + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        // Consumer side, returns the number of values copied to out
+        [[nodiscard]] u32 popBatch(T* out, const u32 maxCount) {
+            const u64 tail = mTail.load(std::memory_order_relaxed);
+
+            if (mCachedHead == tail) {
+                mCachedHead = mHead.load(std::memory_order_acquire);
+                if (mCachedHead == tail) {
+                    return 0;
+                }
+            }
+
+            const u32 count = static_cast<u32>(std::min<u64>(mCachedHead - tail, maxCount));
+            for (u32 i = 0; i < count; i++) {
+                out[i] = mSlots[(tail + i) & mMask];
+            }
+
+            mTail.store(tail + count, std::memory_order_release);
+
+            return count;
+        }
+
+    private:
+        std::unique_ptr<T[]> mSlots;
+        const u64 mMask;
+
+        // Each index lives on its own cache line next to the copy of the other index its owner caches
+        alignas(64) std::atomic<u64> mHead = 0;
+        u64 mCachedTail = 0;
+
+        alignas(64) std::atomic<u64> mTail = 0;
+        u64 mCachedHead = 0;
+    };
+
+}
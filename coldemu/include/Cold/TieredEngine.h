@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Cold/CompiledBlock.h"
+#include "Cold/Engine.h"
+#include "Cold/InterpreterEngine.h"
+#include "Cold/TranslationCache.h"
+
+#include <memory>
+#include <vector>
+
+namespace cold {
+
+    // Starts every block in the interpreter and counts how often each block is entered. Warm blocks are predecoded and
+    // hot ones compiled by the shared CompileQueue, the guest keeps running the old tier until the new one is published
+    class TieredEngine : public Engine {
+    public:
+        using Tier = cold::CompiledBlock::Tier;
+
+        // Block entries before a block is queued for the next tier
+        static constexpr u32 cPredecodeThreshold = 16;
+        static constexpr u32 cCompileThreshold = 512;
+
+        TieredEngine() = default;
+        ~TieredEngine() override = default;
+
+        u64 execute(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) override;
+        u64 executeBlock(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) override;
+
+        [[nodiscard]] const char* getName() const override { return "tiered"; }
+
+    private:
+        template <bool StopAtBlockEnd>
+        u64 run(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions);
+
+        void reset(const cold::Memory& memory);
+        void promote(const u32 pc); // Counts an entry of a block below the top tier
+        void request(const u32 pc, const Tier tier);
+
+        cold::InterpreterEngine mInterpreter;
+        std::shared_ptr<const std::vector<cold::Instruction>> mCode; // Image the cache was looked up for
+        std::shared_ptr<cold::TranslationCache> mCache; // Shared with every other engine running the same image
+        std::vector<u32> mCounters; // Entries by pc, only touched by the guest thread
+    };
+
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Cold/Common.h"
+#include "Cold/Processor.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <iterator>
+
+namespace cold::trace {
+
+    // A .ctrace file starts with the header
+    //     magic, version, memory size, pc, r0-r31, lr, cr, instruction count, code words
+    // followed by one entry per executed instruction. An entry is a tag byte followed by the fields its bits select,
+    // every number is a LEB128 varint and deltas are zigzag encoded. The pc and instruction are never stored, they
+    // follow from the previous entry and the code in the header.
+    //
+    // Since version 2 the entries are followed by an index of chunks and a fixed size trailer
+    //     chunk count, per chunk: offset, first entry, pc, r0-r31, lr, last store address, store range, bloom words
+    //     index offset (8 bytes), entry count (8 bytes), index magic
+    // A trace whose recorder never closed has no trailer and can only be read front to back.
+
+    constexpr u32 cMagic = 0x43525443; // "CTRC"
+    constexpr u32 cVersion = 2;
+
+    constexpr u32 cIndexMagic = 0x58444943; // "CIDX"
+    constexpr u32 cTrailerSize = 20;
+    constexpr u32 cChunkEntries = 1 << 16;
+    constexpr u32 cBloomWords = 32;
+    constexpr u32 cGranuleShift = 6; // Stores are tracked by the bloom filter in 64 byte granules
+
+    enum Tag : u8 {
+        Jump = 1 << 0,     // Delta of the next pc from pc + 1
+        Register = 1 << 1, // Delta of the new value of the output register from its old value
+        Memory = 1 << 2,   // Delta of the store address from the previous store address, then the stored value
+        Link = 1 << 3,     // Delta of the new lr from its old value
+        Compare = 1 << 4   // The new cr flags are held in the top bits of the tag itself
+    };
+
+    constexpr u32 cCompareShift = 5;
+
+    // Cannot collide with a regular tag since compare flags are only present with the Compare bit, followed by the message
+    constexpr u8 cFaultTag = 0xE0;
+
+    // Memory written by a syscall rather than a store, recorded ahead of the syscall's own entry and leaving the pc alone.
+    // Followed by the delta of the address from the previous store address and the length
+    constexpr u8 cWriteTag = 0xC0;
+
+    // What the executing thread hands to the writer thread, encoding happens on the writer
+    struct Event {
+        u32 pc;
+        u32 nextPc;
+        u32 value;      // Output register value, the stored value, or the length of a syscall write
+        u32 address;
+        u32 lr;
+        u8 tags;
+        u8 reg;
+        u8 cr;
+        bool fault;
+    };
+
+    // A run of entries that can be decoded on its own, starting from the decoder state saved here
+    struct Chunk {
+        u64 offset;     // File offset of the first entry
+        u64 firstEntry;
+        u32 pc;
+        u32 registers[cold::Processor::Registers::GPRArray::cGPRCount];
+        u32 lr;
+        u32 lastAddress;
+        u64 storeBegin; // Every byte stored to by the chunk lies in [storeBegin, storeEnd)
+        u64 storeEnd;
+        u64 bloom[cBloomWords]; // Granules stored to, may report ones that were not
+
+        void addStore(const u32 address, const u32 size) {
+            storeBegin = std::min<u64>(storeBegin, address);
+            storeEnd = std::max<u64>(storeEnd, static_cast<u64>(address) + size);
+
+            const u64 first = address >> cGranuleShift;
+            const u64 last = (static_cast<u64>(address) + size - 1) >> cGranuleShift;
+
+            // Big writes would fill the filter anyway
+            if (last - first >= cBloomWords * 64) {
+                std::fill(std::begin(bloom), std::end(bloom), ~0ull);
+                return;
+            }
+
+            for (u64 granule = first; granule <= last; granule++) {
+                for (const u32 bit : bloomBits(static_cast<u32>(granule))) {
+                    bloom[bit / 64] |= 1ull << (bit % 64);
+                }
+            }
+        }
+
+        [[nodiscard]] bool mayContain(const u32 address) const {
+            if (address < storeBegin || address >= storeEnd) {
+                return false;
+            }
+
+            for (const u32 bit : bloomBits(address >> cGranuleShift)) {
+                if (!(bloom[bit / 64] >> (bit % 64) & 1)) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        [[nodiscard]] static std::array<u32, 2> bloomBits(const u32 granule) {
+            constexpr u32 cShift = 32 - std::countr_zero(cBloomWords * 64);
+            return { (granule * 0x9E3779B1u) >> cShift, (granule * 0x85EBCA77u + 0x165667B1u) >> cShift };
+        }
+    };
+
+}
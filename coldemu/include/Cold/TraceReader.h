@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Cold/Common.h"
+#include "Cold/Instruction.h"
+#include "Cold/Processor.h"
+#include "Cold/TraceFormat.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace cold {
+
+    // Decodes a .ctrace file entry by entry, reconstructing the guest registers along the way
+    class TraceReader {
+    public:
+        struct Entry {
+            u64 index;
+            u32 pc;
+            cold::Instruction instr;
+            u8 tags;
+            u32 value;      // Output register value, or the stored value
+            u32 address;    // First byte written by a store or syscall
+            u32 size;       // Bytes written by a store or syscall
+            std::string fault;
+        };
+
+        TraceReader(const std::string& path);
+        ~TraceReader() = default;
+
+        [[nodiscard]] bool next(Entry& entry); // Returns false once the trace is exhausted
+        void seek(const std::size_t chunk);    // Continues decoding at the first entry of the chunk
+
+        // Empty when the trace has no index, in which case it can only be read front to back
+        [[nodiscard]] const std::vector<cold::trace::Chunk>& getChunks() const { return mChunks; }
+        [[nodiscard]] u64 getEntryCount() const { return mEntryCount; } // Only known for indexed traces
+
+        [[nodiscard]] const std::vector<cold::Instruction>& getCode() const { return mCode; }
+        [[nodiscard]] u32 getMemorySize() const { return mMemorySize; }
+        [[nodiscard]] u32 getRegister(const u32 index) const { return mRegisters[index]; }
+        [[nodiscard]] u32 getLr() const { return mLr; }
+        [[nodiscard]] u32 getPc() const { return mPc; }
+
+    private:
+        void readIndex();
+
+        std::ifstream mFile;
+        std::vector<cold::Instruction> mCode;
+        u32 mMemorySize;
+
+        u32 mRegisters[cold::Processor::Registers::GPRArray::cGPRCount];
+        u32 mLr;
+        u32 mPc;
+        u32 mLastAddress;
+        u64 mIndex;
+        u64 mEntryCount;
+        std::vector<cold::trace::Chunk> mChunks;
+    };
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Cold/Common.h"
+#include "Cold/Memory.h"
+#include "Cold/Processor.h"
+#include "Cold/SpscRing.h"
+#include "Cold/TraceFormat.h"
+
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace cold {
+
+    class VirtualMachine;
+
+    // Streams trace events through a lock-free ring to a writer thread that encodes them to disk
+    class TraceRecorder {
+    public:
+        static constexpr u32 cRingCapacity = 1 << 16;
+
+        TraceRecorder(const std::string& path, cold::VirtualMachine& vm); // The header captures the current state of vm
+        ~TraceRecorder();
+
+        void close(); // Drains every pending event and stops the writer thread
+
+        void record(const cold::trace::Event& event) {
+            // Only blocks when the writer falls a whole ring behind
+            while (!mRing.tryPush(event)) [[unlikely]] {
+                std::this_thread::yield();
+            }
+        }
+
+        void recordFault(const u32 pc, const std::string& message);
+
+        void recordWrite(const u32 pc, const cold::WriteRange& range) {
+            this->record({ .pc = pc, .nextPc = pc, .value = range.length, .address = range.address, .lr = 0, .tags = cold::trace::cWriteTag, .reg = 0, .cr = 0, .fault = false });
+        }
+
+        // Only valid once the recorder is closed
+        [[nodiscard]] u64 getEntryCount() const { return mEntryCount; }
+        [[nodiscard]] u64 getBytesWritten() const { return mBytesWritten; }
+
+    private:
+        void writeHeader(cold::VirtualMachine& vm);
+        void writerLoop();
+        void encode(const cold::trace::Event& event);
+        void beginChunk(const u32 pc);
+        void writeIndex();
+        void flush();
+
+        std::ofstream mFile;
+        cold::SpscRing<cold::trace::Event> mRing;
+        std::atomic<bool> mStopping;
+        std::string mFaultMessage; // Published to the writer by the fault event itself
+
+        // Writer thread state, mirrors the guest so that values can be delta encoded
+        std::vector<u8> mBuffer;
+        u32 mRegisters[cold::Processor::Registers::GPRArray::cGPRCount];
+        u32 mLr;
+        u32 mLastAddress;
+        u64 mEntryCount;
+        u64 mBytesWritten;
+        u64 mFlushedBytes; // File offset mBuffer starts at
+        std::vector<cold::trace::Chunk> mChunks;
+
+        std::thread mWriter;
+    };
+
+}
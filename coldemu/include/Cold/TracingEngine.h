@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Cold/Engine.h"
+#include "Cold/Memory.h"
+
+#include <vector>
+
+namespace cold {
+
+    class TraceRecorder;
+
+    // Interprets like InterpreterEngine and hands the effects of every instruction to a TraceRecorder
+    class TracingEngine : public Engine {
+    public:
+        TracingEngine(cold::TraceRecorder& recorder);
+        ~TracingEngine() override = default;
+
+        u64 execute(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) override;
+        u64 executeBlock(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) override;
+
+        [[nodiscard]] const char* getName() const override { return "tracing"; }
+
+    private:
+        template <bool StopAtBlockEnd>
+        u64 run(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions);
+
+        cold::TraceRecorder* mRecorder;
+        std::vector<cold::WriteRange> mSyscallWrites; // Logged by memory during the current syscall
+    };
+
+}
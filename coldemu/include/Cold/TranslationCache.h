@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Cold/CompiledBlock.h"
+#include "Cold/Instruction.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace cold {
+
+    // Compiled blocks of one program image, shared by every engine running that image on any thread. Lookups and
+    // publication are lock-free, and a block stays alive as long as the cache so a replaced tier can finish running
+    class TranslationCache {
+    public:
+        using Tier = cold::CompiledBlock::Tier;
+
+        explicit TranslationCache(std::shared_ptr<const std::vector<cold::Instruction>> code);
+        ~TranslationCache();
+
+        TranslationCache(const TranslationCache&) = delete;
+        TranslationCache& operator=(const TranslationCache&) = delete;
+
+        // Cache of every live engine running the same instructions, loaded separately or not
+        [[nodiscard]] static std::shared_ptr<TranslationCache> get(const std::shared_ptr<const std::vector<cold::Instruction>>& code);
+
+        // Best tier published so far for an entry pc below getSize, null until the first one is ready
+        [[nodiscard]] const cold::CompiledBlock* lookup(const u32 pc) const { return mBlocks[pc].load(std::memory_order_acquire); }
+
+        // Only one engine gets to queue each tier of a block, a failed submit hands the claim back
+        [[nodiscard]] bool claim(const u32 pc, const Tier tier);
+        void unclaim(const u32 pc, const Tier tier);
+
+        bool publish(std::unique_ptr<cold::CompiledBlock> block); // Dropped when an equal or better tier is already there
+
+        [[nodiscard]] const std::shared_ptr<const std::vector<cold::Instruction>>& getCode() const { return mCode; }
+        [[nodiscard]] u32 getSize() const { return mSize; }
+
+    private:
+        struct Retained {
+            std::unique_ptr<cold::CompiledBlock> block;
+            Retained* next;
+        };
+
+        std::shared_ptr<const std::vector<cold::Instruction>> mCode;
+        u32 mSize; // Instructions
+        std::unique_ptr<std::atomic<const cold::CompiledBlock*>[]> mBlocks;
+        std::unique_ptr<std::atomic<Tier>[]> mClaims; // Highest tier queued by entry pc
+        std::atomic<Retained*> mRetained; // Every published block, freed with the cache
+    };
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Cold/Common.h"
+
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+namespace cold::varint {
+
+    // LEB128 encoding, small values take a single byte
+
+    inline void write(std::ostream& out, u64 value) {
+        do {
+            u8 byte = value & 0x7F;
+            value >>= 7;
+
+            if (value != 0) {
+                byte |= 0x80;
+            }
+
+            out.put(static_cast<char>(byte));
+        } while (value != 0);
+    }
+
+    inline void write(std::vector<u8>& out, u64 value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<u8>(value | 0x80));
+            value >>= 7;
+        }
+
+        out.push_back(static_cast<u8>(value));
+    }
+
+    inline u64 read(std::istream& in) {
+        u64 value = 0;
+
+        for (u32 shift = 0; shift < 64; shift += 7) {
+            const int byte = in.get();
+            if (byte == std::istream::traits_type::eof()) [[unlikely]] {
+                throw std::runtime_error("Unexpected end of varint stream");
+            }
+
+            value |= static_cast<u64>(byte & 0x7F) << shift;
+
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+
+        throw std::runtime_error("Malformed varint");
+    }
+
+    // Zigzag mapping so small negative numbers stay small
+
+    [[nodiscard]] inline u64 zigzag(const s64 value) {
+        return (static_cast<u64>(value) << 1) ^ static_cast<u64>(value >> 63);
+    }
+
+    [[nodiscard]] inline s64 unzigzag(const u64 value) {
+        return static_cast<s64>(value >> 1) ^ -static_cast<s64>(value & 1);
+    }
+
+}
@@ -1,23 +1,61 @@
 #pragma once
 
+#include "Cold/Engine.h"
+#include "Cold/Executable.h"
 #include "Cold/Instruction.h"
 #include "Cold/Memory.h"
 #include "Cold/Processor.h"
 
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <span>
 #include <vector>
 
 namespace cold {
 
     class VirtualMachine {
     public:
-        VirtualMachine(const std::vector<cold::Instruction>& program, const u32 memorySize);
+        struct Snapshot {
+            cold::Memory::Snapshot memory;
+            cold::Processor::Registers registers;
+            bool finished;
+            u64 instructionCount;
+        };
+
+        VirtualMachine(const std::vector<cold::Instruction>& program, const u64 memorySize);
+        VirtualMachine(const std::span<const u8> image, const u64 memorySize); // Image as stored in a program file
+        VirtualMachine(cold::Executable executable, const u64 memorySize);
         ~VirtualMachine() = default;
 
         void run();
+        void run(std::ostream& checkpoints, const u64 checkpointInterval); // Appends a checkpoint every checkpointInterval instructions
+        u64 execute(const u64 maxInstructions); // Returns the number of instructions executed, guest faults are thrown
+        u64 executeBlock(const u64 maxInstructions); // Also stops after a branch or halt
+
+        void setEngine(std::unique_ptr<cold::Engine> engine) { mEngine = std::move(engine); }
+        [[nodiscard]] cold::Engine& getEngine() { return *mEngine; }
+
+        [[nodiscard]] std::unique_ptr<VirtualMachine> fork(); // Memory is shared copy-on-write with the child
+
+        [[nodiscard]] Snapshot snapshot();
+        void restore(const Snapshot& snapshot);
+
+        void writeCheckpoint(std::ostream& out, const Snapshot& base); // Processor state plus the memory delta against base
+        void readCheckpoint(std::istream& in); // Checkpoints must be read in the order they were written
+
+        [[nodiscard]] bool isFinished() const { return mProcessor.isFinished(); }
+        [[nodiscard]] u64 getInstructionCount() const { return mInstructionCount; }
+        [[nodiscard]] cold::Memory& getMemory() { return mMemory; }
+        [[nodiscard]] cold::Processor& getProcessor() { return mProcessor; }
 
     private:
+        VirtualMachine(VirtualMachine& parent);
+
         cold::Memory mMemory;
         cold::Processor mProcessor;
+        std::unique_ptr<cold::Engine> mEngine;
+        u64 mInstructionCount;
     };
 
 }
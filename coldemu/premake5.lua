@@ -15,13 +15,15 @@ project "coldemu"
 
     includedirs {
         "include",
-        
+        "../colddsm/include",
+
         -- Libraries
         "../vendor/argparse/include"
     }
 
     files {
         "src/**.cpp",
+        "../colddsm/src/Disassembler.cpp",
     }
 
     flags {
@@ -30,6 +32,12 @@ project "coldemu"
         "FatalWarnings"
     }
 
+    filter "system:linux"
+        links {
+            "pthread",
+            "dl"
+        }
+
     filter "system:windows"
         systemversion "latest"
         defines {
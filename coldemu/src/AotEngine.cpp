@@ -0,0 +1,136 @@
+#include "Cold/AotEngine.h"
+#include "Cold/Memory.h"
+#include "Cold/Processor.h"
+
+#include <stdexcept>
+#include <type_traits>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <dlfcn.h>
+#endif
+
+namespace {
+
+    using CompareRegister = cold::Processor::Registers::CompareRegister;
+    static_assert(std::is_standard_layout_v<CompareRegister> && sizeof(CompareRegister) == sizeof(u32), "Modules access the compare register as a u32");
+
+    // Called by modules for instructions they leave to the processor, such as memory accesses and syscalls
+    bool executeInstruction(void* host, const u32 instruction) {
+        cold::Processor& processor = *static_cast<cold::Processor*>(host);
+
+        cold::Instruction instr;
+        instr.setData(instruction);
+
+        const u8 type = instr.getType();
+        if (type >= (int)cold::Instruction::Type::Count) [[unlikely]] {
+            throw std::runtime_error("Invalid instruction type");
+        }
+
+        (processor.*cold::Processor::sInstructionHandlers[type])(instr);
+        return processor.isFinished();
+    }
+
+    std::shared_ptr<void> loadLibrary(const std::filesystem::path& path) {
+#ifdef _WIN32
+        const HMODULE library = LoadLibraryW(path.c_str());
+        if (library == nullptr) {
+            throw std::runtime_error("Failed to load AOT module: " + path.string());
+        }
+
+        return std::shared_ptr<void>(library, [](void* handle) { FreeLibrary(static_cast<HMODULE>(handle)); });
+#else
+        // Relative paths would otherwise be searched for in the library path
+        void* library = dlopen(std::filesystem::absolute(path).c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (library == nullptr) {
+            throw std::runtime_error("Failed to load AOT module: " + std::string(dlerror()));
+        }
+
+        return std::shared_ptr<void>(library, [](void* handle) { dlclose(handle); });
+#endif
+    }
+
+    void* findSymbol(void* library, const char* name) {
+#ifdef _WIN32
+        return reinterpret_cast<void*>(GetProcAddress(static_cast<HMODULE>(library), name));
+#else
+        return dlsym(library, name);
+#endif
+    }
+
+}
+
+cold::AotEngine::AotEngine(const std::filesystem::path& path)
+    : mLibrary(loadLibrary(path))
+    , mModule(nullptr)
+    , mName(cNamePrefix + path.string())
+    , mFallback()
+    , mCheckedCode()
+{
+    const auto entryPoint = reinterpret_cast<cold::aot::ModuleFunction>(findSymbol(mLibrary.get(), cold::aot::cEntryPoint));
+    if (entryPoint == nullptr) {
+        throw std::runtime_error("Not an AOT module: " + path.string());
+    }
+
+    mModule = entryPoint();
+    if (mModule == nullptr || mModule->abiVersion != cold::aot::cAbiVersion) {
+        throw std::runtime_error("AOT module was built for a different coldemu: " + path.string());
+    }
+}
+
+u64 cold::AotEngine::execute(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) {
+    return this->run<false>(processor, memory, maxInstructions);
+}
+
+u64 cold::AotEngine::executeBlock(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) {
+    return this->run<true>(processor, memory, maxInstructions);
+}
+
+template <bool StopAtBlockEnd>
+u64 cold::AotEngine::run(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) {
+    if (memory.getCode() != mCheckedCode) [[unlikely]] {
+        this->check(memory);
+    }
+
+    cold::Processor::Registers& registers = processor.getRegisters();
+    cold::aot::Context context = {
+        .gpr = &registers.gpr[0],
+        .cr = reinterpret_cast<u32*>(&registers.cr),
+        .pc = &registers.pc,
+        .lr = &registers.lr,
+        .host = &processor,
+        .execute = &executeInstruction,
+        .atBranch = false
+    };
+
+    u64 executed = 0;
+
+    while (!processor.isFinished() && executed < maxInstructions) {
+        executed += mModule->run(context, maxInstructions - executed, StopAtBlockEnd);
+        if (processor.isFinished() || executed >= maxInstructions || (StopAtBlockEnd && context.atBranch)) {
+            break;
+        }
+
+        // The module stopped at a pc it has no block for, or the next block does not fit in the budget
+        const u64 interpreted = mFallback.executeBlock(processor, memory, maxInstructions - executed);
+        executed += interpreted;
+
+        if (StopAtBlockEnd) {
+            break;
+        }
+    }
+
+    return executed;
+}
+
+void cold::AotEngine::check(const cold::Memory& memory) {
+    const std::vector<cold::Instruction>& code = *memory.getCode();
+    if (code.size() != mModule->codeSize || cold::aot::hashCode(code) != mModule->codeHash) {
+        throw std::runtime_error("AOT module was translated from a different program");
+    }
+
+    mCheckedCode = memory.getCode();
+}
@@ -0,0 +1,60 @@
+#include "Cold/CompileQueue.h"
+
+#include <algorithm>
+
+cold::CompileQueue::CompileQueue(const u32 threadCount)
+    : mJobs(cCapacity)
+    , mPending(0)
+    , mStopping(false)
+    , mThreads()
+{
+    for (u32 i = 0; i < std::max(threadCount, 1u); i++) {
+        mThreads.emplace_back(&CompileQueue::compilerLoop, this);
+    }
+}
+
+cold::CompileQueue::~CompileQueue() {
+    mStopping.store(true, std::memory_order_relaxed);
+    mPending.release(static_cast<std::ptrdiff_t>(mThreads.size()));
+
+    for (std::thread& thread : mThreads) {
+        thread.join();
+    }
+}
+
+cold::CompileQueue& cold::CompileQueue::getShared() {
+    // Half the host keeps compilation from competing with the guests it is compiling for
+    static CompileQueue sQueue(std::clamp(std::thread::hardware_concurrency() / 2, 1u, cMaxThreads));
+
+    return sQueue;
+}
+
+bool cold::CompileQueue::submit(std::shared_ptr<cold::TranslationCache> cache, const u32 pc, const cold::CompiledBlock::Tier tier) {
+    if (!mJobs.tryPush({ .cache = std::move(cache), .pc = pc, .tier = tier })) {
+        return false;
+    }
+
+    mPending.release();
+    return true;
+}
+
+void cold::CompileQueue::compilerLoop() {
+    for (;;) {
+        mPending.acquire();
+
+        if (mStopping.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        // Every count is released after its push completed, so a job is there even if another thread took ours
+        Job job;
+        while (!mJobs.tryPop(job)) {
+            std::this_thread::yield();
+        }
+
+        std::unique_ptr<cold::CompiledBlock> block = cold::CompiledBlock::compile(*job.cache->getCode(), job.pc, job.tier);
+        if (block != nullptr) {
+            (void)job.cache->publish(std::move(block));
+        }
+    }
+}
@@ -0,0 +1,250 @@
+#include "Cold/CompiledBlock.h"
+#include "Cold/AotModule.h"
+
+using Type = cold::Instruction::Type;
+
+// Shared with the translated modules so both run inlined instructions the same way
+using cold::aot::cEqual;
+using cold::aot::cGreaterThan;
+using cold::aot::cLessThan;
+using cold::aot::compare;
+using cold::aot::fromFloat;
+using cold::aot::isInlined;
+using cold::aot::toFloat;
+
+cold::CompiledBlock::CompiledBlock(const u32 begin, const Tier tier)
+    : mOps()
+    , mBegin(begin)
+    , mLength(0)
+    , mTier(tier)
+    , mEndsWithBranch(false)
+{
+}
+
+std::unique_ptr<cold::CompiledBlock> cold::CompiledBlock::compile(const std::vector<cold::Instruction>& code, const u32 pc, const Tier tier) {
+    std::unique_ptr<CompiledBlock> block(new CompiledBlock(pc, tier));
+
+    for (u64 i = pc; i < code.size() && block->mLength < cMaxLength; i++) {
+        // The block stops short of invalid instructions, so they still fault in the interpreter
+        if (code[i].getType() >= (int)Type::Count) {
+            break;
+        }
+
+        block->lower(code[i], static_cast<u32>(i));
+        block->mLength++;
+
+        if (code[i].isBranch()) {
+            block->mEndsWithBranch = true;
+            break;
+        }
+    }
+
+    if (block->mLength == 0) {
+        return nullptr;
+    }
+
+    if (tier == Tier::Compiled) {
+        block->fuse();
+    }
+
+    return block;
+}
+
+u64 cold::CompiledBlock::execute(cold::Processor& processor) const {
+    cold::Processor::Registers& registers = processor.getRegisters();
+    u32* const r = &registers.gpr[0];
+    const u32 end = mBegin + mLength;
+
+    const auto taken = [&registers](const MicroOp& op) {
+        return ((registers.cr.getFlags() & op.mask) != 0) != op.invert;
+    };
+
+    // Inline ops leave pc alone, it is only brought up to date where the processor or a branch needs it
+    for (const MicroOp& op : mOps) {
+        switch (op.op) {
+            case Op::Handler: {
+                cold::Instruction instr;
+                instr.setData(op.imm);
+
+                registers.pc = op.pc;
+                (processor.*cold::Processor::sInstructionHandlers[instr.getType()])(instr);
+                registers.pc++;
+
+                if (processor.isFinished()) [[unlikely]] {
+                    return op.pc - mBegin + 1;
+                }
+
+                break;
+            }
+
+            case Op::SetI: r[op.o] = op.imm; break;
+
+            case Op::Add: r[op.o] = r[op.a] + r[op.b]; break;
+            case Op::Sub: r[op.o] = r[op.a] - r[op.b]; break;
+            case Op::Mul: r[op.o] = r[op.a] * r[op.b]; break;
+            case Op::And: r[op.o] = r[op.a] & r[op.b]; break;
+            case Op::Or: r[op.o] = r[op.a] | r[op.b]; break;
+            case Op::Xor: r[op.o] = r[op.a] ^ r[op.b]; break;
+
+            case Op::AddI: r[op.o] = r[op.a] + op.imm; break;
+            case Op::SubI: r[op.o] = r[op.a] - op.imm; break;
+            case Op::MulI: r[op.o] = r[op.a] * op.imm; break;
+            case Op::AndI: r[op.o] = r[op.a] & op.imm; break;
+            case Op::OrI: r[op.o] = r[op.a] | op.imm; break;
+            case Op::XorI: r[op.o] = r[op.a] ^ op.imm; break;
+            case Op::ShiftL: r[op.o] = r[op.a] << op.imm; break;
+            case Op::ShiftR: r[op.o] = r[op.a] >> op.imm; break;
+
+            case Op::Not: r[op.o] = ~r[op.a]; break;
+            case Op::Set: r[op.o] = r[op.a]; break;
+
+            case Op::FAdd: r[op.o] = fromFloat(toFloat(r[op.a]) + toFloat(r[op.b])); break;
+            case Op::FSub: r[op.o] = fromFloat(toFloat(r[op.a]) - toFloat(r[op.b])); break;
+            case Op::FMul: r[op.o] = fromFloat(toFloat(r[op.a]) * toFloat(r[op.b])); break;
+            case Op::FDiv: r[op.o] = fromFloat(toFloat(r[op.a]) / toFloat(r[op.b])); break;
+
+            case Op::Cmp: registers.cr.setFlags(compare(r[op.o], r[op.a])); break;
+            case Op::FCmp: registers.cr.setFlags(compare(toFloat(r[op.o]), toFloat(r[op.a]))); break;
+            case Op::CmpI: registers.cr.setFlags(compare(r[op.o], op.imm)); break;
+
+            case Op::Mflr: r[op.o] = registers.lr; break;
+            case Op::Mtlr: registers.lr = r[op.o]; break;
+
+            // Branches always end the block
+            case Op::CmpBranch:
+                registers.cr.setFlags(compare(r[op.o], r[op.a]));
+                registers.pc = taken(op) ? op.target : end;
+                return mLength;
+
+            case Op::CmpIBranch:
+                registers.cr.setFlags(compare(r[op.o], op.imm));
+                registers.pc = taken(op) ? op.target : end;
+                return mLength;
+
+            case Op::Branch:
+                registers.pc = taken(op) ? op.target : end;
+                return mLength;
+
+            case Op::BranchLink:
+                if (taken(op)) {
+                    registers.lr = op.pc;
+                    registers.pc = op.target;
+                } else {
+                    registers.pc = end;
+                }
+
+                return mLength;
+
+            case Op::BranchReturn:
+                registers.pc = taken(op) ? registers.lr + 1 : end;
+                return mLength;
+        }
+    }
+
+    if (mOps.back().op != Op::Handler) {
+        registers.pc = end;
+    }
+
+    return mLength;
+}
+
+void cold::CompiledBlock::lower(const cold::Instruction& instr, const u32 pc) {
+    const auto [byte1, byte2, byte3] = instr.getTripleByteData();
+
+    MicroOp op = { .op = Op::Handler, .o = byte1, .a = byte2, .b = byte3, .imm = instr.getData(), .pc = pc, .target = 0, .mask = 0, .invert = false };
+
+    if (mTier != Tier::Compiled || !isInlined(instr)) {
+        mOps.push_back(op);
+        return;
+    }
+
+    const u32 imm16 = instr.getData() & 0xFFFF;
+
+    const auto immediate = [&op, byte3](const Op type) {
+        op.op = type;
+        op.imm = byte3;
+    };
+
+    if (instr.isBranch()) {
+        // Conditions follow the same order in the B, BL and BLR families
+        static constexpr u8 cMasks[] = { 0, cGreaterThan, cGreaterThan | cEqual, cLessThan, cLessThan | cEqual, cEqual, cEqual }; // NE inverts EQ
+
+        Type first = Type::B;
+        op.op = Op::Branch;
+        op.target = static_cast<u32>(pc + instr.getS24Data()); // Wraps like the processor's u32 pc
+
+        if (instr.isLinkBranch()) {
+            first = Type::BL;
+            op.op = Op::BranchLink;
+        } else if (instr.isReturnBranch()) {
+            first = Type::BLR;
+            op.op = Op::BranchReturn;
+        }
+
+        const u32 condition = instr.getType() - (u8)first;
+        op.mask = cMasks[condition];
+        op.invert = condition == 0 || condition == 6;
+
+        mOps.push_back(op);
+        return;
+    }
+
+    switch (Type(instr.getType())) {
+        case Type::SETI: op.op = Op::SetI; op.imm = imm16; break;
+
+        case Type::ADD: op.op = Op::Add; break;
+        case Type::SUB: op.op = Op::Sub; break;
+        case Type::MUL: op.op = Op::Mul; break;
+        case Type::AND: op.op = Op::And; break;
+        case Type::OR: op.op = Op::Or; break;
+        case Type::XOR: op.op = Op::Xor; break;
+
+        case Type::ADDI: immediate(Op::AddI); break;
+        case Type::SUBI: immediate(Op::SubI); break;
+        case Type::MULI: immediate(Op::MulI); break;
+        case Type::ANDI: immediate(Op::AndI); break;
+        case Type::ORI: immediate(Op::OrI); break;
+        case Type::XORI: immediate(Op::XorI); break;
+        case Type::SHIFTL: immediate(Op::ShiftL); break;
+        case Type::SHIFTR: immediate(Op::ShiftR); break;
+
+        case Type::NOT: op.op = Op::Not; break;
+        case Type::SET: op.op = Op::Set; break;
+
+        case Type::FADD: op.op = Op::FAdd; break;
+        case Type::FSUB: op.op = Op::FSub; break;
+        case Type::FMUL: op.op = Op::FMul; break;
+        case Type::FDIV: op.op = Op::FDiv; break;
+
+        case Type::CMP: op.op = Op::Cmp; break;
+        case Type::FCMP: op.op = Op::FCmp; break;
+        case Type::CMPI: op.op = Op::CmpI; op.imm = imm16; break;
+
+        case Type::MFLR: op.op = Op::Mflr; break;
+        case Type::MTLR: op.op = Op::Mtlr; break;
+
+        default: break;
+    }
+
+    mOps.push_back(op);
+}
+
+void cold::CompiledBlock::fuse() {
+    if (mOps.size() < 2) {
+        return;
+    }
+
+    const MicroOp branch = mOps.back();
+    MicroOp& compare = mOps[mOps.size() - 2];
+
+    if (branch.op != Op::Branch || (compare.op != Op::Cmp && compare.op != Op::CmpI)) {
+        return;
+    }
+
+    compare.op = compare.op == Op::Cmp ? Op::CmpBranch : Op::CmpIBranch;
+    compare.target = branch.target;
+    compare.mask = branch.mask;
+    compare.invert = branch.invert;
+
+    mOps.pop_back();
+}
@@ -0,0 +1,478 @@
+#include "Cold/ControlFlowGraph.h"
+#include "Cold/Processor.h"
+
+#include <algorithm>
+#include <set>
+#include <sstream>
+
+namespace {
+
+    void appendUnique(std::vector<u32>& list, const u32 value) {
+        if (std::find(list.begin(), list.end(), value) == list.end()) {
+            list.push_back(value);
+        }
+    }
+
+    std::string jsonList(const std::vector<u32>& list) {
+        std::string result = "[";
+
+        for (std::size_t i = 0; i < list.size(); i++) {
+            if (i != 0) {
+                result += ", ";
+            }
+
+            result += std::to_string(list[i]);
+        }
+
+        return result + "]";
+    }
+
+    std::string dotEscape(const std::string& text) {
+        std::string result;
+
+        for (const char c : text) {
+            if (c == '"' || c == '\\') {
+                result += '\\';
+            }
+
+            result += c;
+        }
+
+        return result;
+    }
+
+}
+
+cold::ControlFlowGraph::ControlFlowGraph(const std::vector<cold::Instruction>& program)
+    : mBlocks()
+    , mBlockOfPc(program.size(), cInvalidBlock)
+    , mFunctions()
+    , mLoops()
+    , mInvalidTargets()
+    , mMaxStackDepth()
+{
+    if (program.empty()) {
+        return;
+    }
+
+    this->buildBlocks(program);
+    this->buildFunctions();
+    this->findLoops();
+    this->computeStackDepth(program);
+}
+
+u32 cold::ControlFlowGraph::findBlock(const u32 pc) const {
+    if (pc >= mBlockOfPc.size()) [[unlikely]] {
+        return cInvalidBlock;
+    }
+
+    return mBlockOfPc[pc];
+}
+
+void cold::ControlFlowGraph::buildBlocks(const std::vector<cold::Instruction>& program) {
+    const u32 size = static_cast<u32>(program.size());
+
+    // Leaders are the entry point, branch targets and everything following a branch or halt
+    std::vector<bool> leaders(size, false);
+    leaders[0] = true;
+
+    for (u32 pc = 0; pc < size; pc++) {
+        const cold::Instruction& instr = program[pc];
+
+        if (instr.isRelativeBranch()) {
+            const s64 target = (s64)pc + instr.getS24Data();
+
+            if (target >= 0 && target < size) {
+                leaders[target] = true;
+            } else {
+                mInvalidTargets.push_back({ .pc = pc, .target = target });
+            }
+        }
+
+        if ((instr.isBranch() || instr.isHalt()) && pc + 1 < size) {
+            leaders[pc + 1] = true;
+        }
+    }
+
+    for (u32 pc = 0; pc < size; pc++) {
+        if (leaders[pc]) {
+            mBlocks.push_back({ .begin = pc, .end = pc });
+        }
+
+        mBlocks.back().end = pc + 1;
+        mBlockOfPc[pc] = static_cast<u32>(mBlocks.size() - 1);
+    }
+
+    // Connect blocks based on their last instruction
+    for (auto& block : mBlocks) {
+        const u32 last = block.end - 1;
+        const cold::Instruction& instr = program[last];
+        const bool hasFallthrough = block.end < size;
+
+        if (instr.isHalt()) {
+            continue;
+        }
+
+        if (instr.isRelativeBranch()) {
+            const s64 target = (s64)last + instr.getS24Data();
+            const bool validTarget = target >= 0 && target < size;
+
+            if (instr.isLinkBranch()) {
+                if (validTarget) {
+                    block.callees.push_back(mBlockOfPc[target]);
+                }
+            } else if (validTarget) {
+                appendUnique(block.successors, mBlockOfPc[target]);
+            }
+
+            if ((instr.isConditionalBranch() || instr.isLinkBranch()) && hasFallthrough) {
+                appendUnique(block.successors, mBlockOfPc[block.end]);
+            }
+
+            continue;
+        }
+
+        if (instr.isReturnBranch()) {
+            if (instr.isConditionalBranch() && hasFallthrough) {
+                appendUnique(block.successors, mBlockOfPc[block.end]);
+            }
+
+            continue;
+        }
+
+        if (hasFallthrough) {
+            block.successors.push_back(mBlockOfPc[block.end]);
+        }
+    }
+
+    for (u32 i = 0; i < mBlocks.size(); i++) {
+        for (const u32 successor : mBlocks[i].successors) {
+            mBlocks[successor].predecessors.push_back(i);
+        }
+    }
+}
+
+void cold::ControlFlowGraph::buildFunctions() {
+    // Every call target starts a function, as does the program entry
+    std::vector<u32> functionOfEntry(mBlocks.size(), cInvalidBlock);
+
+    const auto addFunction = [&](const u32 entryBlock) {
+        if (functionOfEntry[entryBlock] == cInvalidBlock) {
+            functionOfEntry[entryBlock] = static_cast<u32>(mFunctions.size());
+            mFunctions.push_back({ .entry = entryBlock });
+        }
+    };
+
+    addFunction(0);
+    for (const auto& block : mBlocks) {
+        for (const u32 callee : block.callees) {
+            addFunction(callee);
+        }
+    }
+
+    // A function owns every block reachable from its entry without following calls
+    for (auto& function : mFunctions) {
+        std::vector<bool> visited(mBlocks.size(), false);
+        std::vector<u32> worklist = { function.entry };
+        visited[function.entry] = true;
+
+        while (!worklist.empty()) {
+            const u32 current = worklist.back();
+            worklist.pop_back();
+            function.blocks.push_back(current);
+
+            for (const u32 callee : mBlocks[current].callees) {
+                appendUnique(function.callees, functionOfEntry[callee]);
+            }
+
+            for (const u32 successor : mBlocks[current].successors) {
+                if (!visited[successor]) {
+                    visited[successor] = true;
+                    worklist.push_back(successor);
+                }
+            }
+        }
+
+        std::sort(function.blocks.begin(), function.blocks.end());
+    }
+
+    // Reachability and recursion over the call graph
+    const auto reachableFunctions = [&](const u32 start) {
+        std::vector<bool> visited(mFunctions.size(), false);
+        std::vector<u32> worklist = mFunctions[start].callees;
+
+        while (!worklist.empty()) {
+            const u32 current = worklist.back();
+            worklist.pop_back();
+
+            if (visited[current]) {
+                continue;
+            }
+
+            visited[current] = true;
+            worklist.insert(worklist.end(), mFunctions[current].callees.begin(), mFunctions[current].callees.end());
+        }
+
+        return visited;
+    };
+
+    const std::vector<bool> fromEntry = reachableFunctions(0);
+    for (u32 i = 0; i < mFunctions.size(); i++) {
+        if (i == 0 || fromEntry[i]) {
+            for (const u32 block : mFunctions[i].blocks) {
+                mBlocks[block].reachable = true;
+            }
+        }
+
+        mFunctions[i].recursive = reachableFunctions(i)[i];
+    }
+}
+
+void cold::ControlFlowGraph::findLoops() {
+    std::set<std::pair<u32, u32>> backEdges;
+
+    // Depth first search per function, an edge to a block still on the stack closes a loop
+    for (const auto& function : mFunctions) {
+        enum class State : u8 { Unvisited, Active, Done };
+        std::vector<State> states(mBlocks.size(), State::Unvisited);
+
+        // Explicit stack of blocks and their next successor index, long branch chains would overflow recursion
+        std::vector<std::pair<u32, std::size_t>> stack = { { function.entry, 0 } };
+        states[function.entry] = State::Active;
+
+        while (!stack.empty()) {
+            const auto [current, index] = stack.back();
+            const auto& successors = mBlocks[current].successors;
+
+            if (index == successors.size()) {
+                states[current] = State::Done;
+                stack.pop_back();
+                continue;
+            }
+
+            stack.back().second++;
+
+            const u32 successor = successors[index];
+            if (states[successor] == State::Active) {
+                backEdges.insert({ successor, current });
+            } else if (states[successor] == State::Unvisited) {
+                states[successor] = State::Active;
+                stack.push_back({ successor, 0 });
+            }
+        }
+    }
+
+    for (const auto& [header, latch] : backEdges) {
+        mLoops.push_back({ .header = header, .latch = latch });
+        mBlocks[header].loopHeader = true;
+    }
+}
+
+void cold::ControlFlowGraph::computeStackDepth(const std::vector<cold::Instruction>& program) {
+    constexpr u8 sp = cold::Processor::Registers::GPRArray::cStackPointerRegister;
+
+    struct CallSite {
+        u32 depth;
+        u32 callee;
+    };
+
+    std::vector<std::vector<CallSite>> callSites(mFunctions.size());
+
+    // Track stack pointer adjustments through ADDI/SUBI on r0, any other write makes the frame unknown
+    for (u32 f = 0; f < mFunctions.size(); f++) {
+        auto& function = mFunctions[f];
+
+        std::vector<std::optional<s64>> entryDepth(mBlocks.size());
+        std::vector<u32> worklist = { function.entry };
+        entryDepth[function.entry] = 0;
+
+        s64 maxDepth = 0;
+        bool known = true;
+
+        while (!worklist.empty() && known) {
+            const u32 current = worklist.back();
+            worklist.pop_back();
+
+            const auto& block = mBlocks[current];
+            s64 depth = *entryDepth[current];
+
+            for (u32 pc = block.begin; pc < block.end && known; pc++) {
+                const cold::Instruction& instr = program[pc];
+
+                if (instr.getOutputRegister() == sp) {
+                    const auto [outReg, inReg, value] = instr.getTripleByteData();
+                    const auto type = cold::Instruction::Type(instr.getType());
+
+                    if (type == cold::Instruction::Type::SUBI && inReg == sp) {
+                        depth += value;
+                    } else if (type == cold::Instruction::Type::ADDI && inReg == sp) {
+                        depth -= value;
+                    } else {
+                        known = false;
+                    }
+                }
+
+                maxDepth = std::max(maxDepth, depth);
+            }
+
+            for (const u32 callee : block.callees) {
+                // Each block that calls was created by its BL, so it is the only call site in the block
+                callSites[f].push_back({ .depth = (u32)std::max<s64>(depth, 0), .callee = callee });
+            }
+
+            for (const u32 successor : block.successors) {
+                if (!entryDepth[successor].has_value()) {
+                    entryDepth[successor] = depth;
+                    worklist.push_back(successor);
+                } else if (*entryDepth[successor] != depth) {
+                    known = false; // Paths disagree on the frame layout
+                }
+            }
+        }
+
+        if (known) {
+            function.frameSize = static_cast<u32>(maxDepth);
+        }
+    }
+
+    // Combine frames over the call graph, recursion makes the depth unbounded
+    std::vector<u32> functionOfEntry(mBlocks.size(), cInvalidBlock);
+    for (u32 f = 0; f < mFunctions.size(); f++) {
+        functionOfEntry[mFunctions[f].entry] = f;
+    }
+
+    // Post order walk over the call graph, a function is resolved once all its callees are
+    std::vector<std::optional<std::optional<u32>>> memo(mFunctions.size());
+    std::vector<std::pair<u32, std::size_t>> stack = { { 0, 0 } };
+
+    while (!stack.empty()) {
+        const auto [f, index] = stack.back();
+
+        if (!memo[f].has_value() && (mFunctions[f].recursive || !mFunctions[f].frameSize.has_value())) {
+            memo[f] = std::optional<u32>{};
+        }
+
+        if (memo[f].has_value()) {
+            stack.pop_back();
+            continue;
+        }
+
+        if (index < callSites[f].size()) {
+            stack.back().second++;
+
+            const u32 callee = functionOfEntry[callSites[f][index].callee];
+            if (!memo[callee].has_value()) {
+                stack.push_back({ callee, 0 });
+            }
+
+            continue;
+        }
+
+        std::optional<u32> result = *mFunctions[f].frameSize;
+        for (const auto& site : callSites[f]) {
+            const std::optional<u32> calleeDepth = *memo[functionOfEntry[site.callee]];
+            if (!calleeDepth.has_value()) {
+                result = std::nullopt;
+                break;
+            }
+
+            result = std::max(*result, site.depth + *calleeDepth);
+        }
+
+        memo[f] = result;
+        stack.pop_back();
+    }
+
+    mMaxStackDepth = *memo[0];
+}
+
+std::string cold::ControlFlowGraph::toDot(const std::vector<std::string>& instructionText) const {
+    std::stringstream result;
+
+    result << "digraph cfg {\n";
+    result << "    node [shape=box, fontname=\"monospace\"];\n";
+
+    for (u32 i = 0; i < mBlocks.size(); i++) {
+        const auto& block = mBlocks[i];
+
+        std::string label = "B" + std::to_string(i) + " [" + std::to_string(block.begin) + ", " + std::to_string(block.end) + ")\\l";
+        for (u32 pc = block.begin; pc < block.end && pc < instructionText.size(); pc++) {
+            label += std::to_string(pc) + ": " + dotEscape(instructionText[pc]) + "\\l";
+        }
+
+        result << "    b" << i << " [label=\"" << label << "\"";
+        if (!block.reachable) {
+            result << ", style=dashed, color=gray";
+        }
+        if (block.loopHeader) {
+            result << ", penwidth=2";
+        }
+        result << "];\n";
+    }
+
+    for (u32 i = 0; i < mBlocks.size(); i++) {
+        for (const u32 successor : mBlocks[i].successors) {
+            result << "    b" << i << " -> b" << successor << ";\n";
+        }
+
+        for (const u32 callee : mBlocks[i].callees) {
+            result << "    b" << i << " -> b" << callee << " [style=dashed, label=\"call\"];\n";
+        }
+    }
+
+    result << "}\n";
+
+    return result.str();
+}
+
+std::string cold::ControlFlowGraph::toJson() const {
+    std::stringstream result;
+
+    result << "{\n";
+    result << "  \"blocks\": [\n";
+    for (u32 i = 0; i < mBlocks.size(); i++) {
+        const auto& block = mBlocks[i];
+
+        result << "    { \"id\": " << i
+               << ", \"begin\": " << block.begin
+               << ", \"end\": " << block.end
+               << ", \"successors\": " << jsonList(block.successors)
+               << ", \"callees\": " << jsonList(block.callees)
+               << ", \"reachable\": " << (block.reachable ? "true" : "false")
+               << ", \"loopHeader\": " << (block.loopHeader ? "true" : "false")
+               << " }" << (i + 1 < mBlocks.size() ? "," : "") << "\n";
+    }
+    result << "  ],\n";
+
+    result << "  \"functions\": [\n";
+    for (u32 i = 0; i < mFunctions.size(); i++) {
+        const auto& function = mFunctions[i];
+
+        result << "    { \"entry\": " << mBlocks[function.entry].begin
+               << ", \"blocks\": " << jsonList(function.blocks)
+               << ", \"callees\": " << jsonList(function.callees)
+               << ", \"frameSize\": " << (function.frameSize.has_value() ? std::to_string(*function.frameSize) : "null")
+               << ", \"recursive\": " << (function.recursive ? "true" : "false")
+               << " }" << (i + 1 < mFunctions.size() ? "," : "") << "\n";
+    }
+    result << "  ],\n";
+
+    result << "  \"loops\": [\n";
+    for (u32 i = 0; i < mLoops.size(); i++) {
+        result << "    { \"header\": " << mLoops[i].header << ", \"latch\": " << mLoops[i].latch << " }"
+               << (i + 1 < mLoops.size() ? "," : "") << "\n";
+    }
+    result << "  ],\n";
+
+    result << "  \"invalidTargets\": [\n";
+    for (u32 i = 0; i < mInvalidTargets.size(); i++) {
+        result << "    { \"pc\": " << mInvalidTargets[i].pc << ", \"target\": " << mInvalidTargets[i].target << " }"
+               << (i + 1 < mInvalidTargets.size() ? "," : "") << "\n";
+    }
+    result << "  ],\n";
+
+    result << "  \"maxStackDepth\": " << (mMaxStackDepth.has_value() ? std::to_string(*mMaxStackDepth) : "null") << "\n";
+    result << "}\n";
+
+    return result.str();
+}
@@ -0,0 +1,187 @@
+#include "Cold/DifferentialChecker.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+    std::string hex(const u32 value) {
+        std::stringstream stream;
+        stream << "0x" << std::hex << value;
+        return stream.str();
+    }
+
+}
+
+cold::DifferentialChecker::DifferentialChecker(const std::vector<cold::Instruction>& program, const u64 memorySize, const std::string& engineA, const std::string& engineB)
+    : mSides()
+    , mBlockCount(0)
+{
+    const std::string* engines[] = { &engineA, &engineB };
+
+    for (u32 i = 0; i < 2; i++) {
+        mSides[i].vm = std::make_unique<cold::VirtualMachine>(program, memorySize);
+        mSides[i].vm->setEngine(cold::Engine::create(*engines[i]));
+        mSides[i].vm->getProcessor().setOutput(&mSides[i].output);
+    }
+}
+
+std::optional<cold::DifferentialChecker::Divergence> cold::DifferentialChecker::run(const u64 maxInstructions) {
+    u64 remaining = maxInstructions;
+
+    // Full snapshots copy the page table, so they are only taken now and then as a point to replay a divergence from
+    std::optional<cold::VirtualMachine::Snapshot> baseA;
+    std::optional<cold::VirtualMachine::Snapshot> baseB;
+    u64 baseRemaining = 0;
+    u64 blocksSinceBase = 0;
+
+    while (remaining > 0 && !mSides[0].vm->isFinished() && !mFault.has_value()) {
+        if (!baseA.has_value() || blocksSinceBase == cSnapshotInterval) {
+            baseA = mSides[0].vm->snapshot();
+            baseB = mSides[1].vm->snapshot();
+            baseRemaining = remaining;
+            blocksSinceBase = 0;
+        } else {
+            // Restarts dirty tracking, so only pages written by this block get hashed
+            for (Side& side : mSides) {
+                side.vm->getMemory().clearDirtyPages();
+            }
+        }
+
+        for (Side& side : mSides) {
+            this->step(side, remaining, true);
+        }
+
+        mBlockCount++;
+        blocksSinceBase++;
+
+        if (this->compare().has_value()) {
+            return this->locate(*baseA, *baseB, blocksSinceBase - 1, baseRemaining, mSides[0].executed + 1);
+        }
+
+        mFault = mSides[0].fault;
+        remaining -= std::min(remaining, mSides[0].executed);
+    }
+
+    return std::nullopt;
+}
+
+void cold::DifferentialChecker::step(Side& side, const u64 maxInstructions, const bool wholeBlock) {
+    side.output.str("");
+    side.fault.reset();
+    side.executed = 0;
+
+    try {
+        side.executed = wholeBlock ? side.vm->executeBlock(maxInstructions) : side.vm->execute(maxInstructions);
+    } catch (const std::exception& e) {
+        side.fault = e.what();
+    }
+}
+
+std::optional<std::string> cold::DifferentialChecker::compare() {
+    cold::VirtualMachine& a = *mSides[0].vm;
+    cold::VirtualMachine& b = *mSides[1].vm;
+    const std::string nameA = a.getEngine().getName();
+    const std::string nameB = b.getEngine().getName();
+
+    const auto mismatch = [&](const std::string& what, const std::string& valueA, const std::string& valueB) {
+        return what + " differs, " + nameA + ": " + valueA + ", " + nameB + ": " + valueB;
+    };
+
+    if (mSides[0].fault != mSides[1].fault) {
+        return mismatch("fault", mSides[0].fault.value_or("none"), mSides[1].fault.value_or("none"));
+    }
+
+    if (!mSides[0].fault.has_value() && mSides[0].executed != mSides[1].executed) {
+        return mismatch("instruction count", std::to_string(mSides[0].executed), std::to_string(mSides[1].executed));
+    }
+
+    if (a.isFinished() != b.isFinished()) {
+        return mismatch("halt state", a.isFinished() ? "halted" : "running", b.isFinished() ? "halted" : "running");
+    }
+
+    cold::Processor::Registers& registersA = a.getProcessor().getRegisters();
+    cold::Processor::Registers& registersB = b.getProcessor().getRegisters();
+
+    if (registersA.pc != registersB.pc) {
+        return mismatch("pc", hex(registersA.pc), hex(registersB.pc));
+    }
+
+    if (registersA.lr != registersB.lr) {
+        return mismatch("lr", hex(registersA.lr), hex(registersB.lr));
+    }
+
+    using Flags = cold::Processor::Registers::CompareRegister::Flags;
+    for (const Flags flag : { Flags::GreaterThan, Flags::LessThan, Flags::Equal }) {
+        if ((registersA.cr & flag) != (registersB.cr & flag)) {
+            return mismatch("cr", hex(registersA.cr & flag), hex(registersB.cr & flag));
+        }
+    }
+
+    for (u32 i = 0; i < cold::Processor::Registers::GPRArray::cGPRCount; i++) {
+        if (registersA.gpr[i] != registersB.gpr[i]) {
+            return mismatch("r" + std::to_string(i), hex(registersA.gpr[i]), hex(registersB.gpr[i]));
+        }
+    }
+
+    if (mSides[0].output.str() != mSides[1].output.str()) {
+        return mismatch("output", "\"" + mSides[0].output.str() + "\"", "\"" + mSides[1].output.str() + "\"");
+    }
+
+    // Pages either side wrote since the last snapshot are the only ones that can differ
+    const std::vector<u32> dirtyA = a.getMemory().getDirtyPages();
+    const std::vector<u32> dirtyB = b.getMemory().getDirtyPages();
+
+    std::vector<u32> dirty;
+    std::set_union(dirtyA.begin(), dirtyA.end(), dirtyB.begin(), dirtyB.end(), std::back_inserter(dirty));
+
+    const u64 hashA = a.getMemory().hashPages(dirty);
+    const u64 hashB = b.getMemory().hashPages(dirty);
+    if (hashA != hashB) {
+        std::stringstream stream;
+        stream << "memory hash of " << dirty.size() << " written pages";
+        return mismatch(stream.str(), hex(static_cast<u32>(hashA)), hex(static_cast<u32>(hashB)));
+    }
+
+    return std::nullopt;
+}
+
+cold::DifferentialChecker::Divergence cold::DifferentialChecker::locate(const cold::VirtualMachine::Snapshot& snapshotA, const cold::VirtualMachine::Snapshot& snapshotB, const u64 blocks, u64 remaining, const u64 maxSteps) {
+    mSides[0].vm->restore(snapshotA);
+    mSides[1].vm->restore(snapshotB);
+
+    // The blocks between the snapshot and the diverging one agreed, replaying them with the same budgets ends where it began
+    for (u64 i = 0; i < blocks; i++) {
+        for (Side& side : mSides) {
+            this->step(side, remaining, true);
+        }
+
+        remaining -= std::min(remaining, mSides[0].executed);
+    }
+
+    const u32 blockPc = mSides[0].vm->getProcessor().getRegisters().pc;
+
+    // Replay the diverging block one instruction at a time
+    for (u64 i = 0; i < maxSteps; i++) {
+        const u32 pc = mSides[0].vm->getProcessor().getRegisters().pc;
+
+        for (Side& side : mSides) {
+            side.vm->getMemory().clearDirtyPages();
+        }
+
+        for (Side& side : mSides) {
+            this->step(side, 1, false);
+        }
+
+        if (std::optional<std::string> difference = this->compare()) {
+            return { .pc = pc, .description = *difference };
+        }
+
+        if (mSides[0].fault.has_value() || mSides[0].vm->isFinished()) {
+            break;
+        }
+    }
+
+    // Only reachable when an engine behaves differently in single steps than in whole blocks
+    return { .pc = blockPc, .description = "block diverged but no single instruction did" };
+}
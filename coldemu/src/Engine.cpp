@@ -0,0 +1,27 @@
+#include "Cold/Engine.h"
+#include "Cold/AotEngine.h"
+#include "Cold/InterpreterEngine.h"
+#include "Cold/PredecodedEngine.h"
+#include "Cold/TieredEngine.h"
+
+#include <stdexcept>
+
+std::unique_ptr<cold::Engine> cold::Engine::create(const std::string& name) {
+    if (name == "interpreter") {
+        return std::make_unique<InterpreterEngine>();
+    }
+
+    if (name == "predecoded") {
+        return std::make_unique<PredecodedEngine>();
+    }
+
+    if (name == "tiered") {
+        return std::make_unique<TieredEngine>();
+    }
+
+    if (name.starts_with(AotEngine::cNamePrefix)) {
+        return std::make_unique<AotEngine>(name.substr(std::string(AotEngine::cNamePrefix).size()));
+    }
+
+    throw std::runtime_error("Unknown engine: " + name);
+}
@@ -0,0 +1,234 @@
+#include "Cold/Executable.h"
+
+#include <stdexcept>
+
+namespace {
+
+    // Header: magic, version, entry, data address and section count, followed by a (type, offset, size) entry per section
+    constexpr std::size_t cHeaderSize = 5 * sizeof(u32);
+    constexpr std::size_t cSectionEntrySize = 3 * sizeof(u32);
+
+    // Everything in the container is big-endian, like the instructions
+    class Reader {
+    public:
+        Reader(const std::span<const u8> bytes) : mBytes(bytes), mOffset(0) {}
+
+        [[nodiscard]] u8 readU8() {
+            this->require(1);
+            return mBytes[mOffset++];
+        }
+
+        [[nodiscard]] u32 readU32() {
+            this->require(sizeof(u32));
+
+            const u32 value = (u32)mBytes[mOffset] << 24 | (u32)mBytes[mOffset + 1] << 16 | (u32)mBytes[mOffset + 2] << 8 | mBytes[mOffset + 3];
+            mOffset += sizeof(u32);
+
+            return value;
+        }
+
+        // Element count of a table, rejected when the rest of the input could not hold that many entries of the smallest size
+        [[nodiscard]] u32 readCount(const std::size_t minEntrySize) {
+            const u32 count = this->readU32();
+            if (count > (mBytes.size() - mOffset) / minEntrySize) [[unlikely]] {
+                throw std::runtime_error("Executable table count out of range");
+            }
+
+            return count;
+        }
+
+        [[nodiscard]] std::span<const u8> readBytes(const std::size_t length) {
+            this->require(length);
+
+            const std::span<const u8> bytes = mBytes.subspan(mOffset, length);
+            mOffset += length;
+
+            return bytes;
+        }
+
+    private:
+        void require(const std::size_t length) const {
+            if (length > mBytes.size() - mOffset) [[unlikely]] {
+                throw std::runtime_error("Truncated executable");
+            }
+        }
+
+        std::span<const u8> mBytes;
+        std::size_t mOffset;
+    };
+
+    void writeU32(std::vector<u8>& out, const u32 value) {
+        out.push_back(value >> 24 & 0xFF);
+        out.push_back(value >> 16 & 0xFF);
+        out.push_back(value >> 8 & 0xFF);
+        out.push_back(value & 0xFF);
+    }
+
+    std::vector<cold::Instruction> loadCode(const std::span<const u8> bytes) {
+        std::vector<cold::Instruction> code;
+        code.reserve(bytes.size() / sizeof(cold::Instruction));
+
+        for (std::size_t offset = 0; offset + sizeof(cold::Instruction) <= bytes.size(); offset += sizeof(cold::Instruction)) {
+            code.push_back(cold::Instruction::fromBigEndian(bytes.data() + offset));
+        }
+
+        return code;
+    }
+
+}
+
+bool cold::Executable::isContainer(const std::span<const u8> image) {
+    return image.size() >= sizeof(u32) && Reader(image).readU32() == cMagic;
+}
+
+cold::Executable cold::Executable::load(const std::span<const u8> image) {
+    Executable executable;
+
+    if (!isContainer(image)) {
+        executable.code = loadCode(image);
+        executable.dataAddress = static_cast<u32>(executable.code.size() * sizeof(cold::Instruction));
+
+        return executable;
+    }
+
+    Reader header(image);
+    (void)header.readU32();
+
+    const u32 version = header.readU32();
+    if (version != cVersion) [[unlikely]] {
+        throw std::runtime_error("Unsupported executable version " + std::to_string(version));
+    }
+
+    executable.entry = header.readU32();
+    executable.dataAddress = header.readU32();
+
+    const u32 sectionCount = header.readU32();
+    for (u32 i = 0; i < sectionCount; i++) {
+        const u32 type = header.readU32();
+        const u32 offset = header.readU32();
+        const u32 size = header.readU32();
+
+        if (offset > image.size() || size > image.size() - offset) [[unlikely]] {
+            throw std::runtime_error("Executable section out of range");
+        }
+
+        const std::span<const u8> bytes = image.subspan(offset, size);
+        Reader section(bytes);
+
+        // Unknown sections are skipped so newer tools can add some without a version bump
+        switch (SectionType(type)) {
+            case SectionType::Code: {
+                executable.code = loadCode(bytes);
+                break;
+            }
+
+            case SectionType::Data: {
+                executable.data.assign(bytes.begin(), bytes.end());
+                break;
+            }
+
+            case SectionType::Symbols: {
+                // Value, kind and name length
+                executable.symbols.resize(section.readCount(sizeof(u32) + 2));
+                for (Symbol& symbol : executable.symbols) {
+                    symbol.value = section.readU32();
+                    symbol.kind = SymbolKind(section.readU8());
+
+                    const std::span<const u8> name = section.readBytes(section.readU8());
+                    symbol.name.assign(name.begin(), name.end());
+                }
+
+                break;
+            }
+
+            case SectionType::Blocks: {
+                executable.blockStarts.resize(section.readCount(sizeof(u32)));
+                for (u32& blockStart : executable.blockStarts) {
+                    blockStart = section.readU32();
+                }
+
+                break;
+            }
+
+            default: break;
+        }
+    }
+
+    if (executable.dataAddress < executable.code.size() * sizeof(cold::Instruction)) [[unlikely]] {
+        throw std::runtime_error("Executable data overlaps its code");
+    }
+
+    return executable;
+}
+
+std::vector<u8> cold::Executable::serialize() const {
+    std::vector<std::pair<SectionType, std::vector<u8>>> sections;
+
+    {
+        std::vector<u8> bytes;
+        bytes.reserve(code.size() * sizeof(cold::Instruction));
+
+        for (const cold::Instruction& instr : code) {
+            writeU32(bytes, instr.getData());
+        }
+
+        sections.emplace_back(SectionType::Code, std::move(bytes));
+    }
+
+    if (!data.empty()) {
+        sections.emplace_back(SectionType::Data, data);
+    }
+
+    if (!symbols.empty()) {
+        std::vector<u8> bytes;
+        writeU32(bytes, static_cast<u32>(symbols.size()));
+
+        for (const Symbol& symbol : symbols) {
+            if (symbol.name.size() > 0xFF) [[unlikely]] {
+                throw std::runtime_error("Symbol name too long: " + symbol.name);
+            }
+
+            writeU32(bytes, symbol.value);
+            bytes.push_back(static_cast<u8>(symbol.kind));
+            bytes.push_back(static_cast<u8>(symbol.name.size()));
+            bytes.insert(bytes.end(), symbol.name.begin(), symbol.name.end());
+        }
+
+        sections.emplace_back(SectionType::Symbols, std::move(bytes));
+    }
+
+    if (!blockStarts.empty()) {
+        std::vector<u8> bytes;
+        writeU32(bytes, static_cast<u32>(blockStarts.size()));
+
+        for (const u32 blockStart : blockStarts) {
+            writeU32(bytes, blockStart);
+        }
+
+        sections.emplace_back(SectionType::Blocks, std::move(bytes));
+    }
+
+    std::vector<u8> out;
+    writeU32(out, cMagic);
+    writeU32(out, cVersion);
+    writeU32(out, entry);
+    writeU32(out, dataAddress);
+    writeU32(out, static_cast<u32>(sections.size()));
+
+    // Sections follow the table in order, each starting on a word boundary
+    std::size_t offset = cHeaderSize + sections.size() * cSectionEntrySize;
+    for (const auto& [type, bytes] : sections) {
+        writeU32(out, static_cast<u32>(type));
+        writeU32(out, static_cast<u32>(offset));
+        writeU32(out, static_cast<u32>(bytes.size()));
+
+        offset += (bytes.size() + 3) & ~std::size_t(3);
+    }
+
+    for (const auto& [type, bytes] : sections) {
+        out.insert(out.end(), bytes.begin(), bytes.end());
+        out.resize((out.size() + 3) & ~std::size_t(3), 0);
+    }
+
+    return out;
+}
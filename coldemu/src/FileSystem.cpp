@@ -0,0 +1,164 @@
+#include "Cold/FileSystem.h"
+#include "Cold/MappedFile.h"
+#include "Cold/Memory.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+cold::FileSystem::FileSystem(const std::filesystem::path& root)
+    : mRoot()
+    , mFiles()
+{
+    std::error_code error;
+    mRoot = std::filesystem::canonical(root, error);
+
+    if (error || !std::filesystem::is_directory(mRoot)) {
+        throw std::runtime_error("Sandbox directory does not exist: " + root.string());
+    }
+}
+
+cold::FileSystem::~FileSystem() {
+    for (const OpenFile& file : mFiles) {
+        if (file.file != nullptr) {
+            std::fclose(file.file);
+        }
+    }
+}
+
+std::optional<u32> cold::FileSystem::open(const std::string& path, const OpenMode mode) {
+    const std::optional<std::filesystem::path> resolved = this->resolve(path);
+    if (!resolved.has_value()) {
+        return std::nullopt;
+    }
+
+    const char* modeString;
+    switch (mode) {
+        case OpenMode::Read: modeString = "rb"; break;
+        case OpenMode::Write: modeString = "wb"; break;
+        case OpenMode::Append: modeString = "ab"; break;
+        default: return std::nullopt;
+    }
+
+    // Reuse the lowest free descriptor like POSIX does
+    auto slot = std::find_if(mFiles.begin(), mFiles.end(), [](const OpenFile& file) {
+        return file.file == nullptr;
+    });
+
+    if (slot == mFiles.end()) {
+        if (mFiles.size() >= cMaxOpenFiles) {
+            return std::nullopt;
+        }
+
+        mFiles.push_back({ .file = nullptr, .path = {} });
+        slot = mFiles.end() - 1;
+    }
+
+    std::FILE* file = std::fopen(resolved->string().c_str(), modeString);
+    if (file == nullptr) {
+        return std::nullopt;
+    }
+
+    *slot = { .file = file, .path = *resolved };
+    return static_cast<u32>(slot - mFiles.begin());
+}
+
+std::optional<u32> cold::FileSystem::read(const u32 fd, u8* data, const u32 length) {
+    OpenFile* file = this->getFile(fd);
+    if (file == nullptr) {
+        return std::nullopt;
+    }
+
+    const std::size_t count = std::fread(data, 1, length, file->file);
+    if (count == 0 && std::ferror(file->file)) {
+        std::clearerr(file->file);
+        return std::nullopt;
+    }
+
+    return static_cast<u32>(count);
+}
+
+std::optional<u32> cold::FileSystem::write(const u32 fd, const u8* data, const u32 length) {
+    OpenFile* file = this->getFile(fd);
+    if (file == nullptr) {
+        return std::nullopt;
+    }
+
+    const std::size_t count = std::fwrite(data, 1, length, file->file);
+    if (count == 0 && length != 0) {
+        std::clearerr(file->file);
+        return std::nullopt;
+    }
+
+    return static_cast<u32>(count);
+}
+
+bool cold::FileSystem::close(const u32 fd) {
+    OpenFile* file = this->getFile(fd);
+    if (file == nullptr) {
+        return false;
+    }
+
+    const bool closed = std::fclose(file->file) == 0;
+    *file = { .file = nullptr, .path = {} };
+
+    return closed;
+}
+
+std::optional<cold::FileSystem::Mapping> cold::FileSystem::map(const u32 fd, const u32 offset, const u32 length) {
+    OpenFile* file = this->getFile(fd);
+    if (file == nullptr || offset % cold::Memory::cPageSize != 0) {
+        return std::nullopt;
+    }
+
+    // Buffered writes must reach the file before it is mapped
+    std::fflush(file->file);
+
+    std::error_code error;
+    const u64 fileSize = std::filesystem::file_size(file->path, error);
+    if (error || offset >= fileSize) {
+        return std::nullopt;
+    }
+
+    const u64 available = fileSize - offset;
+    const u32 mappedLength = static_cast<u32>(length == 0 ? std::min<u64>(available, ~0u) : std::min<u64>(available, length));
+
+    const u64 granularity = cold::MappedFile::getGranularity();
+    const u64 viewOffset = offset / granularity * granularity;
+    const u64 skipped = offset - viewOffset;
+
+    const std::shared_ptr<const u8> view = cold::MappedFile::mapView(file->file, viewOffset, skipped + mappedLength);
+    if (view == nullptr) {
+        return std::nullopt;
+    }
+
+    return Mapping{ .data = std::shared_ptr<const u8>(view, view.get() + skipped), .length = mappedLength };
+}
+
+std::optional<std::filesystem::path> cold::FileSystem::resolve(const std::string& path) const {
+    const std::filesystem::path relative(path);
+    if (path.empty() || relative.is_absolute() || relative.has_root_name()) {
+        return std::nullopt;
+    }
+
+    // Symbolic links are resolved before the check, so they cannot lead out of the sandbox either
+    std::error_code error;
+    const std::filesystem::path resolved = std::filesystem::weakly_canonical(mRoot / relative, error);
+    if (error) {
+        return std::nullopt;
+    }
+
+    const auto [rootEnd, unused] = std::mismatch(mRoot.begin(), mRoot.end(), resolved.begin(), resolved.end());
+    if (rootEnd != mRoot.end()) {
+        return std::nullopt;
+    }
+
+    return resolved;
+}
+
+cold::FileSystem::OpenFile* cold::FileSystem::getFile(const u32 fd) {
+    if (fd >= mFiles.size() || mFiles[fd].file == nullptr) {
+        return nullptr;
+    }
+
+    return &mFiles[fd];
+}
@@ -0,0 +1,791 @@
+#include "Cold/GdbStub.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+#else
+    #include <arpa/inet.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <sys/select.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+    constexpr std::intptr_t cInvalidSocket = -1;
+    constexpr u64 cChunkSize = 1 << 20; // Instructions between checks for an interrupt from the debugger
+    constexpr u32 cPacketSize = 0x4000; // Advertised in qSupported, memory replies take two characters per byte
+    constexpr u32 cRegisterCount = cold::Processor::Registers::GPRArray::cGPRCount + 3; // GPRs, PC, LR, CR
+    constexpr u32 cPcRegister = cold::Processor::Registers::GPRArray::cGPRCount;
+    constexpr u32 cLrRegister = cPcRegister + 1;
+    constexpr u32 cCrRegister = cPcRegister + 2;
+
+    // PC and LR hold instruction indices but are presented to the debugger as byte addresses
+    const std::string cTargetDescription = [] {
+        std::string xml = "<?xml version=\"1.0\"?><!DOCTYPE target SYSTEM \"gdb-target.dtd\"><target version=\"1.0\"><feature name=\"org.cold.core\">";
+        for (u32 i = 0; i < cold::Processor::Registers::GPRArray::cGPRCount; i++) {
+            xml += "<reg name=\"r" + std::to_string(i) + "\" bitsize=\"32\" type=\"" + (i == 0 ? "data_ptr" : "uint32") + "\"/>";
+        }
+        xml += "<reg name=\"pc\" bitsize=\"32\" type=\"code_ptr\"/><reg name=\"lr\" bitsize=\"32\" type=\"code_ptr\"/><reg name=\"cr\" bitsize=\"32\" type=\"uint32\"/>";
+        xml += "</feature></target>";
+        return xml;
+    }();
+
+#ifdef _WIN32
+    void closeSocket(const std::intptr_t socket) {
+        ::closesocket(static_cast<SOCKET>(socket));
+    }
+#else
+    void closeSocket(const std::intptr_t socket) {
+        ::close(static_cast<int>(socket));
+    }
+#endif
+
+    std::intptr_t openListener(const std::string& endpoint) {
+#ifdef _WIN32
+        WSADATA data;
+        if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+            throw std::runtime_error("Failed to initialize sockets");
+        }
+#endif
+
+        const bool tcp = !endpoint.empty() && endpoint.find_first_not_of("0123456789") == std::string::npos;
+
+        std::intptr_t listener = cInvalidSocket;
+        int result = -1;
+
+        if (tcp) {
+            if (endpoint.size() > 5 || std::stoul(endpoint) > 0xFFFF) {
+                throw std::runtime_error("Port out of range");
+            }
+
+            listener = static_cast<std::intptr_t>(::socket(AF_INET, SOCK_STREAM, 0));
+            if (listener == cInvalidSocket) {
+                throw std::runtime_error("Failed to create socket");
+            }
+
+            const int reuse = 1;
+            ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+            // Only local debuggers may connect
+            sockaddr_in address = {};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(static_cast<u16>(std::stoul(endpoint)));
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            result = ::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+        } else {
+#ifdef _WIN32
+            throw std::runtime_error("Unix sockets are not supported on this platform");
+#else
+            sockaddr_un address = {};
+            if (endpoint.size() >= sizeof(address.sun_path)) {
+                throw std::runtime_error("Socket path too long");
+            }
+
+            listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (listener == cInvalidSocket) {
+                throw std::runtime_error("Failed to create socket");
+            }
+
+            address.sun_family = AF_UNIX;
+            endpoint.copy(address.sun_path, endpoint.size());
+            ::unlink(endpoint.c_str()); // Left behind by an earlier session
+
+            result = ::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+#endif
+        }
+
+        if (result != 0 || ::listen(listener, 1) != 0) {
+            closeSocket(listener);
+            throw std::runtime_error("Failed to listen on " + endpoint);
+        }
+
+        return listener;
+    }
+
+    bool hasPendingData(const std::intptr_t socket) {
+        fd_set set;
+        FD_ZERO(&set);
+        FD_SET(socket, &set);
+
+        timeval timeout = {};
+        return ::select(static_cast<int>(socket) + 1, &set, nullptr, nullptr, &timeout) > 0;
+    }
+
+    // Returns the number of bytes appended, zero once the connection is closed
+    std::size_t receiveInto(const std::intptr_t socket, std::string& buffer) {
+        char data[4096];
+        const auto received = ::recv(socket, data, sizeof(data), 0);
+        if (received <= 0) {
+            return 0;
+        }
+
+        buffer.append(data, static_cast<std::size_t>(received));
+        return static_cast<std::size_t>(received);
+    }
+
+    std::optional<u32> parseHex(const std::string_view text) {
+        u32 value = 0;
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value, 16);
+        if (error != std::errc() || end != text.data() + text.size() || text.empty()) {
+            return std::nullopt;
+        }
+
+        return value;
+    }
+
+    std::string toHex(const u32 value, const int digits) {
+        char text[9];
+        std::snprintf(text, sizeof(text), "%0*x", digits, value);
+        return text;
+    }
+
+    // Binary replies must not contain the framing characters
+    std::string escape(const std::string_view data) {
+        std::string escaped;
+        escaped.reserve(data.size());
+
+        for (const char c : data) {
+            if (c == '#' || c == '$' || c == '}' || c == '*') {
+                escaped += '}';
+                escaped += static_cast<char>(c ^ 0x20);
+            } else {
+                escaped += c;
+            }
+        }
+
+        return escaped;
+    }
+
+    // Signal numbers as GDB expects them in stop replies
+    std::string faultReply(const std::exception& e) {
+        std::cerr << "Guest fault: " << e.what() << std::endl;
+
+        return std::string(e.what()) == "Invalid instruction type" ? "S04" : "S0b"; // SIGILL, SIGSEGV
+    }
+
+}
+
+cold::GdbStub::GdbStub(cold::VirtualMachine& vm, const std::string& endpoint)
+    : mVM(&vm)
+    , mEngine(nullptr)
+    , mListener(cInvalidSocket)
+    , mConnection(cInvalidSocket)
+    , mReceived()
+    , mLastReply()
+    , mWatchpoints()
+    , mStopPc(vm.getProcessor().getRegisters().pc)
+    , mAcknowledge(true)
+    , mDetached(false)
+{
+    // Breakpoints are patched into the decoded stream, so the debugged machine always runs predecoded
+    auto engine = std::make_unique<cold::PredecodedEngine>();
+    mEngine = engine.get();
+    mVM->setEngine(std::move(engine));
+
+    mListener = openListener(endpoint);
+
+    std::cerr << "Waiting for a debugger on " << endpoint << std::endl;
+
+    mConnection = static_cast<std::intptr_t>(::accept(mListener, nullptr, nullptr));
+    if (mConnection == cInvalidSocket) {
+        closeSocket(mListener);
+        throw std::runtime_error("Failed to accept debugger connection");
+    }
+
+    // Every stop is a small request and reply round trip, fails harmlessly on unix sockets
+    const int noDelay = 1;
+    ::setsockopt(mConnection, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+}
+
+cold::GdbStub::~GdbStub() {
+    closeSocket(mConnection);
+    closeSocket(mListener);
+}
+
+bool cold::GdbStub::serve() {
+    while (const std::optional<std::string> packet = this->receivePacket()) {
+        if (*packet == "k") {
+            return false;
+        }
+
+        this->sendPacket(this->handlePacket(*packet));
+
+        if (mDetached) {
+            mEngine->clearBreakpoints();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::optional<std::string> cold::GdbStub::receivePacket() {
+    while (true) {
+        const std::size_t start = mReceived.find('$');
+
+        // Acknowledgements and stray interrupts precede the packet, a rejection asks for the last reply again
+        const std::size_t skipped = start == std::string::npos ? mReceived.size() : start;
+        if (mAcknowledge && mReceived.find('-') < skipped) {
+            this->sendRaw(mLastReply);
+        }
+        mReceived.erase(0, skipped);
+
+        const std::size_t end = mReceived.find('#');
+        if (end != std::string::npos && mReceived.size() >= end + 3) {
+            const std::string payload = mReceived.substr(1, end - 1);
+            const std::optional<u32> checksum = parseHex(std::string_view(mReceived).substr(end + 1, 2));
+            mReceived.erase(0, end + 3);
+
+            u8 sum = 0;
+            for (const char c : payload) {
+                sum += static_cast<u8>(c);
+            }
+
+            const bool valid = checksum == sum;
+            if (mAcknowledge) {
+                this->sendRaw(valid ? "+" : "-");
+            }
+
+            if (valid) {
+                return payload;
+            }
+
+            continue;
+        }
+
+        if (receiveInto(mConnection, mReceived) == 0) {
+            return std::nullopt;
+        }
+    }
+}
+
+void cold::GdbStub::sendPacket(const std::string& data) {
+    u8 sum = 0;
+    for (const char c : data) {
+        sum += static_cast<u8>(c);
+    }
+
+    mLastReply = "$" + data + "#" + toHex(sum, 2);
+    this->sendRaw(mLastReply);
+}
+
+void cold::GdbStub::sendRaw(const std::string& data) {
+    std::size_t sent = 0;
+    while (sent < data.size()) {
+        const auto result = ::send(mConnection, data.data() + sent, static_cast<int>(data.size() - sent), 0);
+        if (result <= 0) {
+            return; // The next receive notices the closed connection
+        }
+
+        sent += static_cast<std::size_t>(result);
+    }
+}
+
+bool cold::GdbStub::pollInterrupt() {
+    if (!hasPendingData(mConnection)) {
+        return false;
+    }
+
+    // A closed connection also stops the machine, the following receive then ends the session
+    if (receiveInto(mConnection, mReceived) == 0) {
+        return true;
+    }
+
+    const std::size_t interrupt = mReceived.find('\x03');
+    if (interrupt == std::string::npos) {
+        return false;
+    }
+
+    mReceived.erase(interrupt, 1);
+    return true;
+}
+
+std::string cold::GdbStub::handlePacket(const std::string& packet) {
+    if (packet.empty()) [[unlikely]] {
+        return "";
+    }
+
+    const std::string_view arguments = std::string_view(packet).substr(1);
+
+    switch (packet[0]) {
+        case '?':
+            return mVM->isFinished() ? "W00" : "S05";
+
+        case 'g':
+            return this->readRegisters();
+
+        case 'G':
+            return this->writeRegisters(std::string(arguments)) ? "OK" : "E01";
+
+        case 'p': {
+            const std::optional<u32> index = parseHex(arguments);
+            const std::optional<u32> value = index.has_value() ? this->readRegister(*index) : std::nullopt;
+            return value.has_value() ? toHex(*value, 8) : "E01";
+        }
+
+        case 'P': {
+            const std::size_t separator = arguments.find('=');
+            const std::optional<u32> index = parseHex(arguments.substr(0, separator));
+            const std::optional<u32> value = separator != std::string_view::npos ? parseHex(arguments.substr(separator + 1)) : std::nullopt;
+            return index.has_value() && value.has_value() && this->writeRegister(*index, *value) ? "OK" : "E01";
+        }
+
+        case 'm': {
+            const std::size_t separator = arguments.find(',');
+            const std::optional<u32> address = parseHex(arguments.substr(0, separator));
+            const std::optional<u32> length = separator != std::string_view::npos ? parseHex(arguments.substr(separator + 1)) : std::nullopt;
+            if (!address.has_value() || !length.has_value()) {
+                return "E01";
+            }
+
+            // Longer requests are answered partially, which the debugger continues from
+            const u32 count = std::min(*length, cPacketSize / 2);
+            const std::string data = this->readMemory(*address, count);
+            return data.empty() && count != 0 ? "E01" : data;
+        }
+
+        case 'M': {
+            const std::size_t comma = arguments.find(',');
+            const std::size_t colon = arguments.find(':');
+            const std::optional<u32> address = parseHex(arguments.substr(0, comma));
+            if (!address.has_value() || comma == std::string_view::npos || colon == std::string_view::npos) {
+                return "E01";
+            }
+
+            return this->writeMemory(*address, std::string(arguments.substr(colon + 1))) ? "OK" : "E01";
+        }
+
+        case 'c':
+        case 's':
+            if (!arguments.empty()) {
+                const std::optional<u32> address = parseHex(arguments);
+                if (!address.has_value()) {
+                    return "E01";
+                }
+
+                mVM->getProcessor().getRegisters().pc = *address / sizeof(cold::Instruction);
+            }
+
+            return this->resume(packet[0] == 's');
+
+        case 'Z':
+        case 'z':
+            return this->handleBreakpoint(packet, packet[0] == 'Z');
+
+        case 'q':
+            return this->handleQuery(packet);
+
+        case 'Q':
+            if (packet == "QStartNoAckMode") {
+                mAcknowledge = false;
+                return "OK";
+            }
+
+            return "";
+
+        case 'v':
+            if (packet == "vCont?") {
+                return "vCont;c;C;s;S";
+            }
+
+            // There is a single thread, so only the first action matters
+            if (packet.starts_with("vCont;") && packet.size() > 6) {
+                const char action = packet[6];
+                if (action == 'c' || action == 'C' || action == 's' || action == 'S') {
+                    return this->resume(action == 's' || action == 'S');
+                }
+            }
+
+            return "";
+
+        case 'H':
+        case 'T':
+            return "OK";
+
+        case 'D':
+            mDetached = true;
+            return "OK";
+
+        default:
+            return "";
+    }
+}
+
+std::string cold::GdbStub::handleQuery(const std::string& packet) {
+    if (packet.starts_with("qSupported")) {
+        return "PacketSize=" + toHex(cPacketSize, 4) + ";qXfer:features:read+;swbreak+;QStartNoAckMode+";
+    }
+
+    if (packet == "qAttached") {
+        return "1";
+    }
+
+    if (packet == "qC") {
+        return "QC1";
+    }
+
+    if (packet == "qfThreadInfo") {
+        return "m1";
+    }
+
+    if (packet == "qsThreadInfo") {
+        return "l";
+    }
+
+    const std::string_view xfer = "qXfer:features:read:target.xml:";
+    if (packet.starts_with(xfer)) {
+        const std::string_view range = std::string_view(packet).substr(xfer.size());
+        const std::size_t separator = range.find(',');
+        const std::optional<u32> offset = parseHex(range.substr(0, separator));
+        const std::optional<u32> length = separator != std::string_view::npos ? parseHex(range.substr(separator + 1)) : std::nullopt;
+        if (!offset.has_value() || !length.has_value()) {
+            return "E01";
+        }
+
+        if (*offset >= cTargetDescription.size()) {
+            return "l";
+        }
+
+        const std::string_view chunk = std::string_view(cTargetDescription).substr(*offset, *length);
+        return (*offset + chunk.size() < cTargetDescription.size() ? "m" : "l") + escape(chunk);
+    }
+
+    return "";
+}
+
+std::string cold::GdbStub::handleBreakpoint(const std::string& packet, const bool insert) {
+    // Z<type>,<address>,<kind>
+    const std::string_view arguments = std::string_view(packet).substr(1);
+    const std::size_t first = arguments.find(',');
+    const std::size_t second = first != std::string_view::npos ? arguments.find(',', first + 1) : std::string_view::npos;
+    if (second == std::string_view::npos) {
+        return "E01";
+    }
+
+    const std::optional<u32> type = parseHex(arguments.substr(0, first));
+    const std::optional<u32> address = parseHex(arguments.substr(first + 1, second - first - 1));
+    const std::optional<u32> kind = parseHex(arguments.substr(second + 1, arguments.find(';', second) - second - 1));
+    if (!type.has_value() || !address.has_value() || !kind.has_value()) {
+        return "E01";
+    }
+
+    switch (*type) {
+        case 0:
+        case 1: {
+            if (*address % sizeof(cold::Instruction) != 0) {
+                return "E01";
+            }
+
+            const u32 pc = *address / sizeof(cold::Instruction);
+            if (insert) {
+                mEngine->insertBreakpoint(pc);
+            } else {
+                mEngine->removeBreakpoint(pc);
+            }
+
+            return "OK";
+        }
+
+        case 2:
+        case 3:
+        case 4: {
+            const WatchKind watchKind = *type == 2 ? WatchKind::Write : *type == 3 ? WatchKind::Read : WatchKind::Access;
+
+            // Writes are caught by the memory itself, reads by inspecting loads while stepping
+            const bool watchesWrites = watchKind != WatchKind::Read;
+
+            if (insert) {
+                mWatchpoints.push_back({ .address = *address, .length = *kind, .kind = watchKind });
+
+                if (watchesWrites) {
+                    mVM->getMemory().addWatchpoint(*address, *kind);
+                }
+            } else {
+                const std::size_t removed = std::erase_if(mWatchpoints, [&](const Watchpoint& watchpoint) {
+                    return watchpoint.address == *address && watchpoint.length == *kind && watchpoint.kind == watchKind;
+                });
+
+                for (std::size_t i = 0; watchesWrites && i < removed; i++) {
+                    mVM->getMemory().removeWatchpoint(*address, *kind);
+                }
+            }
+
+            return "OK";
+        }
+
+        default:
+            return "";
+    }
+}
+
+std::string cold::GdbStub::resume(const bool singleStep) {
+    cold::Processor::Registers& registers = mVM->getProcessor().getRegisters();
+
+    // A pc the debugger moved elsewhere stops at its breakpoint right away, like any other arrival
+    mEngine->setSkippedBreakpoint(mStopPc == registers.pc ? mStopPc : std::nullopt);
+
+    const std::string reply = this->runUntilStop(singleStep);
+    mStopPc = registers.pc;
+
+    return reply;
+}
+
+std::string cold::GdbStub::runUntilStop(const bool singleStep) {
+    if (mVM->isFinished()) {
+        return "W00";
+    }
+
+    cold::Processor::Registers& registers = mVM->getProcessor().getRegisters();
+
+    try {
+        // Watched reads are found by inspecting each instruction before it runs, everything else runs at full speed
+        if (singleStep || this->hasReadWatchpoints()) {
+            for (u64 steps = 1; ; steps++) {
+                const std::string watch = this->checkReadWatchpoints();
+
+                (void)mVM->execute(1);
+
+                if (mVM->isFinished()) {
+                    return "W00";
+                }
+
+                if (!watch.empty()) {
+                    return watch;
+                }
+
+                if (singleStep) {
+                    return "S05";
+                }
+
+                if (mEngine->hasBreakpoint(registers.pc)) {
+                    return "T05swbreak:;";
+                }
+
+                if (steps % cChunkSize == 0 && this->pollInterrupt()) {
+                    return "S02";
+                }
+            }
+        }
+
+        while (true) {
+            (void)mVM->execute(cChunkSize);
+
+            if (mVM->isFinished()) {
+                return "W00";
+            }
+
+            if (mEngine->isStoppedAtBreakpoint()) {
+                return "T05swbreak:;";
+            }
+
+            if (this->pollInterrupt()) {
+                return "S02";
+            }
+        }
+    } catch (const cold::WatchpointHit& hit) {
+        return this->completeWatchedWrite(hit.getAddress());
+    } catch (const std::exception& e) {
+        return faultReply(e);
+    }
+}
+
+std::string cold::GdbStub::completeWatchedWrite(const u32 address) {
+    cold::Memory& memory = mVM->getMemory();
+
+    // The store was stopped before modifying memory, so it is run again unwatched for the debugger to see the new value
+    memory.setWatchpointsEnabled(false);
+
+    try {
+        (void)mVM->execute(1);
+    } catch (const std::exception& e) {
+        memory.setWatchpointsEnabled(true);
+        return faultReply(e);
+    }
+
+    memory.setWatchpointsEnabled(true);
+
+    const auto watchpoint = std::find_if(mWatchpoints.begin(), mWatchpoints.end(), [address](const Watchpoint& candidate) {
+        return candidate.kind != WatchKind::Read && address - candidate.address < candidate.length;
+    });
+
+    const bool access = watchpoint != mWatchpoints.end() && watchpoint->kind == WatchKind::Access;
+    return std::string("T05") + (access ? "awatch" : "watch") + ":" + toHex(address, 1) + ";";
+}
+
+bool cold::GdbStub::hasReadWatchpoints() const {
+    return std::any_of(mWatchpoints.begin(), mWatchpoints.end(), [](const Watchpoint& watchpoint) {
+        return watchpoint.kind != WatchKind::Write;
+    });
+}
+
+std::string cold::GdbStub::checkReadWatchpoints() {
+    using Type = cold::Instruction::Type;
+
+    cold::Memory& memory = mVM->getMemory();
+    cold::Processor::Registers& registers = mVM->getProcessor().getRegisters();
+
+    const u32 pcAddress = registers.pc * 4;
+    if (pcAddress >= memory.getCodeSize()) {
+        return "";
+    }
+
+    const cold::Instruction instr = memory.readX(pcAddress);
+
+    u32 width = 0;
+    switch (Type(instr.getType())) {
+        case Type::LDB: width = 1; break;
+        case Type::LDH: width = 2; break;
+        case Type::LDW: width = 4; break;
+        default: return "";
+    }
+
+    const auto [reg, addrReg, offsetUnsigned] = instr.getTripleByteData();
+    if (addrReg >= cold::Processor::Registers::GPRArray::cGPRCount) {
+        return ""; // Faults when executed
+    }
+
+    const s8 offset = offsetUnsigned;
+    const u32 begin = registers.gpr[addrReg] + offset;
+
+    for (const Watchpoint& watchpoint : mWatchpoints) {
+        if (watchpoint.kind == WatchKind::Write) {
+            continue;
+        }
+
+        // Overlap test that holds across address wrap around
+        if (begin - watchpoint.address < watchpoint.length || watchpoint.address - begin < width) {
+            const char* name = watchpoint.kind == WatchKind::Read ? "rwatch" : "awatch";
+            return std::string("T05") + name + ":" + toHex(watchpoint.address, 1) + ";";
+        }
+    }
+
+    return "";
+}
+
+std::string cold::GdbStub::readRegisters() {
+    std::string data;
+    data.reserve(cRegisterCount * 8);
+
+    for (u32 i = 0; i < cRegisterCount; i++) {
+        data += toHex(*this->readRegister(i), 8);
+    }
+
+    return data;
+}
+
+bool cold::GdbStub::writeRegisters(const std::string& data) {
+    if (data.size() != cRegisterCount * 8) {
+        return false;
+    }
+
+    for (u32 i = 0; i < cRegisterCount; i++) {
+        const std::optional<u32> value = parseHex(std::string_view(data).substr(i * 8, 8));
+        if (!value.has_value() || !this->writeRegister(i, *value)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::optional<u32> cold::GdbStub::readRegister(const u32 index) {
+    cold::Processor::Registers& registers = mVM->getProcessor().getRegisters();
+
+    switch (index) {
+        case cPcRegister: return registers.pc * sizeof(cold::Instruction);
+        case cLrRegister: return registers.lr * sizeof(cold::Instruction);
+        case cCrRegister: return registers.cr.getFlags();
+
+        default:
+            if (index >= cRegisterCount) {
+                return std::nullopt;
+            }
+
+            return registers.gpr[index];
+    }
+}
+
+bool cold::GdbStub::writeRegister(const u32 index, const u32 value) {
+    cold::Processor::Registers& registers = mVM->getProcessor().getRegisters();
+
+    switch (index) {
+        case cPcRegister: registers.pc = value / sizeof(cold::Instruction); return true;
+        case cLrRegister: registers.lr = value / sizeof(cold::Instruction); return true;
+        case cCrRegister: registers.cr.setFlags(value); return true;
+
+        default:
+            if (index >= cRegisterCount) {
+                return false;
+            }
+
+            registers.gpr[index] = value;
+            return true;
+    }
+}
+
+std::string cold::GdbStub::readMemory(const u32 address, const u32 length) {
+    const cold::Memory& memory = mVM->getMemory();
+    std::string data;
+
+    // Stops at the first inaccessible byte, the debugger accepts partial reads
+    try {
+        for (u32 i = 0; i < length; i++) {
+            const u32 byteAddress = address + i;
+
+            u8 value;
+            if (byteAddress < memory.getCodeSize()) {
+                // Code is stored big endian like the rest of memory
+                const u32 word = memory.readX(byteAddress & ~3u).getData();
+                value = word >> (24 - (byteAddress & 3) * 8) & 0xFF;
+            } else {
+                value = memory.readRW(byteAddress);
+            }
+
+            data += toHex(value, 2);
+        }
+    } catch (const std::exception&) {
+    }
+
+    return data;
+}
+
+bool cold::GdbStub::writeMemory(const u32 address, const std::string& data) {
+    cold::Memory& memory = mVM->getMemory();
+
+    if (data.size() % 2 != 0) {
+        return false;
+    }
+
+    // Code is immutable, so only the read write region can be patched, debugger writes never trigger watchpoints
+    memory.setWatchpointsEnabled(false);
+    bool success = true;
+
+    try {
+        for (std::size_t i = 0; i < data.size() / 2; i++) {
+            const std::optional<u32> value = parseHex(std::string_view(data).substr(i * 2, 2));
+            if (!value.has_value()) {
+                success = false;
+                break;
+            }
+
+            memory.writeRW(address + static_cast<u32>(i)) = static_cast<u8>(*value);
+        }
+    } catch (const std::exception&) {
+        success = false;
+    }
+
+    memory.setWatchpointsEnabled(true);
+    return success;
+}
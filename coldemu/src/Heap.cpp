@@ -0,0 +1,268 @@
+#include "Cold/Heap.h"
+#include "Cold/Memory.h"
+#include "Cold/Varint.h"
+
+#include <algorithm>
+#include <bit>
+#include <sstream>
+#include <stdexcept>
+
+u32 cold::Heap::allocate(cold::Memory& memory, const u32 size, const u32 limit) {
+    mStatistics.allocations++;
+
+    return this->allocateBlock(memory, size, limit, mDebug);
+}
+
+void cold::Heap::free(cold::Memory& memory, const u32 address) {
+    if (address == 0) {
+        return;
+    }
+
+    const auto block = mBlocks.find(address);
+    if (block == mBlocks.end()) [[unlikely]] {
+        throw std::runtime_error("Invalid heap free");
+    }
+
+    mStatistics.frees++;
+    this->release(memory, block);
+}
+
+u32 cold::Heap::reallocate(cold::Memory& memory, const u32 address, const u32 size, const u32 limit) {
+    mStatistics.reallocations++;
+
+    if (address == 0) {
+        return this->allocateBlock(memory, size, limit, mDebug);
+    }
+
+    const auto block = mBlocks.find(address);
+    if (block == mBlocks.end() || block->second.mapped) [[unlikely]] {
+        throw std::runtime_error("Invalid heap reallocation");
+    }
+
+    if (size == 0) {
+        this->release(memory, block);
+        return 0;
+    }
+
+    Block& current = block->second;
+    if (current.guarded) {
+        this->checkGuards(memory, address, current);
+    }
+
+    // Resizing within the size class keeps the block in place
+    const u32 capacity = getBlockSize(current.sizeClass) - (current.guarded ? 2 * cGuardSize : 0);
+    if (size <= capacity) {
+        mStatistics.bytesInUse = mStatistics.bytesInUse - current.size + size;
+        mStatistics.peakBytesInUse = std::max(mStatistics.peakBytesInUse, mStatistics.bytesInUse);
+        current.size = size;
+
+        if (current.guarded) {
+            this->writeGuards(memory, address, current);
+        }
+
+        return address;
+    }
+
+    // The old block stays valid when the new one does not fit
+    const u32 moved = this->allocateBlock(memory, size, limit, mDebug);
+    if (moved == 0) {
+        return 0;
+    }
+
+    memory.copy(moved, address, std::min(size, mBlocks.at(address).size));
+
+    this->release(memory, mBlocks.find(address));
+    return moved;
+}
+
+u32 cold::Heap::allocateMapping(cold::Memory& memory, const u32 size, const u32 limit) {
+    mStatistics.allocations++;
+
+    const u32 address = this->allocateBlock(memory, std::max(size, cold::Memory::cPageSize), limit, false);
+    if (address != 0) {
+        mBlocks.at(address).mapped = true;
+    }
+
+    return address;
+}
+
+u32 cold::Heap::getMappingSize(const u32 address) const {
+    const auto block = mBlocks.find(address);
+    if (block == mBlocks.end() || !block->second.mapped) {
+        return 0;
+    }
+
+    return block->second.size;
+}
+
+void cold::Heap::write(std::ostream& out) const {
+    cold::varint::write(out, mBegin);
+    cold::varint::write(out, mTop);
+    cold::varint::write(out, mDebug ? 1 : 0);
+
+    cold::varint::write(out, mStatistics.allocations);
+    cold::varint::write(out, mStatistics.frees);
+    cold::varint::write(out, mStatistics.reallocations);
+    cold::varint::write(out, mStatistics.failures);
+    cold::varint::write(out, mStatistics.blocksInUse);
+    cold::varint::write(out, mStatistics.bytesInUse);
+    cold::varint::write(out, mStatistics.peakBytesInUse);
+    cold::varint::write(out, mStatistics.heapSize);
+
+    // Sorted so equal heaps always encode the same
+    std::vector<std::pair<u32, Block>> blocks(mBlocks.begin(), mBlocks.end());
+    std::sort(blocks.begin(), blocks.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+
+    cold::varint::write(out, blocks.size());
+    for (const auto& [address, block] : blocks) {
+        cold::varint::write(out, address);
+        cold::varint::write(out, block.size);
+        cold::varint::write(out, block.sizeClass);
+        cold::varint::write(out, (block.guarded ? 1 : 0) | (block.mapped ? 2 : 0));
+    }
+
+    for (const std::vector<u32>& freeBlocks : mFreeBlocks) {
+        cold::varint::write(out, freeBlocks.size());
+        for (const u32 address : freeBlocks) {
+            cold::varint::write(out, address);
+        }
+    }
+}
+
+void cold::Heap::read(std::istream& in) {
+    const auto readU32 = [&in]() {
+        return static_cast<u32>(cold::varint::read(in));
+    };
+
+    mBegin = readU32();
+    mTop = readU32();
+    mDebug = cold::varint::read(in) != 0;
+
+    mStatistics.allocations = cold::varint::read(in);
+    mStatistics.frees = cold::varint::read(in);
+    mStatistics.reallocations = cold::varint::read(in);
+    mStatistics.failures = cold::varint::read(in);
+    mStatistics.blocksInUse = readU32();
+    mStatistics.bytesInUse = readU32();
+    mStatistics.peakBytesInUse = readU32();
+    mStatistics.heapSize = readU32();
+
+    mBlocks.clear();
+    const u64 blockCount = cold::varint::read(in);
+    for (u64 i = 0; i < blockCount; i++) {
+        const u32 address = readU32();
+        const u32 size = readU32();
+        const u32 sizeClass = readU32();
+        if (sizeClass >= cClassCount) [[unlikely]] {
+            throw std::runtime_error("Invalid heap block");
+        }
+
+        const u64 flags = cold::varint::read(in);
+        mBlocks[address] = { .size = size, .sizeClass = static_cast<u8>(sizeClass), .guarded = (flags & 1) != 0, .mapped = (flags & 2) != 0 };
+    }
+
+    for (std::vector<u32>& freeBlocks : mFreeBlocks) {
+        freeBlocks.resize(cold::varint::read(in));
+        for (u32& address : freeBlocks) {
+            address = readU32();
+        }
+    }
+}
+
+u32 cold::Heap::allocateBlock(cold::Memory& memory, const u32 size, const u32 limit, const bool guarded) {
+    const u64 total = static_cast<u64>(std::max(size, 1u)) + (guarded ? 2 * cGuardSize : 0);
+    const u32 sizeClass = total <= (1u << cMinBlockShift) ? 0 : static_cast<u32>(std::bit_width(total - 1)) - cMinBlockShift;
+
+    if (sizeClass >= cClassCount) [[unlikely]] {
+        mStatistics.failures++;
+        return 0;
+    }
+
+    u32 blockAddress;
+
+    std::vector<u32>& freeBlocks = mFreeBlocks[sizeClass];
+    if (!freeBlocks.empty()) {
+        blockAddress = freeBlocks.back();
+        freeBlocks.pop_back();
+    } else {
+        // The heap starts at the first aligned address past the initialized data and never hands out null
+        if (mBegin == 0) {
+            const u32 alignment = 1u << cMinBlockShift;
+            mBegin = std::max((memory.getDataEnd() + alignment - 1) & ~(alignment - 1), alignment);
+            mTop = mBegin;
+        }
+
+        // Blocks of a page or more start on a page so they can hold mappings, free blocks keep that alignment
+        const u32 blockSize = getBlockSize(static_cast<u8>(sizeClass));
+        const u64 alignment = std::min(blockSize, cold::Memory::cPageSize);
+        const u64 begin = (static_cast<u64>(mTop) + alignment - 1) & ~(alignment - 1);
+        const u64 end = begin + blockSize;
+        if (end > limit || end > memory.getSize()) {
+            mStatistics.failures++;
+            return 0;
+        }
+
+        blockAddress = static_cast<u32>(begin);
+        mTop = static_cast<u32>(end);
+        mStatistics.heapSize = mTop - mBegin;
+    }
+
+    const u32 address = blockAddress + (guarded ? cGuardSize : 0);
+    const Block block = { .size = size, .sizeClass = static_cast<u8>(sizeClass), .guarded = guarded, .mapped = false };
+    mBlocks[address] = block;
+
+    if (guarded) {
+        this->writeGuards(memory, address, block);
+    }
+
+    mStatistics.blocksInUse++;
+    mStatistics.bytesInUse += size;
+    mStatistics.peakBytesInUse = std::max(mStatistics.peakBytesInUse, mStatistics.bytesInUse);
+
+    return address;
+}
+
+void cold::Heap::release(cold::Memory& memory, const std::unordered_map<u32, Block>::iterator block) {
+    const u32 address = block->first;
+    const Block current = block->second;
+
+    if (current.guarded) {
+        this->checkGuards(memory, address, current);
+    }
+
+    mBlocks.erase(block);
+    mFreeBlocks[current.sizeClass].push_back(address - (current.guarded ? cGuardSize : 0));
+
+    mStatistics.blocksInUse--;
+    mStatistics.bytesInUse -= current.size;
+}
+
+void cold::Heap::writeGuards(cold::Memory& memory, const u32 address, const Block& block) {
+    const u32 blockAddress = address - cGuardSize;
+    const u32 blockEnd = blockAddress + getBlockSize(block.sizeClass);
+
+    memory.fill(blockAddress, cGuardByte, address - blockAddress);
+    memory.fill(address + block.size, cGuardByte, blockEnd - (address + block.size));
+}
+
+void cold::Heap::checkGuards(const cold::Memory& memory, const u32 address, const Block& block) const {
+    const u32 blockAddress = address - cGuardSize;
+    const u32 blockEnd = blockAddress + getBlockSize(block.sizeClass);
+
+    for (u32 guard = blockAddress; guard < blockEnd; guard++) {
+        if (guard == address) {
+            guard += block.size;
+            if (guard >= blockEnd) {
+                break;
+            }
+        }
+
+        if (memory.readRW(guard) != cGuardByte) [[unlikely]] {
+            std::ostringstream message;
+            message << "Heap guard overwritten at 0x" << std::hex << guard << " around the block at 0x" << address;
+            throw std::runtime_error(message.str());
+        }
+    }
+}
@@ -0,0 +1,227 @@
+#include "Cold/History.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    constexpr u64 cInitialInterval = 1 << 16;
+    constexpr u64 cMinInterval = 1 << 10;
+    constexpr u64 cMinTimedChunk = 1 << 12; // Shorter runs are too noisy to estimate the execution rate from
+
+}
+
+cold::History::History(cold::VirtualMachine& vm, const std::chrono::nanoseconds maxReplayTime)
+    : mVM(&vm)
+    , mCheckpoints()
+    , mMaxReplayTime(maxReplayTime)
+    , mInterval(cInitialInterval)
+    , mFurthest(vm.getInstructionCount())
+    , mBreakpoints()
+    , mWatchpoints()
+    , mOutput(&std::cout)
+    , mFault()
+{
+    this->takeCheckpoint();
+}
+
+cold::History::StopReason cold::History::step(const u64 count) {
+    mFault.reset();
+
+    if (!this->hasEvents()) {
+        if (!this->advance(count)) {
+            return StopReason::Fault;
+        }
+
+        return mVM->isFinished() ? StopReason::Halted : StopReason::Steps;
+    }
+
+    for (u64 i = 0; i < count; i++) {
+        const std::vector<u8> before = this->readWatched();
+
+        if (!this->advance(1)) {
+            return StopReason::Fault;
+        }
+
+        if (mVM->isFinished()) {
+            return StopReason::Halted;
+        }
+
+        if (this->readWatched() != before) {
+            return StopReason::Watchpoint;
+        }
+
+        if (mBreakpoints.contains(mVM->getProcessor().getRegisters().pc)) {
+            return StopReason::Breakpoint;
+        }
+    }
+
+    return StopReason::Steps;
+}
+
+cold::History::StopReason cold::History::stepBack(const u64 count) {
+    const u64 start = mCheckpoints.front().instructionCount;
+    const u64 position = this->getPosition();
+
+    if (position - start <= count) {
+        this->seek(start);
+        return StopReason::Start;
+    }
+
+    this->seek(position - count);
+    return StopReason::Steps;
+}
+
+cold::History::StopReason cold::History::continueForward() {
+    return this->step(~0ull);
+}
+
+cold::History::StopReason cold::History::continueBackward() {
+    const u64 end = this->getPosition();
+
+    // Scan the checkpoint intervals from the latest one backwards, the first interval with a hit holds the latest hit
+    auto checkpoint = std::lower_bound(mCheckpoints.begin(), mCheckpoints.end(), end, [](const auto& snapshot, const u64 position) {
+        return snapshot.instructionCount < position;
+    });
+
+    u64 segmentEnd = end;
+
+    while (checkpoint != mCheckpoints.begin()) {
+        --checkpoint;
+
+        const u64 segmentStart = checkpoint->instructionCount;
+        this->seek(segmentStart);
+
+        std::optional<u64> hit;
+        StopReason reason = StopReason::Start;
+        std::vector<u8> previous = this->readWatched();
+
+        for (u64 position = segmentStart; position < segmentEnd; position++) {
+            // A breakpoint hit means arriving at the address, a watch hit means the instruction before changed the byte
+            if (mBreakpoints.contains(mVM->getProcessor().getRegisters().pc)) {
+                hit = position;
+                reason = StopReason::Breakpoint;
+            }
+
+            (void)mVM->execute(1);
+
+            std::vector<u8> current = this->readWatched();
+            if (current != previous && position + 1 < end) {
+                hit = position + 1;
+                reason = StopReason::Watchpoint;
+            }
+            previous = std::move(current);
+        }
+
+        if (hit.has_value()) {
+            this->seek(*hit);
+            return reason;
+        }
+
+        segmentEnd = segmentStart;
+    }
+
+    this->seek(mCheckpoints.front().instructionCount);
+    return StopReason::Start;
+}
+
+void cold::History::seek(const u64 position) {
+    mFault.reset();
+
+    auto checkpoint = std::upper_bound(mCheckpoints.begin(), mCheckpoints.end(), position, [](const u64 target, const auto& snapshot) {
+        return target < snapshot.instructionCount;
+    });
+    --checkpoint;
+
+    mVM->restore(*checkpoint);
+    mVM->getProcessor().setOutput(nullptr);
+
+    // Everything up to the furthest point has already run once, so replaying it cannot fault
+    (void)mVM->execute(position - checkpoint->instructionCount);
+}
+
+bool cold::History::advance(u64 count) {
+    while (count > 0 && !mVM->isFinished()) {
+        const u64 position = this->getPosition();
+
+        if (position >= mCheckpoints.back().instructionCount + mInterval) {
+            this->takeCheckpoint();
+        }
+
+        // Stop at the next checkpoint boundary and at the edge of the already executed region, whose output must not repeat
+        u64 chunk = std::min(count, mCheckpoints.back().instructionCount + mInterval - std::min(position, mCheckpoints.back().instructionCount));
+        const bool newGround = position >= mFurthest;
+        if (!newGround) {
+            chunk = std::min(chunk, mFurthest - position);
+        }
+
+        mVM->getProcessor().setOutput(newGround ? mOutput : nullptr);
+
+        const bool timed = newGround && chunk >= cMinTimedChunk;
+        const auto start = timed ? Clock::now() : Clock::time_point();
+        u64 executed = 0;
+
+        try {
+            executed = mVM->execute(chunk);
+        } catch (const std::exception& e) {
+            this->locateFault(position, e.what());
+            return false;
+        }
+
+        // Size the interval so that replaying one takes at most the allowed time
+        if (timed && executed >= cMinTimedChunk) {
+            const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            const double rate = executed / std::max(seconds, 1e-9);
+            const u64 target = static_cast<u64>(rate * std::chrono::duration<double>(mMaxReplayTime).count());
+
+            mInterval = std::max(cMinInterval, (mInterval * 3 + target) / 4);
+        }
+
+        count -= executed;
+        mFurthest = std::max(mFurthest, this->getPosition());
+
+        if (executed < chunk) {
+            break;
+        }
+    }
+
+    return true;
+}
+
+void cold::History::locateFault(const u64 from, const std::string& message) {
+    // The machine stopped inside a chunk without counting it, single step the chunk again to find the exact instruction
+    this->seek(from);
+
+    while (true) {
+        try {
+            if (mVM->execute(1) == 0) {
+                break;
+            }
+        } catch (const std::exception&) {
+            break;
+        }
+    }
+
+    mFurthest = std::max(mFurthest, this->getPosition());
+    mFault = message;
+}
+
+void cold::History::takeCheckpoint() {
+    mCheckpoints.push_back(mVM->snapshot());
+}
+
+std::vector<u8> cold::History::readWatched() {
+    const cold::Memory& memory = mVM->getMemory();
+
+    std::vector<u8> values;
+    values.reserve(mWatchpoints.size());
+
+    for (const u32 address : mWatchpoints) {
+        const bool readable = address >= memory.getRWBegin() && address < memory.getSize();
+        values.push_back(readable ? memory.readRW(address) : 0);
+    }
+
+    return values;
+}
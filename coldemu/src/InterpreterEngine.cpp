@@ -0,0 +1,41 @@
+#include "Cold/InterpreterEngine.h"
+#include "Cold/Memory.h"
+#include "Cold/Processor.h"
+
+namespace {
+
+    template <bool StopAtBlockEnd>
+    u64 interpret(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) {
+        u64 executed = 0;
+
+        while (!processor.isFinished() && executed < maxInstructions) [[likely]] {
+            const cold::Instruction& instr = memory.readX(processor.getRegisters().pc * 4);
+
+            const u8 type = instr.getType();
+            if (type >= (int)cold::Instruction::Type::Count) [[unlikely]] {
+                throw std::runtime_error("Invalid instruction type");
+            }
+
+            const auto handler = cold::Processor::sInstructionHandlers[type]; // function pointer
+            (processor.*handler)(instr);
+
+            processor.getRegisters().pc++;
+            executed++;
+
+            if (StopAtBlockEnd && instr.isBranch()) {
+                break;
+            }
+        }
+
+        return executed;
+    }
+
+}
+
+u64 cold::InterpreterEngine::execute(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) {
+    return interpret<false>(processor, memory, maxInstructions);
+}
+
+u64 cold::InterpreterEngine::executeBlock(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) {
+    return interpret<true>(processor, memory, maxInstructions);
+}
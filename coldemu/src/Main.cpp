@@ -1,11 +1,42 @@
+#include <algorithm>
+#include <filesystem>
 #include <iostream>
 #include <fstream>
+#include <optional>
 
 #include <argparse/argparse.hpp>
 
+#include "Cold/DifferentialChecker.h"
+#include "Cold/Disassembly/Disassembler.h"
+#include "Cold/FileSystem.h"
+#include "Cold/GdbStub.h"
+#include "Cold/MappedFile.h"
+#include "Cold/ProgramGenerator.h"
+#include "Cold/TraceRecorder.h"
+#include "Cold/TracingEngine.h"
 #include "Cold/VirtualMachine.h"
 
-void startProgram(const std::string& path, const u32 memorySize) {
+struct LaunchOptions {
+    std::optional<std::string> path;
+    u64 memorySize;
+    std::optional<u64> memoryLimit;
+    std::string engine;
+    std::optional<std::string> checkpointPath;
+    u64 checkpointInterval;
+    std::optional<std::string> resumePath;
+    std::optional<std::string> tracePath;
+    std::optional<std::string> gdbEndpoint;
+    std::optional<std::string> sandboxPath;
+    bool heapDebug;
+    bool heapStatistics;
+    std::optional<std::string> diffEngines;
+    u32 randomPrograms;
+    u32 randomLength;
+    u64 seed;
+    u64 budget;
+};
+
+std::vector<cold::Instruction> loadProgram(const std::string& path) {
     std::ifstream file(path, std::ios::binary | std::ios::in);
     if (!file.is_open()) {
         throw std::runtime_error("Failed to open file");
@@ -20,9 +51,158 @@ void startProgram(const std::string& path, const u32 memorySize) {
     file.read(reinterpret_cast<char*>(program.data()), fileSize);
     file.close();
 
+    return program;
+}
+
+void printDivergence(const cold::DifferentialChecker& checker, const cold::DifferentialChecker::Divergence& divergence) {
+    std::vector<cold::Instruction> code = checker.getCode();
+    const cold::disassembly::Disassembler disassembler(code);
+
+    std::cout << "Divergence at @" << divergence.pc << ": " << divergence.description << "\n";
+
+    const u32 begin = divergence.pc >= 4 ? divergence.pc - 4 : 0;
+    const u32 end = std::min<u32>(divergence.pc + 5, static_cast<u32>(code.size()));
+    for (u32 pc = begin; pc < end; pc++) {
+        std::cout << (pc == divergence.pc ? "-> @" : "   @") << pc << ": " << disassembler.disassemble(code[pc]) << "\n";
+    }
+}
+
+// Returns whether the engines agreed
+bool checkProgram(const LaunchOptions& options, const std::string& engineA, const std::string& engineB, const std::vector<cold::Instruction>& program) {
+    cold::DifferentialChecker checker(program, options.memorySize, engineA, engineB);
+
+    if (const auto divergence = checker.run(options.budget)) {
+        printDivergence(checker, *divergence);
+        return false;
+    }
+
+    std::cout << "No divergence in " << checker.getBlockCount() << " blocks, " << checker.getInstructionCount() << " instructions";
+    if (checker.getFault().has_value()) {
+        std::cout << " (both faulted: " << *checker.getFault() << ")";
+    }
+    std::cout << std::endl;
+
+    return true;
+}
+
+bool runDiff(const LaunchOptions& options) {
+    const std::string& engines = *options.diffEngines;
+    const std::size_t separator = engines.find(',');
+    if (separator == std::string::npos) {
+        throw std::runtime_error("Expected two engines separated by a comma");
+    }
+
+    const std::string engineA = engines.substr(0, separator);
+    const std::string engineB = engines.substr(separator + 1);
+
+    if (options.path.has_value()) {
+        return checkProgram(options, engineA, engineB, loadProgram(*options.path));
+    }
+
+    cold::ProgramGenerator generator(options.seed);
+
+    for (u32 i = 0; i < options.randomPrograms; i++) {
+        const std::vector<cold::Instruction> program = generator.generate(options.randomLength);
+
+        std::cout << "Program " << i << ": ";
+        if (!checkProgram(options, engineA, engineB, program)) {
+            // Keep the offending program around for reproduction
+            std::ofstream file("divergence.cold", std::ios::binary | std::ios::out);
+            file.write(reinterpret_cast<const char*>(program.data()), program.size() * sizeof(cold::Instruction));
+
+            std::cout << "Program written to divergence.cold" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void printHeapStatistics(const cold::Heap::Statistics& statistics) {
+    std::cerr << std::dec << "Heap: " << statistics.allocations << " allocations, " << statistics.reallocations << " reallocations, "
+              << statistics.frees << " frees, " << statistics.failures << " failed\n"
+              << "    " << statistics.blocksInUse << " blocks (" << statistics.bytesInUse << " bytes) in use, peak " << statistics.peakBytesInUse
+              << " bytes, heap size " << statistics.heapSize << " bytes" << std::endl;
+}
+
+void startProgram(const LaunchOptions& options) {
+    // Mapped rather than read, the image is swapped once straight into the machine
+    const cold::MappedFile image(*options.path);
+
     try {
-        cold::VirtualMachine vm(program, memorySize);
-        vm.run();
+        cold::VirtualMachine vm(image.getBytes(), options.memorySize);
+        vm.setEngine(cold::Engine::create(options.engine));
+        vm.getMemory().getHeap().setDebug(options.heapDebug);
+
+        if (options.memoryLimit.has_value()) {
+            vm.getMemory().setSizeLimit(*options.memoryLimit);
+        }
+
+        if (options.sandboxPath.has_value()) {
+            vm.getProcessor().setFileSystem(std::make_shared<cold::FileSystem>(*options.sandboxPath));
+        }
+
+        // Replaying the whole chain of deltas onto the freshly loaded image recovers the latest state
+        if (options.resumePath.has_value()) {
+            std::ifstream checkpoints(*options.resumePath, std::ios::binary | std::ios::in);
+            if (!checkpoints.is_open()) {
+                throw std::runtime_error("Failed to open checkpoint file");
+            }
+
+            while (checkpoints.peek() != std::ifstream::traits_type::eof()) {
+                vm.readCheckpoint(checkpoints);
+            }
+        }
+
+        if (options.gdbEndpoint.has_value()) {
+            cold::GdbStub stub(vm, *options.gdbEndpoint);
+
+            // A detached program runs on to completion
+            if (stub.serve()) {
+                vm.run();
+            }
+
+            return;
+        }
+
+        std::optional<cold::TraceRecorder> recorder;
+        if (options.tracePath.has_value()) {
+            recorder.emplace(*options.tracePath, vm);
+            vm.setEngine(std::make_unique<cold::TracingEngine>(*recorder));
+        }
+
+        if (options.checkpointPath.has_value()) {
+            // Only a run resumed from this very file extends its chain, anything else starts a new one
+            std::error_code error;
+            const bool extend = options.resumePath.has_value() && std::filesystem::equivalent(*options.resumePath, *options.checkpointPath, error);
+
+            std::ofstream checkpoints(*options.checkpointPath, std::ios::binary | std::ios::out | (extend ? std::ios::app : std::ios::trunc));
+            if (!checkpoints.is_open()) {
+                throw std::runtime_error("Failed to open checkpoint file");
+            }
+
+            // The new chain starts with the one it resumed from, so it replays onto the image on its own
+            if (!extend && options.resumePath.has_value()) {
+                std::ifstream resumed(*options.resumePath, std::ios::binary | std::ios::in);
+                checkpoints << resumed.rdbuf();
+            }
+
+            vm.run(checkpoints, options.checkpointInterval);
+        } else {
+            vm.run();
+        }
+
+        if (recorder.has_value()) {
+            recorder->close();
+
+            const double bytesPerEntry = recorder->getEntryCount() != 0 ? (double)recorder->getBytesWritten() / recorder->getEntryCount() : 0.0;
+            std::cerr << "Traced " << std::dec << recorder->getEntryCount() << " entries in " << recorder->getBytesWritten() << " bytes ("
+                      << bytesPerEntry << " bytes per entry)" << std::endl;
+        }
+
+        if (options.heapStatistics) {
+            printHeapStatistics(vm.getMemory().getHeap().getStatistics());
+        }
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
     }
@@ -31,12 +211,72 @@ void startProgram(const std::string& path, const u32 memorySize) {
 int main(int argc, char** argv) {
     argparse::ArgumentParser args("coldemu");
     args.add_argument("-p", "--path")
-        .help("path to the program file")
-        .required();
+        .help("path to the program file");
     
     args.add_argument("-m", "--memory")
-        .help("memory size in bytes")
-        .default_value(1024) // 1 KB
+        .help("memory size in bytes, up to 4 GiB")
+        .default_value(static_cast<u64>(1024)) // 1 KB
+        .scan<'i', u64>();
+
+    args.add_argument("--memory-limit")
+        .help("largest memory size the GROW syscall may reach, defaults to the memory size")
+        .scan<'i', u64>();
+
+    args.add_argument("-e", "--engine")
+        .help("execution engine (interpreter, predecoded, tiered or aot:MODULE for a module compiled from coldaot output)")
+        .default_value(std::string("interpreter"));
+
+    args.add_argument("--checkpoint")
+        .help("write incremental checkpoints to this file, extending its chain when resuming from the same file");
+
+    args.add_argument("--checkpoint-interval")
+        .help("instructions between checkpoints")
+        .default_value(static_cast<u64>(1000000))
+        .scan<'i', u64>();
+
+    args.add_argument("--resume")
+        .help("resume from the last checkpoint in this file");
+
+    args.add_argument("--trace")
+        .help("record an execution trace to this file");
+
+    args.add_argument("--sandbox")
+        .help("directory the file syscalls may open files in, file syscalls fail without it");
+
+    args.add_argument("--heap-debug")
+        .help("surround heap blocks with guard bytes that are checked when they are freed")
+        .default_value(false)
+        .implicit_value(true);
+
+    args.add_argument("--heap-stats")
+        .help("print heap allocation statistics when the program ends")
+        .default_value(false)
+        .implicit_value(true);
+
+    args.add_argument("--gdb")
+        .help("serve the GDB remote protocol on this local TCP port or unix socket path");
+
+    args.add_argument("--diff")
+        .help("run two engines in lockstep and report where they diverge, e.g. interpreter,predecoded");
+
+    args.add_argument("--random")
+        .help("with --diff and no path, check this many randomly generated programs")
+        .default_value(100)
+        .scan<'i', s32>();
+
+    args.add_argument("--random-length")
+        .help("instructions per random program")
+        .default_value(64)
+        .scan<'i', s32>();
+
+    args.add_argument("--seed")
+        .help("seed of the random program generator")
+        .default_value(0)
+        .scan<'i', s32>();
+
+    args.add_argument("--budget")
+        .help("instructions per program in --diff mode")
+        .default_value(100000)
         .scan<'i', s32>();
 
     try {
@@ -47,11 +287,43 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    const std::string path = args.get<std::string>("--path");
-    const u32 memorySize = args.get<s32>("--memory");
+    LaunchOptions options = {
+        .path = args.present("--path"),
+        .memorySize = args.get<u64>("--memory"),
+        .memoryLimit = args.present<u64>("--memory-limit"),
+        .engine = args.get<std::string>("--engine"),
+        .checkpointPath = args.present("--checkpoint"),
+        .checkpointInterval = args.get<u64>("--checkpoint-interval"),
+        .resumePath = args.present("--resume"),
+        .tracePath = args.present("--trace"),
+        .gdbEndpoint = args.present("--gdb"),
+        .sandboxPath = args.present("--sandbox"),
+        .heapDebug = args.get<bool>("--heap-debug"),
+        .heapStatistics = args.get<bool>("--heap-stats"),
+        .diffEngines = args.present("--diff"),
+        .randomPrograms = static_cast<u32>(args.get<s32>("--random")),
+        .randomLength = static_cast<u32>(args.get<s32>("--random-length")),
+        .seed = static_cast<u64>(args.get<s32>("--seed")),
+        .budget = static_cast<u64>(args.get<s32>("--budget"))
+    };
+
+    if (!options.path.has_value() && !options.diffEngines.has_value()) {
+        std::cerr << "A program path is required" << std::endl;
+        std::cerr << args;
+        return 1;
+    }
+
+    if (options.checkpointInterval == 0) {
+        std::cerr << "Checkpoint interval must be positive" << std::endl;
+        return 1;
+    }
 
     try {
-        startProgram(path, memorySize);
+        if (options.diffEngines.has_value()) {
+            return runDiff(options) ? 0 : 1;
+        }
+
+        startProgram(options);
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
         return 1;
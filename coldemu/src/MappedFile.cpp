@@ -0,0 +1,83 @@
+#include "Cold/MappedFile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+    #include <io.h>
+#else
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+cold::MappedFile::MappedFile(const std::filesystem::path& path)
+    : mData()
+    , mSize(0)
+{
+    std::error_code error;
+    const u64 size = std::filesystem::file_size(path, error);
+    if (error) {
+        throw std::runtime_error("Failed to open file: " + path.string());
+    }
+
+    // Nothing can be mapped from an empty file
+    if (size == 0) {
+        return;
+    }
+
+    std::FILE* file = std::fopen(path.string().c_str(), "rb");
+    if (file == nullptr) {
+        throw std::runtime_error("Failed to open file: " + path.string());
+    }
+
+    // The view outlives the descriptor it was mapped from
+    mData = mapView(file, 0, size);
+    std::fclose(file);
+
+    if (mData == nullptr) {
+        throw std::runtime_error("Failed to map file: " + path.string());
+    }
+
+    mSize = static_cast<std::size_t>(size);
+}
+
+u64 cold::MappedFile::getGranularity() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+#else
+    return static_cast<u64>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+std::shared_ptr<const u8> cold::MappedFile::mapView(std::FILE* file, const u64 offset, const u64 length) {
+#ifdef _WIN32
+    const HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)));
+    const HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        return nullptr;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, static_cast<DWORD>(offset >> 32), static_cast<DWORD>(offset), static_cast<SIZE_T>(length));
+    CloseHandle(mapping); // The view keeps the mapping alive
+    if (view == nullptr) {
+        return nullptr;
+    }
+
+    return std::shared_ptr<const u8>(static_cast<const u8*>(view), [](const u8* data) {
+        UnmapViewOfFile(data);
+    });
+#else
+    void* view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fileno(file), static_cast<off_t>(offset));
+    if (view == MAP_FAILED) {
+        return nullptr;
+    }
+
+    return std::shared_ptr<const u8>(static_cast<const u8*>(view), [length](const u8* data) {
+        munmap(const_cast<u8*>(data), length);
+    });
+#endif
+}
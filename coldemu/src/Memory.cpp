@@ -1,21 +1,254 @@
 #include "Cold/Memory.h"
+#include "Cold/Varint.h"
 
-cold::Memory::Memory(const s32 size)
-    : mMemory(size)
+#include <algorithm>
+#include <atomic>
+#include <bit>
+
+namespace {
+
+    constexpr u32 cDeltaMagic = 0x324C4443; // "CDL2", the read-only pages were added after "CDLT"
+
+    u64 checkSize(const u64 size) {
+        if (size > cold::Memory::cMaxSize) [[unlikely]] {
+            throw std::runtime_error("Memory size exceeds the 32-bit address space");
+        }
+
+        return size;
+    }
+
+    u64 nextGeneration() {
+        // Unique across every memory and never reused, so forks and restores cannot confuse two snapshots
+        static std::atomic<u64> sGeneration = 0;
+        return ++sGeneration;
+    }
+
+}
+
+cold::Memory::Memory(const u64 size)
+    : mPages((checkSize(size) + cPageSize - 1) >> cPageShift, getZeroPage())
+    , mPrivatePages((mPages.size() + 63) / 64, 0)
+    , mDirtyPages(mPrivatePages.size(), 0)
+    , mDirtyList()
+    , mWatchedPages(mPrivatePages.size(), 0)
+    , mReadOnlyPages(mPrivatePages.size(), 0)
+    , mWatchpoints()
+    , mWatchpointsEnabled(true)
+    , mWriteLog(nullptr)
+    , mDirtyBase(0)
+    , mCode(std::make_shared<const std::vector<cold::Instruction>>())
+    , mHeap()
+    , mSize(size)
+    , mSizeLimit(size)
     , mCodeSize(0)
+    , mRWBegin(0)
+    , mDataEnd(0)
 { }
 
-void cold::Memory::setCode(const std::vector<cold::Instruction>& program) {
-    std::memcpy(mMemory.data(), program.data(), program.size() * sizeof(Instruction));
-    mCodeSize = static_cast<s32>(program.size()) * sizeof(Instruction);
+cold::Memory cold::Memory::fork() {
+    // Neither side may write shared pages in place anymore
+    std::fill(mPrivatePages.begin(), mPrivatePages.end(), 0);
+
+    return Memory(*this);
+}
+
+void cold::Memory::setCode(std::vector<cold::Instruction> code) {
+    mCodeSize = static_cast<u32>(code.size() * sizeof(Instruction));
+    mRWBegin = mCodeSize;
+    mCode = std::make_shared<const std::vector<cold::Instruction>>(std::move(code));
 }
 
-u8& cold::Memory::readRW(const u32 address) {
-    if (address >= mMemory.size() || address < mCodeSize) [[unlikely]] {
+void cold::Memory::setData(const u32 address, const std::span<const u8> data) {
+    if (address < mCodeSize) [[unlikely]] {
+        throw std::runtime_error("Data overlaps the code");
+    }
+
+    // Optimized code may end before the data, the gap is neither executable nor writable
+    mRWBegin = address;
+    this->write(address, data.data(), static_cast<u32>(data.size()));
+    mDataEnd = std::max(mDataEnd, static_cast<u32>(address + data.size()));
+}
+
+u8 cold::Memory::readRW(const u32 address) const {
+    if (address >= mSize || address < mRWBegin) [[unlikely]] {
         throw std::runtime_error("Out of bounds memory access");
     }
 
-    return mMemory[address];
+    return (*mPages[address >> cPageShift])[address & (cPageSize - 1)];
+}
+
+u8& cold::Memory::writeRW(const u32 address) {
+    if (address >= mSize || address < mRWBegin) [[unlikely]] {
+        throw std::runtime_error("Out of bounds memory access");
+    }
+
+    const u32 page = address >> cPageShift;
+    if (!this->isPrivate(page)) [[unlikely]] {
+        this->prepareWrite(page, address, 1);
+    }
+
+    return (*mPages[page])[address & (cPageSize - 1)];
+}
+
+void cold::Memory::read(const u32 address, u8* data, const u32 length) const {
+    if (static_cast<u64>(address) + length > mSize || address < mRWBegin) [[unlikely]] {
+        throw std::runtime_error("Out of bounds memory access");
+    }
+
+    for (u32 done = 0; done < length; ) {
+        const u32 current = address + done;
+        const u32 offset = current & (cPageSize - 1);
+        const u32 chunk = std::min(length - done, cPageSize - offset);
+
+        std::copy_n(mPages[current >> cPageShift]->data() + offset, chunk, data + done);
+        done += chunk;
+    }
+}
+
+void cold::Memory::write(const u32 address, const u8* data, const u32 length) {
+    if (static_cast<u64>(address) + length > mSize || address < mRWBegin) [[unlikely]] {
+        throw std::runtime_error("Out of bounds memory access");
+    }
+
+    for (u32 done = 0; done < length; ) {
+        const u32 current = address + done;
+        const u32 page = current >> cPageShift;
+        const u32 offset = current & (cPageSize - 1);
+        const u32 chunk = std::min(length - done, cPageSize - offset);
+
+        if (!this->isPrivate(page)) {
+            this->prepareWrite(page, current, chunk);
+        }
+
+        std::copy_n(data + done, chunk, mPages[page]->data() + offset);
+        done += chunk;
+    }
+
+    this->logWrite(address, length);
+}
+
+void cold::Memory::copy(const u32 destination, const u32 source, const u32 length) {
+    if (static_cast<u64>(source) + length > mSize || source < mRWBegin) [[unlikely]] {
+        throw std::runtime_error("Out of bounds memory access");
+    }
+
+    u32 done = 0;
+    (void)this->writeSpans(destination, length, [this, source, &done](const std::span<u8> span) {
+        this->read(source + done, span.data(), static_cast<u32>(span.size()));
+        done += static_cast<u32>(span.size());
+        return static_cast<u32>(span.size());
+    });
+}
+
+void cold::Memory::fill(const u32 address, const u8 value, const u32 length) {
+    (void)this->writeSpans(address, length, [value](const std::span<u8> span) {
+        std::fill(span.begin(), span.end(), value);
+        return static_cast<u32>(span.size());
+    });
+}
+
+u32 cold::Memory::map(const std::shared_ptr<const u8>& data, const u32 length, const u32 limit) {
+    const u32 address = mHeap.allocateMapping(*this, length, limit);
+    if (address == 0) {
+        return 0;
+    }
+
+    // Guest pages alias the host mapping directly, which the aliasing pointers keep alive
+    const u32 pageCount = (length + cPageSize - 1) >> cPageShift;
+    for (u32 i = 0; i < pageCount; i++) {
+        const u32 page = (address >> cPageShift) + i;
+        const u8* view = data.get() + (static_cast<std::size_t>(i) << cPageShift);
+
+        mPages[page] = std::shared_ptr<Page>(data, reinterpret_cast<Page*>(const_cast<u8*>(view)));
+        mReadOnlyPages[page >> 6] |= 1ull << (page & 63);
+        mPrivatePages[page >> 6] &= ~(1ull << (page & 63));
+        this->markDirty(page);
+    }
+
+    this->logWrite(address, length);
+    return address;
+}
+
+void cold::Memory::free(const u32 address) {
+    // Freeing a mapping puts zeroed pages back in its place
+    if (const u32 size = mHeap.getMappingSize(address)) {
+        const u32 pageCount = (size + cPageSize - 1) >> cPageShift;
+        for (u32 i = 0; i < pageCount; i++) {
+            const u32 page = (address >> cPageShift) + i;
+
+            mPages[page] = getZeroPage();
+            mReadOnlyPages[page >> 6] &= ~(1ull << (page & 63));
+            mPrivatePages[page >> 6] &= ~(1ull << (page & 63));
+            this->markDirty(page);
+        }
+
+        this->logWrite(address, size);
+    }
+
+    mHeap.free(*this, address);
+}
+
+u32 cold::Memory::grow(const u32 bytes) {
+    const u64 previousSize = mSize;
+    if (bytes == 0) {
+        return static_cast<u32>(previousSize);
+    }
+
+    // Growth is page granular, the new pages are committed on their first write like all others
+    const u64 size = (previousSize + bytes + cPageSize - 1) & ~static_cast<u64>(cPageSize - 1);
+    if (size > mSizeLimit) {
+        return 0;
+    }
+
+    this->resize(size);
+    return static_cast<u32>(previousSize);
+}
+
+void cold::Memory::setSizeLimit(const u64 limit) {
+    mSizeLimit = std::max(checkSize(limit), mSize);
+}
+
+void cold::Memory::resize(const u64 size) {
+    const std::size_t pageCount = (size + cPageSize - 1) >> cPageShift;
+    const std::size_t wordCount = (pageCount + 63) / 64;
+
+    mPages.resize(pageCount, getZeroPage());
+    mPrivatePages.resize(wordCount, 0);
+    mDirtyPages.resize(wordCount, 0);
+    mWatchedPages.resize(wordCount, 0);
+    mReadOnlyPages.resize(wordCount, 0);
+
+    // Shrinking can leave bits of dropped pages in the last word
+    if (pageCount % 64 != 0) {
+        const u64 mask = (1ull << (pageCount % 64)) - 1;
+        mPrivatePages.back() &= mask;
+        mDirtyPages.back() &= mask;
+        mReadOnlyPages.back() &= mask;
+    }
+
+    std::erase_if(mDirtyList, [pageCount](const u32 page) { return page >= pageCount; });
+
+    mSize = size;
+    this->updateWatchedPages();
+}
+
+const std::shared_ptr<cold::Memory::Page>& cold::Memory::getZeroPage() {
+    // Shared by every untouched page of every memory, it is never private so nobody writes to it
+    static const std::shared_ptr<Page> sZeroPage = std::make_shared<Page>();
+
+    return sZeroPage;
+}
+
+void cold::Memory::prepareWrite(const u32 page, const u32 address, const u32 length) {
+    if (this->isReadOnly(page)) [[unlikely]] {
+        throw std::runtime_error("Write to read-only mapped memory");
+    }
+
+    if (this->isWatched(page)) [[unlikely]] {
+        this->checkWatchpoints(address, length);
+    }
+
+    this->makePrivate(page);
 }
 
 cold::Instruction cold::Memory::readX(const u32 address) const {
@@ -23,9 +256,354 @@ cold::Instruction cold::Memory::readX(const u32 address) const {
         throw std::runtime_error("Cannot read executable memory from non-executable address space");
     }
 
-    if (address >= mMemory.size()) [[unlikely]] {
+    if (address >= mSize) [[unlikely]] {
         throw std::runtime_error("Out of bounds memory access");
     }
-    
-    return *reinterpret_cast<const cold::Instruction*>(&mMemory[address]);
+
+    return (*mCode)[address / sizeof(cold::Instruction)];
+}
+
+u32 cold::Memory::getPrivatePageCount() const {
+    u32 count = 0;
+
+    for (const u64 bits : mPrivatePages) {
+        count += std::popcount(bits);
+    }
+
+    return count;
+}
+
+void cold::Memory::makePrivate(const u32 page) {
+    // Copy the page unless every other sharer has already made its own copy
+    if (mPages[page].use_count() > 1) {
+        mPages[page] = std::make_shared<Page>(*mPages[page]);
+    }
+
+    mPrivatePages[page >> 6] |= (1ull << (page & 63)) & ~mWatchedPages[page >> 6];
+    this->markDirty(page);
+}
+
+void cold::Memory::markDirty(const u32 page) {
+    u64& word = mDirtyPages[page >> 6];
+    const u64 bit = 1ull << (page & 63);
+
+    if ((word & bit) == 0) {
+        word |= bit;
+        mDirtyList.push_back(page);
+    }
+}
+
+void cold::Memory::addWatchpoint(const u32 address, const u32 length) {
+    mWatchpoints.push_back({ .address = address, .length = length });
+    this->updateWatchedPages();
+}
+
+void cold::Memory::removeWatchpoint(const u32 address, const u32 length) {
+    const auto watchpoint = std::find_if(mWatchpoints.begin(), mWatchpoints.end(), [&](const Watchpoint& candidate) {
+        return candidate.address == address && candidate.length == length;
+    });
+
+    if (watchpoint != mWatchpoints.end()) {
+        mWatchpoints.erase(watchpoint);
+        this->updateWatchedPages();
+    }
+}
+
+void cold::Memory::checkWatchpoints(const u32 address, const u32 length) const {
+    if (!mWatchpointsEnabled) {
+        return;
+    }
+
+    for (const Watchpoint& watchpoint : mWatchpoints) {
+        // Reports the first watched byte of the write
+        if (address - watchpoint.address < watchpoint.length) {
+            throw cold::WatchpointHit(address);
+        }
+
+        if (watchpoint.address - address < length && watchpoint.length != 0) {
+            throw cold::WatchpointHit(watchpoint.address);
+        }
+    }
+}
+
+void cold::Memory::checkWritable(const u32 address, const u32 length) const {
+    if (static_cast<u64>(address) + length > mSize || address < mRWBegin) [[unlikely]] {
+        throw std::runtime_error("Out of bounds memory access");
+    }
+
+    if (length == 0) {
+        return;
+    }
+
+    const u32 first = address >> cPageShift;
+    const u32 last = static_cast<u32>((static_cast<u64>(address) + length - 1) >> cPageShift);
+
+    for (u32 page = first; page <= last; page++) {
+        if (this->isReadOnly(page)) [[unlikely]] {
+            throw std::runtime_error("Write to read-only mapped memory");
+        }
+    }
+
+    this->checkWatchpoints(address, length);
+}
+
+void cold::Memory::updateWatchedPages() {
+    std::fill(mWatchedPages.begin(), mWatchedPages.end(), 0);
+
+    for (const Watchpoint& watchpoint : mWatchpoints) {
+        // Walks one address per page, wrapping like guest address computation does
+        const u32 last = watchpoint.address + (watchpoint.length != 0 ? watchpoint.length - 1 : 0);
+        for (u32 page = watchpoint.address >> cPageShift; ; page = (page + 1) & (~0u >> cPageShift)) {
+            if (page < mPages.size()) {
+                mWatchedPages[page >> 6] |= 1ull << (page & 63);
+            }
+
+            if (page == last >> cPageShift) {
+                break;
+            }
+        }
+    }
+
+    // Watched pages lose write permission so their next write is checked
+    for (std::size_t i = 0; i < mPrivatePages.size(); i++) {
+        mPrivatePages[i] &= ~mWatchedPages[i];
+    }
+}
+
+cold::Memory::Snapshot cold::Memory::snapshot() {
+    // Every write after this point goes through makePrivate, which is where pages get marked dirty
+    std::fill(mPrivatePages.begin(), mPrivatePages.end(), 0);
+    std::fill(mDirtyPages.begin(), mDirtyPages.end(), 0);
+    mDirtyList.clear();
+
+    Snapshot snapshot;
+    snapshot.mPages = mPages;
+    snapshot.mReadOnlyPages = mReadOnlyPages;
+    snapshot.mHeap = mHeap;
+    snapshot.mSize = mSize;
+    snapshot.mGeneration = nextGeneration();
+    mDirtyBase = snapshot.mGeneration;
+
+    return snapshot;
+}
+
+void cold::Memory::restore(const Snapshot& base) {
+    if (base.mSize != mSize) {
+        this->resize(base.mSize);
+    }
+
+    for (const u32 page : this->getChangedPages(base)) {
+        mPages[page] = base.mPages[page];
+    }
+
+    mReadOnlyPages = base.mReadOnlyPages;
+    mHeap = base.mHeap;
+
+    std::fill(mPrivatePages.begin(), mPrivatePages.end(), 0);
+    std::fill(mDirtyPages.begin(), mDirtyPages.end(), 0);
+    mDirtyList.clear();
+    mDirtyBase = base.mGeneration; // Memory now equals base, so later writes are dirty relative to it
+}
+
+void cold::Memory::writeDelta(std::ostream& out, const Snapshot& base) const {
+    const std::vector<u32> pages = this->getChangedPages(base);
+
+    cold::varint::write(out, cDeltaMagic);
+    cold::varint::write(out, mSize);
+    cold::varint::write(out, pages.size());
+
+    // Each page is its index delta followed by (gap, length, bytes) runs of changed bytes, ended by a zero length run
+    u32 previousPage = 0;
+    for (const u32 page : pages) {
+        const Page& current = *mPages[page];
+        const Page& original = page < base.mPages.size() ? *base.mPages[page] : *getZeroPage();
+
+        cold::varint::write(out, page - previousPage);
+        previousPage = page;
+
+        u32 runEnd = 0;
+        u32 offset = 0;
+        while (offset < cPageSize) {
+            if (current[offset] == original[offset]) {
+                offset++;
+                continue;
+            }
+
+            u32 length = 1;
+            while (offset + length < cPageSize && current[offset + length] != original[offset + length]) {
+                length++;
+            }
+
+            cold::varint::write(out, offset - runEnd);
+            cold::varint::write(out, length);
+            out.write(reinterpret_cast<const char*>(current.data() + offset), length);
+
+            offset += length;
+            runEnd = offset;
+        }
+
+        cold::varint::write(out, 0);
+        cold::varint::write(out, 0);
+    }
+
+    // Mapped pages are stored as plain bytes above, the bitmap keeps them read-only on resume
+    u64 readOnlyCount = 0;
+    for (const u64 bits : mReadOnlyPages) {
+        readOnlyCount += std::popcount(bits);
+    }
+
+    cold::varint::write(out, readOnlyCount);
+
+    u32 previousReadOnly = 0;
+    for (u32 page = 0; page < mPages.size(); page++) {
+        if (this->isReadOnly(page)) {
+            cold::varint::write(out, page - previousReadOnly);
+            previousReadOnly = page;
+        }
+    }
+
+    // The heap bookkeeping is small, so it is stored whole
+    mHeap.write(out);
+}
+
+void cold::Memory::applyDelta(std::istream& in) {
+    if (cold::varint::read(in) != cDeltaMagic) [[unlikely]] {
+        throw std::runtime_error("Invalid memory delta");
+    }
+
+    const u64 size = cold::varint::read(in);
+    if (size > cMaxSize) [[unlikely]] {
+        throw std::runtime_error("Memory delta size out of range");
+    }
+
+    if (size != mSize) {
+        this->resize(size);
+    }
+
+    const u64 pageCount = cold::varint::read(in);
+
+    u64 page = 0;
+    for (u64 i = 0; i < pageCount; i++) {
+        page += cold::varint::read(in);
+        if (page >= mPages.size()) [[unlikely]] {
+            throw std::runtime_error("Memory delta page out of range");
+        }
+
+        // A mapped page aliases the host file even when nothing else shares it, so it gets a copy of its own
+        if (this->isReadOnly(static_cast<u32>(page))) {
+            mPages[page] = std::make_shared<Page>(*mPages[page]);
+            mReadOnlyPages[page >> 6] &= ~(1ull << (page & 63));
+        }
+
+        if (!this->isPrivate(static_cast<u32>(page))) {
+            this->makePrivate(static_cast<u32>(page));
+        }
+
+        Page& current = *mPages[page];
+
+        u64 offset = 0;
+        while (true) {
+            offset += cold::varint::read(in);
+            const u64 length = cold::varint::read(in);
+
+            if (length == 0) {
+                break;
+            }
+
+            if (offset + length > cPageSize) [[unlikely]] {
+                throw std::runtime_error("Memory delta run out of range");
+            }
+
+            if (!in.read(reinterpret_cast<char*>(current.data() + offset), length)) [[unlikely]] {
+                throw std::runtime_error("Unexpected end of memory delta");
+            }
+
+            offset += length;
+        }
+    }
+
+    // Pages mapped when the delta was written stay read-only, they are never private so writes still check the bit
+    const u64 readOnlyCount = cold::varint::read(in);
+    if (readOnlyCount > mPages.size()) [[unlikely]] {
+        throw std::runtime_error("Memory delta read-only page count out of range");
+    }
+
+    std::fill(mReadOnlyPages.begin(), mReadOnlyPages.end(), 0);
+
+    u64 readOnlyPage = 0;
+    for (u64 i = 0; i < readOnlyCount; i++) {
+        readOnlyPage += cold::varint::read(in);
+        if (readOnlyPage >= mPages.size()) [[unlikely]] {
+            throw std::runtime_error("Memory delta page out of range");
+        }
+
+        mReadOnlyPages[readOnlyPage >> 6] |= 1ull << (readOnlyPage & 63);
+        mPrivatePages[readOnlyPage >> 6] &= ~(1ull << (readOnlyPage & 63));
+    }
+
+    mHeap.read(in);
+}
+
+void cold::Memory::clearDirtyPages() {
+    // Pages only become private together with being marked dirty, so only the words of written pages need work
+    for (const u32 page : mDirtyList) {
+        mPrivatePages[page >> 6] &= ~mDirtyPages[page >> 6];
+        mDirtyPages[page >> 6] = 0;
+    }
+
+    mDirtyList.clear();
+    mDirtyBase = 0; // No snapshot describes memory at this point
+}
+
+u32 cold::Memory::getDirtyPageCount() const {
+    return static_cast<u32>(mDirtyList.size());
+}
+
+std::vector<u32> cold::Memory::getDirtyPages() const {
+    std::vector<u32> pages = mDirtyList;
+    std::sort(pages.begin(), pages.end());
+
+    return pages;
+}
+
+u64 cold::Memory::hashPages(const std::vector<u32>& pages) const {
+    u64 hash = 0xCBF29CE484222325; // FNV-1a
+
+    for (const u32 page : pages) {
+        if (page >= mPages.size()) [[unlikely]] {
+            throw std::runtime_error("Page out of range");
+        }
+
+        for (const u8 byte : *mPages[page]) {
+            hash = (hash ^ byte) * 0x100000001B3;
+        }
+    }
+
+    return hash;
+}
+
+std::vector<u32> cold::Memory::getChangedPages(const Snapshot& base) const {
+    std::vector<u32> pages;
+
+    // Pages grown since the snapshot are compared against zeroes
+    const auto isChanged = [&](const u32 page) {
+        return mPages[page] != (page < base.mPages.size() ? base.mPages[page] : getZeroPage());
+    };
+
+    if (base.mGeneration != 0 && base.mGeneration == mDirtyBase) {
+        // Only the dirty bitmap needs to be walked against the snapshot it is relative to
+        for (const u32 page : this->getDirtyPages()) {
+            if (isChanged(page)) {
+                pages.push_back(page);
+            }
+        }
+    } else {
+        for (u32 page = 0; page < mPages.size(); page++) {
+            if (isChanged(page)) {
+                pages.push_back(page);
+            }
+        }
+    }
+
+    return pages;
 }
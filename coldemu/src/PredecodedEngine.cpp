@@ -0,0 +1,200 @@
+#include "Cold/PredecodedEngine.h"
+#include "Cold/Memory.h"
+
+#include <utility>
+
+u64 cold::PredecodedEngine::execute(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) {
+    return this->run<false>(processor, memory, maxInstructions);
+}
+
+u64 cold::PredecodedEngine::executeBlock(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) {
+    return this->run<true>(processor, memory, maxInstructions);
+}
+
+template <bool StopAtBlockEnd>
+u64 cold::PredecodedEngine::run(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) {
+    if (memory.getCode() != mDecodedCode) [[unlikely]] {
+        this->decode(memory);
+    }
+
+    cold::Processor::Registers& registers = processor.getRegisters();
+    const u32 codeSize = memory.getCodeSize();
+    u64 executed = 0;
+
+    mStoppedAtBreakpoint = false;
+    const std::optional<u32> skippedBreakpoint = std::exchange(mSkippedBreakpoint, std::nullopt);
+
+    u32 pc = registers.pc; // Kept in step with the register so the hot path does not reload it
+
+    while (!processor.isFinished() && executed < maxInstructions) [[likely]] {
+        // Same wrapping address computation as the interpreter
+        const u32 address = pc * 4;
+        if (address >= codeSize) [[unlikely]] {
+            (void)memory.readX(address); // Raises the same fault as the interpreter
+        }
+
+        const Operation* operation = &mOperations[address / sizeof(cold::Instruction)];
+        if (operation->handler == nullptr) [[unlikely]] {
+            if (operation->linkage == Linkage::None) {
+                const auto breakpoint = mBreakpoints.find(static_cast<u32>(operation - mOperations.data()));
+                if (breakpoint == mBreakpoints.end()) {
+                    throw std::runtime_error("Invalid instruction type");
+                }
+
+                // Arriving at a trap stops, even at the start of a run. Only resuming from a reported stop executes the original instruction
+                if (executed != 0 || skippedBreakpoint != pc) {
+                    mStoppedAtBreakpoint = true;
+                    break;
+                }
+
+                operation = &breakpoint->second;
+            }
+
+            if (operation->linkage != Linkage::None) {
+                // The unconditional forms are simple enough to skip the handler call
+                const Operation* predicted = nullptr;
+                const cold::Instruction instr = operation->instr;
+                if (instr.getType() == (int)cold::Instruction::Type::BL) {
+                    registers.lr = pc;
+                    registers.pc = pc + instr.getS24Data();
+                    this->pushReturn(pc);
+                } else if (instr.getType() == (int)cold::Instruction::Type::BLR) {
+                    registers.pc = registers.lr + 1;
+                    predicted = this->popReturn(registers.lr);
+                } else {
+                    predicted = this->link(processor, *operation);
+                }
+
+                executed++;
+
+                if (StopAtBlockEnd) {
+                    break;
+                }
+
+                // A predicted return runs its target right away, its range is known to be good
+                if (predicted == nullptr || predicted->handler == nullptr || processor.isFinished() || executed >= maxInstructions) {
+                    pc = registers.pc;
+                    continue;
+                }
+
+                operation = predicted;
+            }
+
+            if (operation->handler == nullptr) {
+                throw std::runtime_error("Invalid instruction type");
+            }
+        }
+
+        (processor.*operation->handler)(operation->instr);
+
+        pc = registers.pc + 1;
+        registers.pc = pc;
+        executed++;
+
+        if (StopAtBlockEnd && operation->instr.isBranch()) {
+            break;
+        }
+    }
+
+    return executed;
+}
+
+void cold::PredecodedEngine::decode(const cold::Memory& memory) {
+    mDecodedCode = memory.getCode();
+    mReturnStack.fill({ .lr = 0, .operation = nullptr });
+
+    mOperations.clear();
+    mOperations.reserve(mDecodedCode->size());
+
+    for (const cold::Instruction& instr : *mDecodedCode) {
+        const u8 type = instr.getType();
+        const auto handler = type < (int)cold::Instruction::Type::Count ? cold::Processor::sInstructionHandlers[type] : nullptr;
+
+        const Linkage linkage = instr.isLinkBranch() ? Linkage::Call : instr.isReturnBranch() ? Linkage::Return : Linkage::None;
+
+        // Calls and returns dispatch through the slow path, so other instructions pay nothing for the shadow stack
+        mOperations.push_back({ .handler = linkage == Linkage::None ? handler : nullptr, .instr = instr, .linkage = linkage });
+    }
+
+    for (auto& [pc, original] : mBreakpoints) {
+        this->patch(pc);
+    }
+}
+
+void cold::PredecodedEngine::insertBreakpoint(const u32 pc) {
+    if (mBreakpoints.contains(pc)) {
+        return;
+    }
+
+    mBreakpoints[pc] = {};
+    this->patch(pc);
+}
+
+void cold::PredecodedEngine::removeBreakpoint(const u32 pc) {
+    const auto breakpoint = mBreakpoints.find(pc);
+    if (breakpoint == mBreakpoints.end()) {
+        return;
+    }
+
+    if (pc < mOperations.size()) {
+        mOperations[pc] = breakpoint->second;
+    }
+
+    mBreakpoints.erase(breakpoint);
+}
+
+void cold::PredecodedEngine::clearBreakpoints() {
+    while (!mBreakpoints.empty()) {
+        this->removeBreakpoint(mBreakpoints.begin()->first);
+    }
+}
+
+void cold::PredecodedEngine::patch(const u32 pc) {
+    // Breakpoints outside the code are kept until a decode brings them into range
+    if (pc >= mOperations.size()) {
+        return;
+    }
+
+    mBreakpoints[pc] = mOperations[pc];
+    mOperations[pc].handler = nullptr;
+    mOperations[pc].linkage = Linkage::None;
+}
+
+const cold::PredecodedEngine::Operation* cold::PredecodedEngine::link(cold::Processor& processor, const Operation& operation) {
+    cold::Processor::Registers& registers = processor.getRegisters();
+    const u32 pc = registers.pc;
+
+    (processor.*cold::Processor::sInstructionHandlers[operation.instr.getType()])(operation.instr);
+    registers.pc++;
+
+    // Only taken branches touch the shadow stack
+    if (operation.linkage == Linkage::Call) {
+        if (registers.lr == pc) {
+            this->pushReturn(pc);
+        }
+
+        return nullptr;
+    }
+
+    if (registers.pc != registers.lr + 1) {
+        return nullptr;
+    }
+
+    return this->popReturn(registers.lr);
+}
+
+void cold::PredecodedEngine::pushReturn(const u32 lr) {
+    // Calls from the last instruction return past the code, which the slow path faults on
+    const Operation* operation = static_cast<u64>(lr) + 1 < mOperations.size() ? &mOperations[lr + 1] : nullptr;
+
+    mReturnTop = (mReturnTop + 1) % cReturnStackSize;
+    mReturnStack[mReturnTop] = { .lr = lr, .operation = operation };
+}
+
+const cold::PredecodedEngine::Operation* cold::PredecodedEngine::popReturn(const u32 lr) {
+    const ReturnAddress top = mReturnStack[mReturnTop];
+    mReturnTop = (mReturnTop + cReturnStackSize - 1) % cReturnStackSize;
+
+    // Entries only depend on the link register, so a stale one that still matches is as good as a fresh one
+    return top.lr == lr ? top.operation : nullptr;
+}
@@ -1,16 +1,28 @@
 #include "Cold/Processor.h"
+#include "Cold/FileSystem.h"
 #include "Cold/Memory.h"
 
 #include <iostream>
+#include <string>
 
 using enum cold::Processor::Registers::CompareRegister::Flags;
 
 cold::Processor::Processor(cold::Memory& memory)
     : mRegisters()
     , mMemory(&memory)
+    , mOutput(&std::cout)
+    , mFileSystem()
     , mFinished(false)
 { }
 
+cold::Processor::Processor(cold::Memory& memory, const Processor& state)
+    : mRegisters(state.mRegisters)
+    , mMemory(&memory)
+    , mOutput(state.mOutput)
+    , mFileSystem(state.mFileSystem)
+    , mFinished(state.mFinished)
+{ }
+
 const cold::Processor::InstructionHandler cold::Processor::sInstructionHandlers[] = {
     &Processor::handleSETI,
     &Processor::handleSYSCALL,
@@ -95,11 +107,33 @@ void cold::Processor::handleSYSCALL(const cold::Instruction& instr) {
             const u8 targetReg = instr.getData() >> 8 & 0xFF;
             const char character = mRegisters.gpr[targetReg] & 0xFF;
 
-            std::cout << character;
+            if (mOutput != nullptr) {
+                *mOutput << character;
+            }
             
             break;
         }
 
+        case Instruction::SyscallType::PRINTS: {
+            // byte 2: address reg
+            // byte 3: length reg
+
+            const u8 addressReg = instr.getData() >> 8 & 0xFF;
+            const u8 lengthReg = instr.getData() & 0xFF;
+            const u32 length = mRegisters.gpr[lengthReg];
+
+            // One bounds check for the whole span, then the pages are written out in place. Out of bounds faults even without an output
+            mMemory->readSpans(mRegisters.gpr[addressReg], length, [this](const std::span<const u8> span) {
+                if (mOutput != nullptr) {
+                    mOutput->write(reinterpret_cast<const char*>(span.data()), static_cast<std::streamsize>(span.size()));
+                }
+
+                return true;
+            });
+
+            break;
+        }
+
         case Instruction::SyscallType::HALT: {
             // byte 2-3: unused
 
@@ -125,7 +159,9 @@ void cold::Processor::handleSYSCALL(const cold::Instruction& instr) {
             const u8 targetReg = instr.getData() >> 8 & 0xFF;
             const u32 value = mRegisters.gpr[targetReg];
 
-            std::cout << value;
+            if (mOutput != nullptr) {
+                *mOutput << value;
+            }
 
             break;
         }
@@ -137,7 +173,69 @@ void cold::Processor::handleSYSCALL(const cold::Instruction& instr) {
             const u8 targetReg = instr.getData() >> 8 & 0xFF;
             const f32 value = *reinterpret_cast<const f32*>(&mRegisters.gpr[targetReg]);
 
-            std::cout << value;
+            if (mOutput != nullptr) {
+                *mOutput << value;
+            }
+
+            break;
+        }
+
+        case Instruction::SyscallType::ALLOC: {
+            // byte 2: output reg
+            // byte 3: size reg
+
+            const u8 outReg = instr.getData() >> 8 & 0xFF;
+            const u8 sizeReg = instr.getData() & 0xFF;
+            const u32 stackPointer = mRegisters.gpr[Registers::GPRArray::cStackPointerRegister];
+
+            mRegisters.gpr[outReg] = mMemory->allocate(mRegisters.gpr[sizeReg], stackPointer);
+
+            break;
+        }
+
+        case Instruction::SyscallType::FREE: {
+            // byte 2: address reg
+            // byte 3: unused
+
+            const u8 addressReg = instr.getData() >> 8 & 0xFF;
+            mMemory->free(mRegisters.gpr[addressReg]);
+
+            break;
+        }
+
+        case Instruction::SyscallType::REALLOC: {
+            // byte 2: address reg, receives the new address
+            // byte 3: size reg
+
+            const u8 addressReg = instr.getData() >> 8 & 0xFF;
+            const u8 sizeReg = instr.getData() & 0xFF;
+            const u32 stackPointer = mRegisters.gpr[Registers::GPRArray::cStackPointerRegister];
+
+            mRegisters.gpr[addressReg] = mMemory->reallocate(mRegisters.gpr[addressReg], mRegisters.gpr[sizeReg], stackPointer);
+
+            break;
+        }
+
+        case Instruction::SyscallType::GROW: {
+            // byte 2: size reg, receives the previous memory size
+            // byte 3: unused
+
+            const u8 sizeReg = instr.getData() >> 8 & 0xFF;
+            mRegisters.gpr[sizeReg] = mMemory->grow(mRegisters.gpr[sizeReg]);
+
+            break;
+        }
+
+        case Instruction::SyscallType::OPEN:
+        case Instruction::SyscallType::READ:
+        case Instruction::SyscallType::WRITE:
+        case Instruction::SyscallType::CLOSE:
+        case Instruction::SyscallType::MMAP: {
+            // byte 2: first argument reg, receives the result
+            // byte 3: unused
+
+            const u8 reg = instr.getData() >> 8 & 0xFF;
+            mRegisters.gpr[reg] = this->handleFileSyscall(syscallType, reg);
 
             break;
         }
@@ -148,6 +246,111 @@ void cold::Processor::handleSYSCALL(const cold::Instruction& instr) {
     }
 }
 
+u32 cold::Processor::handleFileSyscall(const Instruction::SyscallType type, const u8 reg) {
+    constexpr u32 cFailure = ~0u;
+    constexpr u32 cMaxPathLength = 4096;
+
+    if (mFileSystem == nullptr) {
+        return type == Instruction::SyscallType::MMAP ? 0 : cFailure;
+    }
+
+    const u32 fd = mRegisters.gpr[reg];
+
+    switch (type) {
+        case Instruction::SyscallType::OPEN: {
+            // reg: path address, reg + 1: mode
+
+            std::string path;
+            for (u32 address = fd; ; address++) {
+                const u8 character = mMemory->readRW(address);
+                if (character == 0) {
+                    break;
+                }
+
+                if (path.size() >= cMaxPathLength) [[unlikely]] {
+                    return cFailure;
+                }
+
+                path += static_cast<char>(character);
+            }
+
+            const u32 mode = mRegisters.gpr[reg + 1];
+            if (mode > static_cast<u32>(cold::FileSystem::OpenMode::Append)) {
+                return cFailure;
+            }
+
+            return mFileSystem->open(path, static_cast<cold::FileSystem::OpenMode>(mode)).value_or(cFailure);
+        }
+
+        case Instruction::SyscallType::READ: {
+            // reg: fd, reg + 1: buffer address, reg + 2: length
+
+            const u32 address = mRegisters.gpr[reg + 1];
+            const u32 length = mRegisters.gpr[reg + 2];
+
+            if (length == 0) {
+                return mFileSystem->read(fd, nullptr, 0).value_or(cFailure);
+            }
+
+            // The whole destination is checked before the file is touched, so a fault or watchpoint hit consumes no input.
+            // The file is then read page by page straight into guest memory
+            bool failed = false;
+            const u32 count = mMemory->writeSpans(address, length, [&](const std::span<u8> span) {
+                const std::optional<u32> read = mFileSystem->read(fd, span.data(), static_cast<u32>(span.size()));
+                failed = !read.has_value();
+                return read.value_or(0);
+            });
+
+            return failed && count == 0 ? cFailure : count;
+        }
+
+        case Instruction::SyscallType::WRITE: {
+            // reg: fd, reg + 1: buffer address, reg + 2: length
+
+            const u32 address = mRegisters.gpr[reg + 1];
+            const u32 length = mRegisters.gpr[reg + 2];
+
+            if (length == 0) {
+                return mFileSystem->write(fd, nullptr, 0).value_or(cFailure);
+            }
+
+            // Written from guest memory page by page, a short write ends the syscall like it would on the host
+            bool failed = false;
+            u32 count = 0;
+            mMemory->readSpans(address, length, [&](const std::span<const u8> span) {
+                const std::optional<u32> written = mFileSystem->write(fd, span.data(), static_cast<u32>(span.size()));
+                failed = !written.has_value();
+                count += written.value_or(0);
+                return written == span.size();
+            });
+
+            return failed && count == 0 ? cFailure : count;
+        }
+
+        case Instruction::SyscallType::CLOSE: {
+            // reg: fd
+
+            return mFileSystem->close(fd) ? 0 : cFailure;
+        }
+
+        case Instruction::SyscallType::MMAP: {
+            // reg: fd, reg + 1: file offset, reg + 2: length or 0 for the rest of the file
+
+            const std::optional<cold::FileSystem::Mapping> mapping = mFileSystem->map(fd, mRegisters.gpr[reg + 1], mRegisters.gpr[reg + 2]);
+            if (!mapping.has_value()) {
+                return 0;
+            }
+
+            const u32 stackPointer = mRegisters.gpr[Registers::GPRArray::cStackPointerRegister];
+            return mMemory->map(mapping->data, mapping->length, stackPointer);
+        }
+
+        default: {
+            throw std::runtime_error("Invalid syscall type");
+        }
+    }
+}
+
 void cold::Processor::handleADD(const cold::Instruction& instr) {
     // byte 0: 0x02
     // byte 1: out reg
@@ -700,7 +903,7 @@ void cold::Processor::handleSTB(const cold::Instruction& instr) {
     const u32 inRegu = mRegisters.gpr[inReg];
     const s8 offset = offsetUnsigned;
 
-    mMemory->readRW(mRegisters.gpr[addrReg] + offset) = mRegisters.gpr[inReg] & 0xFF;
+    mMemory->writeRW(mRegisters.gpr[addrReg] + offset) = mRegisters.gpr[inReg] & 0xFF;
 }
 
 void cold::Processor::handleSTH(const cold::Instruction& instr) {
@@ -713,8 +916,8 @@ void cold::Processor::handleSTH(const cold::Instruction& instr) {
     const u32 inRegu = mRegisters.gpr[inReg];
     const s8 offset = offsetUnsigned;
 
-    mMemory->readRW(mRegisters.gpr[addrReg] + offset) = inRegu >> 8 & 0xFF;
-    mMemory->readRW(mRegisters.gpr[addrReg] + offset + 1) = inRegu & 0xFF;
+    mMemory->writeRW(mRegisters.gpr[addrReg] + offset) = inRegu >> 8 & 0xFF;
+    mMemory->writeRW(mRegisters.gpr[addrReg] + offset + 1) = inRegu & 0xFF;
 }
 
 void cold::Processor::handleSTW(const cold::Instruction& instr) {
@@ -727,10 +930,10 @@ void cold::Processor::handleSTW(const cold::Instruction& instr) {
     const u32 inRegu = mRegisters.gpr[inReg];
     const s8 offset = offsetUnsigned;
 
-    mMemory->readRW(mRegisters.gpr[addrReg] + offset) = inRegu >> 24 & 0xFF;
-    mMemory->readRW(mRegisters.gpr[addrReg] + offset + 1) = inRegu >> 16 & 0xFF;
-    mMemory->readRW(mRegisters.gpr[addrReg] + offset + 2) = inRegu >> 8 & 0xFF;
-    mMemory->readRW(mRegisters.gpr[addrReg] + offset + 3) = inRegu & 0xFF;
+    mMemory->writeRW(mRegisters.gpr[addrReg] + offset) = inRegu >> 24 & 0xFF;
+    mMemory->writeRW(mRegisters.gpr[addrReg] + offset + 1) = inRegu >> 16 & 0xFF;
+    mMemory->writeRW(mRegisters.gpr[addrReg] + offset + 2) = inRegu >> 8 & 0xFF;
+    mMemory->writeRW(mRegisters.gpr[addrReg] + offset + 3) = inRegu & 0xFF;
 }
 
 void cold::Processor::handleMFLR(const cold::Instruction& instr) {
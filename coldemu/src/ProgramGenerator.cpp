@@ -0,0 +1,116 @@
+#include "Cold/ProgramGenerator.h"
+
+namespace {
+
+    using Type = cold::Instruction::Type;
+    using SyscallType = cold::Instruction::SyscallType;
+
+    cold::Instruction makeInstruction(const u8 type, const u8 byte1, const u8 byte2, const u8 byte3) {
+        cold::Instruction instr;
+        instr.setData((u32)type << 24 | (u32)byte1 << 16 | (u32)byte2 << 8 | byte3);
+        return instr;
+    }
+
+    cold::Instruction makeBranch(const Type type, const s32 offset) {
+        cold::Instruction instr;
+        instr.setData((u32)type << 24 | ((u32)offset & 0xFFFFFF));
+        return instr;
+    }
+
+}
+
+cold::ProgramGenerator::ProgramGenerator(const u64 seed)
+    : mRandom(seed)
+{ }
+
+std::vector<cold::Instruction> cold::ProgramGenerator::generate(const u32 length) {
+    std::vector<cold::Instruction> program;
+    program.reserve(length + 2);
+
+    program.push_back(makeInstruction((u8)Type::SYSCALL, (u8)SyscallType::QMB, cBaseRegister, 0));
+
+    while (program.size() < length + 1) {
+        program.push_back(this->randomInstruction(static_cast<u32>(program.size()), length + 2));
+    }
+
+    program.push_back(makeInstruction((u8)Type::SYSCALL, (u8)SyscallType::HALT, 0, 0));
+
+    // Programs are stored big endian
+    for (cold::Instruction& instr : program) {
+        const u32 data = instr.getData();
+        instr.setData(((data >> 24) & 0xFF) | ((data << 8) & 0xFF0000) | ((data >> 8) & 0xFF00) | ((data << 24) & 0xFF000000));
+    }
+
+    return program;
+}
+
+cold::Instruction cold::ProgramGenerator::randomInstruction(const u32 pc, const u32 length) {
+    const u32 roll = this->below(100);
+
+    // A sprinkling of garbage words checks that invalid instructions fault the same way everywhere
+    if (roll == 0) {
+        return makeInstruction(static_cast<u8>(this->below(256)), static_cast<u8>(this->below(256)), static_cast<u8>(this->below(256)), static_cast<u8>(this->below(256)));
+    }
+
+    const Type type = Type(this->below((u32)Type::Count));
+
+    switch (type) {
+        case Type::SYSCALL: {
+            constexpr SyscallType cSyscalls[] = { SyscallType::PRINT, SyscallType::IPRINT, SyscallType::FPRINT, SyscallType::QMB, SyscallType::HALT };
+            const SyscallType syscall = cSyscalls[this->below(sizeof(cSyscalls) / sizeof(cSyscalls[0]))];
+
+            const u8 reg = syscall == SyscallType::QMB ? this->randomOutputRegister() : this->randomRegister();
+            return makeInstruction((u8)type, (u8)syscall, reg, 0);
+        }
+
+        case Type::LDB: case Type::LDH: case Type::LDW:
+        case Type::STB: case Type::STH: case Type::STW: {
+            const bool store = type >= Type::STB;
+            const u8 reg = store ? this->randomRegister() : this->randomOutputRegister();
+            const u8 base = this->below(4) != 0 ? cBaseRegister : this->randomRegister();
+
+            return makeInstruction((u8)type, reg, base, static_cast<u8>(this->below(64)));
+        }
+
+        case Type::MTLR:
+            return makeInstruction((u8)type, this->randomRegister(), 0, 0);
+
+        case Type::MFLR:
+            return makeInstruction((u8)type, this->randomOutputRegister(), 0, 0);
+
+        case Type::CMPI:
+            return makeInstruction((u8)type, this->randomRegister(), static_cast<u8>(this->below(256)), static_cast<u8>(this->below(256)));
+
+        case Type::CMP: case Type::FCMP:
+            return makeInstruction((u8)type, this->randomRegister(), this->randomRegister(), 0);
+
+        case Type::ADD: case Type::SUB: case Type::MUL:
+        case Type::AND: case Type::OR: case Type::XOR:
+        case Type::FADD: case Type::FSUB: case Type::FMUL: case Type::FDIV:
+            return makeInstruction((u8)type, this->randomOutputRegister(), this->randomRegister(), this->randomRegister());
+
+        default:
+            break;
+    }
+
+    if (cold::Instruction probe = makeInstruction((u8)type, 0, 0, 0); probe.isRelativeBranch()) {
+        // Keep targets inside the program, mostly forward so that loops stay rare
+        const s32 offset = this->below(4) != 0
+            ? static_cast<s32>(1 + this->below(length - pc - 1))
+            : -static_cast<s32>(this->below(pc + 1));
+
+        return makeBranch(type, offset);
+    }
+
+    return makeInstruction((u8)type, this->randomOutputRegister(), this->randomRegister(), static_cast<u8>(this->below(256)));
+}
+
+u8 cold::ProgramGenerator::randomOutputRegister() {
+    const u8 reg = this->randomRegister();
+
+    if (reg == cBaseRegister && this->below(8) != 0) {
+        return static_cast<u8>(reg + 1);
+    }
+
+    return reg;
+}
@@ -0,0 +1,92 @@
+#include "Cold/TieredEngine.h"
+#include "Cold/CompileQueue.h"
+#include "Cold/Memory.h"
+#include "Cold/Processor.h"
+
+u64 cold::TieredEngine::execute(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) {
+    return this->run<false>(processor, memory, maxInstructions);
+}
+
+u64 cold::TieredEngine::executeBlock(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) {
+    return this->run<true>(processor, memory, maxInstructions);
+}
+
+template <bool StopAtBlockEnd>
+u64 cold::TieredEngine::run(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) {
+    // Machines sharing the cache load their own copy of the image, so the cache's code pointer would never match theirs
+    if (mCache == nullptr || memory.getCode() != mCode) [[unlikely]] {
+        this->reset(memory);
+    }
+
+    cold::Processor::Registers& registers = processor.getRegisters();
+    const cold::TranslationCache& cache = *mCache;
+    u64 executed = 0;
+
+    while (!processor.isFinished() && executed < maxInstructions) [[likely]] {
+        const u32 pc = registers.pc;
+
+        // Anything outside the code, including pcs whose address wraps back into it, is left to the interpreter
+        if (pc < cache.getSize()) [[likely]] {
+            const cold::CompiledBlock* block = cache.lookup(pc);
+
+            if (block != nullptr && block->getLength() <= maxInstructions - executed) [[likely]] {
+                if (block->getTier() != Tier::Compiled) {
+                    this->promote(pc);
+                }
+
+                executed += block->execute(processor);
+
+                // Blocks cut short by their length limit end where the interpreter would keep going
+                if (StopAtBlockEnd && block->endsWithBranch()) {
+                    break;
+                }
+
+                continue;
+            }
+
+            this->promote(pc);
+        }
+
+        executed += mInterpreter.executeBlock(processor, memory, maxInstructions - executed);
+
+        if (StopAtBlockEnd) {
+            break;
+        }
+    }
+
+    return executed;
+}
+
+void cold::TieredEngine::reset(const cold::Memory& memory) {
+    mCode = memory.getCode();
+    mCache = cold::TranslationCache::get(mCode);
+    mCounters.assign(mCache->getSize(), 0);
+}
+
+void cold::TieredEngine::promote(const u32 pc) {
+    u32& count = mCounters[pc];
+    if (count >= cCompileThreshold) {
+        return;
+    }
+
+    count++;
+
+    if (count == cPredecodeThreshold) {
+        this->request(pc, Tier::Predecoded);
+    } else if (count == cCompileThreshold) {
+        this->request(pc, Tier::Compiled);
+    }
+}
+
+void cold::TieredEngine::request(const u32 pc, const Tier tier) {
+    // Another engine on the same image may have queued this tier already
+    if (!mCache->claim(pc, tier)) {
+        return;
+    }
+
+    // A full queue is retried on the next entry of the block
+    if (!cold::CompileQueue::getShared().submit(mCache, pc, tier)) {
+        mCache->unclaim(pc, tier);
+        mCounters[pc]--;
+    }
+}
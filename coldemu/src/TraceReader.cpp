@@ -0,0 +1,216 @@
+#include "Cold/TraceReader.h"
+#include "Cold/TraceFormat.h"
+#include "Cold/Varint.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+    u32 readWord(std::istream& in) {
+        u8 bytes[4];
+        if (!in.read(reinterpret_cast<char*>(bytes), sizeof(bytes))) {
+            throw std::runtime_error("Unexpected end of trace");
+        }
+
+        return (u32)bytes[0] | (u32)bytes[1] << 8 | (u32)bytes[2] << 16 | (u32)bytes[3] << 24;
+    }
+
+    u32 applyDelta(const u32 previous, const u64 encoded) {
+        return previous + static_cast<u32>(cold::varint::unzigzag(encoded));
+    }
+
+    u32 storeSize(const cold::Instruction::Type type) {
+        switch (type) {
+            case cold::Instruction::Type::STB: return 1;
+            case cold::Instruction::Type::STH: return 2;
+            case cold::Instruction::Type::STW: return 4;
+            default: return 0;
+        }
+    }
+
+}
+
+cold::TraceReader::TraceReader(const std::string& path)
+    : mFile(path, std::ios::binary | std::ios::in)
+    , mMemorySize(0)
+    , mRegisters()
+    , mLr(0)
+    , mPc(0)
+    , mLastAddress(0)
+    , mIndex(0)
+    , mEntryCount(std::numeric_limits<u64>::max())
+    , mChunks()
+{
+    if (!mFile.is_open()) {
+        throw std::runtime_error("Failed to open trace file");
+    }
+
+    if (readWord(mFile) != cold::trace::cMagic) {
+        throw std::runtime_error("Not a trace file");
+    }
+
+    // Version 1 is the same stream without the index
+    const u64 version = cold::varint::read(mFile);
+    if (version != 1 && version != cold::trace::cVersion) {
+        throw std::runtime_error("Unsupported trace version");
+    }
+
+    mMemorySize = static_cast<u32>(cold::varint::read(mFile));
+    mPc = static_cast<u32>(cold::varint::read(mFile));
+
+    for (u32& reg : mRegisters) {
+        reg = static_cast<u32>(cold::varint::read(mFile));
+    }
+
+    mLr = static_cast<u32>(cold::varint::read(mFile));
+    (void)cold::varint::read(mFile); // cr
+
+    mCode.resize(cold::varint::read(mFile));
+    for (cold::Instruction& instr : mCode) {
+        instr.setData(readWord(mFile));
+    }
+
+    if (version >= 2) {
+        this->readIndex();
+    }
+}
+
+void cold::TraceReader::readIndex() {
+    const std::streampos entries = mFile.tellg();
+
+    mFile.seekg(0, std::ios::end);
+    const std::streamoff size = mFile.tellg() - entries;
+    if (size < cold::trace::cTrailerSize) {
+        mFile.seekg(entries);
+        return;
+    }
+
+    const u64 trailer = static_cast<u64>(mFile.tellg()) - cold::trace::cTrailerSize;
+    mFile.seekg(static_cast<std::streamoff>(trailer));
+
+    u64 indexOffset = readWord(mFile);
+    indexOffset |= static_cast<u64>(readWord(mFile)) << 32;
+    u64 entryCount = readWord(mFile);
+    entryCount |= static_cast<u64>(readWord(mFile)) << 32;
+
+    // Without the trailer the recorder never closed, the entries run up to the end of the file
+    if (readWord(mFile) != cold::trace::cIndexMagic) {
+        mFile.seekg(entries);
+        return;
+    }
+
+    if (indexOffset < static_cast<u64>(entries) || indexOffset > trailer) {
+        throw std::runtime_error("Corrupt trace index");
+    }
+
+    mFile.seekg(static_cast<std::streamoff>(indexOffset));
+
+    // Every field takes at least a byte, which bounds the count before anything is allocated for it
+    constexpr u64 cMinChunkSize = 7 + cold::Processor::Registers::GPRArray::cGPRCount + cold::trace::cBloomWords;
+
+    const u64 chunkCount = cold::varint::read(mFile);
+    if (chunkCount > (trailer - indexOffset) / cMinChunkSize) {
+        throw std::runtime_error("Corrupt trace index");
+    }
+
+    mChunks.resize(chunkCount);
+    for (cold::trace::Chunk& chunk : mChunks) {
+        chunk.offset = cold::varint::read(mFile);
+        chunk.firstEntry = cold::varint::read(mFile);
+        chunk.pc = static_cast<u32>(cold::varint::read(mFile));
+
+        for (u32& reg : chunk.registers) {
+            reg = static_cast<u32>(cold::varint::read(mFile));
+        }
+
+        chunk.lr = static_cast<u32>(cold::varint::read(mFile));
+        chunk.lastAddress = static_cast<u32>(cold::varint::read(mFile));
+        chunk.storeBegin = cold::varint::read(mFile);
+        chunk.storeEnd = cold::varint::read(mFile);
+
+        for (u64& word : chunk.bloom) {
+            word = cold::varint::read(mFile);
+        }
+    }
+
+    mEntryCount = entryCount;
+    mFile.seekg(entries);
+}
+
+void cold::TraceReader::seek(const std::size_t chunk) {
+    const cold::trace::Chunk& start = mChunks.at(chunk);
+
+    mFile.clear();
+    mFile.seekg(static_cast<std::streamoff>(start.offset));
+
+    std::copy(std::begin(start.registers), std::end(start.registers), mRegisters);
+    mLr = start.lr;
+    mPc = start.pc;
+    mLastAddress = start.lastAddress;
+    mIndex = start.firstEntry;
+}
+
+bool cold::TraceReader::next(Entry& entry) {
+    if (mIndex >= mEntryCount) {
+        return false;
+    }
+
+    const int tagByte = mFile.get();
+    if (tagByte == std::ifstream::traits_type::eof()) {
+        return false;
+    }
+
+    const u8 tag = static_cast<u8>(tagByte);
+
+    entry.index = mIndex++;
+    entry.pc = mPc;
+    entry.instr = mPc < mCode.size() ? mCode[mPc] : cold::Instruction();
+    entry.tags = tag;
+    entry.value = 0;
+    entry.address = 0;
+    entry.size = 0;
+    entry.fault.clear();
+
+    if (tag == cold::trace::cFaultTag) {
+        entry.tags = 0;
+        entry.fault.resize(cold::varint::read(mFile));
+        mFile.read(entry.fault.data(), entry.fault.size());
+        return true;
+    }
+
+    if (tag == cold::trace::cWriteTag) {
+        mLastAddress = applyDelta(mLastAddress, cold::varint::read(mFile));
+        entry.tags = cold::trace::Memory;
+        entry.address = mLastAddress;
+        entry.size = static_cast<u32>(cold::varint::read(mFile));
+        return true;
+    }
+
+    u32 nextPc = mPc + 1;
+    if (tag & cold::trace::Jump) {
+        nextPc = applyDelta(nextPc, cold::varint::read(mFile));
+    }
+
+    if (tag & cold::trace::Register) {
+        const u8 reg = entry.instr.getOutputRegister().value_or(0) & 0x1F;
+        mRegisters[reg] = applyDelta(mRegisters[reg], cold::varint::read(mFile));
+        entry.value = mRegisters[reg];
+    }
+
+    if (tag & cold::trace::Memory) {
+        mLastAddress = applyDelta(mLastAddress, cold::varint::read(mFile));
+        entry.address = mLastAddress;
+        entry.size = storeSize(cold::Instruction::Type(entry.instr.getType()));
+        entry.value = static_cast<u32>(cold::varint::read(mFile));
+    }
+
+    if (tag & cold::trace::Link) {
+        mLr = applyDelta(mLr, cold::varint::read(mFile));
+    }
+
+    mPc = nextPc;
+
+    return true;
+}
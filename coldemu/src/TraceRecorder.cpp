@@ -0,0 +1,230 @@
+#include "Cold/TraceRecorder.h"
+#include "Cold/Varint.h"
+#include "Cold/VirtualMachine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+
+    constexpr std::size_t cFlushSize = 1 << 20;
+
+}
+
+namespace {
+
+    void writeWord(std::ostream& out, const u32 word) {
+        const char bytes[] = { (char)(word & 0xFF), (char)(word >> 8 & 0xFF), (char)(word >> 16 & 0xFF), (char)(word >> 24 & 0xFF) };
+        out.write(bytes, sizeof(bytes));
+    }
+
+    u64 delta(const u32 value, const u32 previous) {
+        return cold::varint::zigzag(static_cast<s32>(value - previous));
+    }
+
+}
+
+cold::TraceRecorder::TraceRecorder(const std::string& path, cold::VirtualMachine& vm)
+    : mFile(path, std::ios::binary | std::ios::out)
+    , mRing(cRingCapacity)
+    , mStopping(false)
+    , mBuffer()
+    , mRegisters()
+    , mLr(0)
+    , mLastAddress(0)
+    , mEntryCount(0)
+    , mBytesWritten(0)
+    , mFlushedBytes(0)
+    , mChunks()
+{
+    if (!mFile.is_open()) {
+        throw std::runtime_error("Failed to open trace file");
+    }
+
+    this->writeHeader(vm);
+    mFlushedBytes = static_cast<u64>(mFile.tellp());
+
+    mWriter = std::thread(&TraceRecorder::writerLoop, this);
+}
+
+cold::TraceRecorder::~TraceRecorder() {
+    this->close();
+}
+
+void cold::TraceRecorder::close() {
+    if (!mWriter.joinable()) {
+        return;
+    }
+
+    mStopping.store(true, std::memory_order_release);
+    mWriter.join();
+
+    mBytesWritten = static_cast<u64>(mFile.tellp());
+    mFile.close();
+}
+
+void cold::TraceRecorder::recordFault(const u32 pc, const std::string& message) {
+    mFaultMessage = message;
+
+    this->record({ .pc = pc, .nextPc = pc, .value = 0, .address = 0, .lr = 0, .tags = 0, .reg = 0, .cr = 0, .fault = true });
+}
+
+void cold::TraceRecorder::writeHeader(cold::VirtualMachine& vm) {
+    cold::Processor::Registers& registers = vm.getProcessor().getRegisters();
+    const std::vector<cold::Instruction>& code = *vm.getMemory().getCode();
+
+    writeWord(mFile, cold::trace::cMagic);
+    cold::varint::write(mFile, cold::trace::cVersion);
+    cold::varint::write(mFile, vm.getMemory().getSize());
+    cold::varint::write(mFile, registers.pc);
+
+    for (u32 i = 0; i < cold::Processor::Registers::GPRArray::cGPRCount; i++) {
+        mRegisters[i] = registers.gpr[i];
+        cold::varint::write(mFile, mRegisters[i]);
+    }
+
+    mLr = registers.lr;
+    cold::varint::write(mFile, mLr);
+    cold::varint::write(mFile, registers.cr.getFlags());
+
+    cold::varint::write(mFile, code.size());
+    for (const cold::Instruction& instr : code) {
+        writeWord(mFile, instr.getData());
+    }
+}
+
+void cold::TraceRecorder::writerLoop() {
+    cold::trace::Event batch[256];
+
+    while (true) {
+        // Read the flag before draining, so events pushed before the flag was set are never left behind
+        const bool stopping = mStopping.load(std::memory_order_acquire);
+        const u32 count = mRing.popBatch(batch, sizeof(batch) / sizeof(batch[0]));
+
+        for (u32 i = 0; i < count; i++) {
+            this->encode(batch[i]);
+        }
+
+        if (mBuffer.size() >= cFlushSize) {
+            this->flush();
+        }
+
+        if (count == 0) {
+            if (stopping) {
+                break;
+            }
+
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+    this->writeIndex();
+    this->flush();
+    mFile.flush();
+}
+
+void cold::TraceRecorder::flush() {
+    mFile.write(reinterpret_cast<const char*>(mBuffer.data()), mBuffer.size());
+    mFlushedBytes += mBuffer.size();
+    mBuffer.clear();
+}
+
+void cold::TraceRecorder::beginChunk(const u32 pc) {
+    cold::trace::Chunk& chunk = mChunks.emplace_back();
+    chunk.offset = mFlushedBytes + mBuffer.size();
+    chunk.firstEntry = mEntryCount;
+    chunk.pc = pc;
+    std::copy(std::begin(mRegisters), std::end(mRegisters), chunk.registers);
+    chunk.lr = mLr;
+    chunk.lastAddress = mLastAddress;
+    chunk.storeBegin = ~0ull;
+    chunk.storeEnd = 0;
+    std::fill(std::begin(chunk.bloom), std::end(chunk.bloom), 0);
+}
+
+void cold::TraceRecorder::writeIndex() {
+    const u64 indexOffset = mFlushedBytes + mBuffer.size();
+
+    cold::varint::write(mBuffer, mChunks.size());
+    for (const cold::trace::Chunk& chunk : mChunks) {
+        cold::varint::write(mBuffer, chunk.offset);
+        cold::varint::write(mBuffer, chunk.firstEntry);
+        cold::varint::write(mBuffer, chunk.pc);
+
+        for (const u32 reg : chunk.registers) {
+            cold::varint::write(mBuffer, reg);
+        }
+
+        cold::varint::write(mBuffer, chunk.lr);
+        cold::varint::write(mBuffer, chunk.lastAddress);
+        cold::varint::write(mBuffer, chunk.storeBegin);
+        cold::varint::write(mBuffer, chunk.storeEnd);
+
+        for (const u64 word : chunk.bloom) {
+            cold::varint::write(mBuffer, word);
+        }
+    }
+
+    for (const u32 word : { static_cast<u32>(indexOffset), static_cast<u32>(indexOffset >> 32), static_cast<u32>(mEntryCount), static_cast<u32>(mEntryCount >> 32), cold::trace::cIndexMagic }) {
+        for (u32 i = 0; i < 4; i++) {
+            mBuffer.push_back(static_cast<u8>(word >> i * 8));
+        }
+    }
+}
+
+void cold::TraceRecorder::encode(const cold::trace::Event& event) {
+    if (mEntryCount % cold::trace::cChunkEntries == 0) {
+        this->beginChunk(event.pc);
+    }
+
+    mEntryCount++;
+
+    if (event.fault) {
+        mBuffer.push_back(cold::trace::cFaultTag);
+        cold::varint::write(mBuffer, mFaultMessage.size());
+        mBuffer.insert(mBuffer.end(), mFaultMessage.begin(), mFaultMessage.end());
+        return;
+    }
+
+    if (event.tags == cold::trace::cWriteTag) {
+        mBuffer.push_back(cold::trace::cWriteTag);
+        cold::varint::write(mBuffer, delta(event.address, mLastAddress));
+        cold::varint::write(mBuffer, event.value);
+        mLastAddress = event.address;
+
+        mChunks.back().addStore(event.address, event.value);
+        return;
+    }
+
+    u8 tag = event.tags;
+    if (tag & cold::trace::Compare) {
+        tag |= event.cr << cold::trace::cCompareShift;
+    }
+
+    mBuffer.push_back(tag);
+
+    if (tag & cold::trace::Jump) {
+        cold::varint::write(mBuffer, delta(event.nextPc, event.pc + 1));
+    }
+
+    if (tag & cold::trace::Register) {
+        cold::varint::write(mBuffer, delta(event.value, mRegisters[event.reg]));
+        mRegisters[event.reg] = event.value;
+    }
+
+    if (tag & cold::trace::Memory) {
+        cold::varint::write(mBuffer, delta(event.address, mLastAddress));
+        cold::varint::write(mBuffer, event.value);
+        mLastAddress = event.address;
+
+        // The event does not carry the store width, a word covers all of them
+        mChunks.back().addStore(event.address, 4);
+    }
+
+    if (tag & cold::trace::Link) {
+        cold::varint::write(mBuffer, delta(event.lr, mLr));
+        mLr = event.lr;
+    }
+}
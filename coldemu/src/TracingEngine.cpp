@@ -0,0 +1,121 @@
+#include "Cold/TracingEngine.h"
+#include "Cold/Memory.h"
+#include "Cold/Processor.h"
+#include "Cold/TraceRecorder.h"
+
+namespace {
+
+    using Type = cold::Instruction::Type;
+
+    bool isStore(const Type type) {
+        return type == Type::STB || type == Type::STH || type == Type::STW;
+    }
+
+    bool isCompare(const Type type) {
+        return type == Type::CMP || type == Type::FCMP || type == Type::CMPI;
+    }
+
+}
+
+cold::TracingEngine::TracingEngine(cold::TraceRecorder& recorder)
+    : mRecorder(&recorder)
+    , mSyscallWrites()
+{ }
+
+u64 cold::TracingEngine::execute(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) {
+    return this->run<false>(processor, memory, maxInstructions);
+}
+
+u64 cold::TracingEngine::executeBlock(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) {
+    return this->run<true>(processor, memory, maxInstructions);
+}
+
+template <bool StopAtBlockEnd>
+u64 cold::TracingEngine::run(cold::Processor& processor, cold::Memory& memory, const u64 maxInstructions) {
+    cold::Processor::Registers& registers = processor.getRegisters();
+    u64 executed = 0;
+
+    try {
+        while (!processor.isFinished() && executed < maxInstructions) [[likely]] {
+            const u32 pc = registers.pc;
+            const cold::Instruction instr = memory.readX(pc * 4);
+
+            const u8 type = instr.getType();
+            if (type >= (int)cold::Instruction::Type::Count) [[unlikely]] {
+                throw std::runtime_error("Invalid instruction type");
+            }
+
+            const u32 lr = registers.lr;
+            const bool syscall = type == (u8)Type::SYSCALL;
+
+            // Only syscalls write memory without a store, their writes are logged while they run
+            if (syscall) {
+                memory.setWriteLog(&mSyscallWrites);
+            }
+
+            const auto handler = cold::Processor::sInstructionHandlers[type];
+            (processor.*handler)(instr);
+
+            if (syscall) {
+                memory.setWriteLog(nullptr);
+
+                for (const cold::WriteRange& range : mSyscallWrites) {
+                    mRecorder->recordWrite(pc, range);
+                }
+
+                mSyscallWrites.clear();
+            }
+
+            registers.pc++;
+            executed++;
+
+            cold::trace::Event event = { .pc = pc, .nextPc = registers.pc, .value = 0, .address = 0, .lr = registers.lr, .tags = 0, .reg = 0, .cr = 0, .fault = false };
+
+            if (registers.pc != pc + 1) {
+                event.tags |= cold::trace::Jump;
+            }
+
+            if (const std::optional<u8> outReg = instr.getOutputRegister()) {
+                event.tags |= cold::trace::Register;
+                event.reg = *outReg;
+                event.value = registers.gpr[*outReg];
+            } else if (isStore(Type(type))) {
+                // Stores leave their registers untouched, so the address can be recomputed afterwards
+                const auto [inReg, addrReg, offset] = instr.getTripleByteData();
+
+                event.tags |= cold::trace::Memory;
+                event.address = registers.gpr[addrReg] + static_cast<s8>(offset);
+                event.value = registers.gpr[inReg];
+            }
+
+            if (registers.lr != lr) {
+                event.tags |= cold::trace::Link;
+            }
+
+            if (isCompare(Type(type))) {
+                event.tags |= cold::trace::Compare;
+                event.cr = static_cast<u8>(registers.cr.getFlags());
+            }
+
+            mRecorder->record(event);
+
+            if (StopAtBlockEnd && instr.isBranch()) {
+                break;
+            }
+        }
+    } catch (const std::exception& e) {
+        memory.setWriteLog(nullptr);
+
+        // A syscall may fault after part of its writes went through
+        for (const cold::WriteRange& range : mSyscallWrites) {
+            mRecorder->recordWrite(registers.pc, range);
+        }
+
+        mSyscallWrites.clear();
+
+        mRecorder->recordFault(registers.pc, e.what());
+        throw;
+    }
+
+    return executed;
+}
@@ -0,0 +1,94 @@
+#include "Cold/TranslationCache.h"
+#include "Cold/AotModule.h"
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+    bool isSameCode(const std::vector<cold::Instruction>& a, const std::vector<cold::Instruction>& b) {
+        return std::ranges::equal(a, b, {}, &cold::Instruction::getData, &cold::Instruction::getData);
+    }
+
+}
+
+cold::TranslationCache::TranslationCache(std::shared_ptr<const std::vector<cold::Instruction>> code)
+    : mCode(std::move(code))
+    , mSize(mCode != nullptr ? static_cast<u32>(mCode->size()) : 0)
+    , mBlocks(std::make_unique<std::atomic<const cold::CompiledBlock*>[]>(mSize))
+    , mClaims(std::make_unique<std::atomic<Tier>[]>(mSize))
+    , mRetained(nullptr)
+{
+}
+
+cold::TranslationCache::~TranslationCache() {
+    Retained* retained = mRetained.load(std::memory_order_acquire);
+    while (retained != nullptr) {
+        Retained* next = retained->next;
+        delete retained;
+        retained = next;
+    }
+}
+
+std::shared_ptr<cold::TranslationCache> cold::TranslationCache::get(const std::shared_ptr<const std::vector<cold::Instruction>>& code) {
+    if (code == nullptr) {
+        return std::make_shared<TranslationCache>(code);
+    }
+
+    // Only taken when an engine meets a new program, never on the lookup path
+    static std::mutex sMutex;
+    static std::unordered_map<u64, std::weak_ptr<TranslationCache>> sCaches; // By code hash
+
+    const u64 hash = cold::aot::hashCode(*code);
+    const std::lock_guard lock(sMutex);
+
+    const auto found = sCaches.find(hash);
+    if (found != sCaches.end()) {
+        std::shared_ptr<TranslationCache> cache = found->second.lock();
+        if (cache != nullptr && (cache->mCode == code || isSameCode(*cache->mCode, *code))) {
+            return cache;
+        }
+    }
+
+    // A colliding image just gets a cache of its own
+    std::shared_ptr<TranslationCache> cache = std::make_shared<TranslationCache>(code);
+    std::erase_if(sCaches, [](const auto& entry) { return entry.second.expired(); });
+    sCaches[hash] = cache;
+
+    return cache;
+}
+
+bool cold::TranslationCache::claim(const u32 pc, const Tier tier) {
+    Tier claimed = mClaims[pc].load(std::memory_order_relaxed);
+    while (claimed < tier) {
+        if (mClaims[pc].compare_exchange_weak(claimed, tier, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void cold::TranslationCache::unclaim(const u32 pc, const Tier tier) {
+    // Tiers start at Interpreted, so the claim drops back to the tier below. A newer claim of a higher tier is kept
+    Tier claimed = tier;
+    (void)mClaims[pc].compare_exchange_strong(claimed, Tier(static_cast<u8>(tier) - 1), std::memory_order_relaxed);
+}
+
+bool cold::TranslationCache::publish(std::unique_ptr<cold::CompiledBlock> block) {
+    std::atomic<const cold::CompiledBlock*>& slot = mBlocks[block->getBegin()];
+    const cold::CompiledBlock* current = slot.load(std::memory_order_acquire);
+
+    while (current == nullptr || current->getTier() < block->getTier()) {
+        // Release pairs with the acquire in lookup, so the ops are visible before the pointer is
+        if (slot.compare_exchange_weak(current, block.get(), std::memory_order_release, std::memory_order_acquire)) {
+            Retained* retained = new Retained{ .block = std::move(block), .next = mRetained.load(std::memory_order_relaxed) };
+            while (!mRetained.compare_exchange_weak(retained->next, retained, std::memory_order_release, std::memory_order_relaxed)) { }
+
+            return true;
+        }
+    }
+
+    return false;
+}
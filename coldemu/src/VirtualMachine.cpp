@@ -1,6 +1,15 @@
 #include "Cold/VirtualMachine.h"
+#include "Cold/InterpreterEngine.h"
+#include "Cold/Varint.h"
 
 #include <iostream>
+#include <type_traits>
+
+namespace {
+
+    constexpr u32 cCheckpointMagic = 0x54504B43; // "CKPT"
+
+}
 
 std::ostream& operator<<(std::ostream& stream, cold::Processor::Registers& registers) {
    stream << "    ";
@@ -21,49 +30,65 @@ std::ostream& operator<<(std::ostream& stream, cold::Processor::Registers& regis
     return stream;
 }
 
-cold::VirtualMachine::VirtualMachine(const std::vector<cold::Instruction>& program, const u32 memorySize)
+cold::VirtualMachine::VirtualMachine(const std::vector<cold::Instruction>& program, const u64 memorySize)
+    : VirtualMachine(std::span(reinterpret_cast<const u8*>(program.data()), program.size() * sizeof(cold::Instruction)), memorySize)
+{ }
+
+cold::VirtualMachine::VirtualMachine(const std::span<const u8> image, const u64 memorySize)
+    : VirtualMachine(cold::Executable::load(image), memorySize)
+{ }
+
+cold::VirtualMachine::VirtualMachine(cold::Executable executable, const u64 memorySize)
     : mMemory(memorySize)
     , mProcessor(mMemory)
+    , mEngine(std::make_unique<InterpreterEngine>())
+    , mInstructionCount(0)
 {
-    std::vector<cold::Instruction> programEndianSwapped;
-    programEndianSwapped.reserve(program.size());
-
-    // Endian swap to little endian
-    for (auto& instr : program) {
-        u32 data = instr.getData();
-        data = ((data >> 24) & 0xFF) | ((data << 8) & 0xFF0000) | ((data >> 8) & 0xFF00) | ((data << 24) & 0xFF000000);
-        cold::Instruction instrSwapped;
-        instrSwapped.setData(data);
-        programEndianSwapped.push_back(instrSwapped);
-    }
-
     // Ensure memory is large enough to hold the program
-    if (program.size() > memorySize) [[unlikely]] {
+    const u64 codeSize = executable.code.size() * sizeof(cold::Instruction);
+    if (codeSize > memorySize || static_cast<u64>(executable.dataAddress) + executable.data.size() > memorySize) [[unlikely]] {
         throw std::runtime_error("Program too large for memory");
     }
 
-    mMemory.setCode(programEndianSwapped);
+    mMemory.setCode(std::move(executable.code));
+    mMemory.setData(executable.dataAddress, executable.data);
+
+    mProcessor.getRegisters().pc = executable.entry;
 
     // Set stack pointer to the end of the memory
-    mProcessor.getRegisters().gpr[Processor::Registers::GPRArray::cStackPointerRegister] = memorySize - 1;
+    mProcessor.getRegisters().gpr[Processor::Registers::GPRArray::cStackPointerRegister] = static_cast<u32>(memorySize - 1);
+}
+
+cold::VirtualMachine::VirtualMachine(VirtualMachine& parent)
+    : mMemory(parent.mMemory.fork())
+    , mProcessor(mMemory, parent.mProcessor)
+    , mEngine(Engine::create(parent.mEngine->getName()))
+    , mInstructionCount(parent.mInstructionCount)
+{ }
+
+std::unique_ptr<cold::VirtualMachine> cold::VirtualMachine::fork() {
+    return std::unique_ptr<VirtualMachine>(new VirtualMachine(*this));
 }
 
 void cold::VirtualMachine::run() {
     try {
-        while (!mProcessor.isFinished()) [[likely]] {
-            const cold::Instruction& instr = mMemory.readX(mProcessor.getRegisters().pc * 4);
+        this->execute(~0ull);
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+    }
 
-            const u8 type = instr.getType();
-            if (type >= (int)cold::Instruction::Type::Count) [[unlikely]] {
-                throw std::runtime_error("Invalid instruction type");
-            }
+    std::cout << mProcessor.getRegisters();
+}
 
-            const cold::Instruction::Type enumType = static_cast<cold::Instruction::Type>(type);
+void cold::VirtualMachine::run(std::ostream& checkpoints, const u64 checkpointInterval) {
+    Snapshot base = this->snapshot();
 
-            const auto handler = cold::Processor::sInstructionHandlers[type]; // function pointer
-            (mProcessor.*handler)(instr);
+    try {
+        while (!mProcessor.isFinished()) {
+            this->execute(checkpointInterval);
 
-            mProcessor.getRegisters().pc++;
+            this->writeCheckpoint(checkpoints, base);
+            base = this->snapshot();
         }
     } catch (const std::exception& e) {
         std::cerr << "Exception: " << e.what() << std::endl;
@@ -71,3 +96,63 @@ void cold::VirtualMachine::run() {
 
     std::cout << mProcessor.getRegisters();
 }
+
+cold::VirtualMachine::Snapshot cold::VirtualMachine::snapshot() {
+    return {
+        .memory = mMemory.snapshot(),
+        .registers = mProcessor.getRegisters(),
+        .finished = mProcessor.isFinished(),
+        .instructionCount = mInstructionCount
+    };
+}
+
+void cold::VirtualMachine::restore(const Snapshot& snapshot) {
+    mMemory.restore(snapshot.memory);
+    mProcessor.getRegisters() = snapshot.registers;
+    mProcessor.setFinished(snapshot.finished);
+    mInstructionCount = snapshot.instructionCount;
+}
+
+void cold::VirtualMachine::writeCheckpoint(std::ostream& out, const Snapshot& base) {
+    static_assert(std::is_trivially_copyable_v<cold::Processor::Registers>, "Registers must be trivially copyable");
+
+    cold::varint::write(out, cCheckpointMagic);
+    cold::varint::write(out, mInstructionCount);
+    out.put(mProcessor.isFinished() ? 1 : 0);
+    out.write(reinterpret_cast<const char*>(&mProcessor.getRegisters()), sizeof(cold::Processor::Registers));
+
+    mMemory.writeDelta(out, base.memory);
+
+    if (!out) [[unlikely]] {
+        throw std::runtime_error("Failed to write checkpoint");
+    }
+}
+
+void cold::VirtualMachine::readCheckpoint(std::istream& in) {
+    if (cold::varint::read(in) != cCheckpointMagic) [[unlikely]] {
+        throw std::runtime_error("Invalid checkpoint");
+    }
+
+    mInstructionCount = cold::varint::read(in);
+    mProcessor.setFinished(in.get() == 1);
+
+    if (!in.read(reinterpret_cast<char*>(&mProcessor.getRegisters()), sizeof(cold::Processor::Registers))) [[unlikely]] {
+        throw std::runtime_error("Unexpected end of checkpoint");
+    }
+
+    mMemory.applyDelta(in);
+}
+
+u64 cold::VirtualMachine::execute(const u64 maxInstructions) {
+    const u64 executed = mEngine->execute(mProcessor, mMemory, maxInstructions);
+
+    mInstructionCount += executed;
+    return executed;
+}
+
+u64 cold::VirtualMachine::executeBlock(const u64 maxInstructions) {
+    const u64 executed = mEngine->executeBlock(mProcessor, mMemory, maxInstructions);
+
+    mInstructionCount += executed;
+    return executed;
+}
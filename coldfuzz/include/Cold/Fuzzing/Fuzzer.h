@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Cold/Common.h"
+#include "Cold/Instruction.h"
+#include "Cold/VirtualMachine.h"
+
+#include <array>
+#include <string>
+#include <vector>
+
+namespace cold::fuzzing {
+
+    // Runs a guest image against many inputs in process, the image is loaded once and memory is reset through dirty pages
+    class Fuzzer {
+    public:
+        static constexpr u32 cCoverageSize = 1 << 16;
+        static constexpr u32 cInputLengthRegister = 3;
+        static constexpr u32 cInputAddressRegister = 4; // The input is placed after the initialized data, the heap after the input
+
+        enum class Result {
+            Ok,
+            Crash,  // The guest faulted
+            Timeout // The instruction budget ran out
+        };
+
+        Fuzzer(const std::vector<cold::Instruction>& program, const u64 memorySize, const u64 instructionBudget);
+        ~Fuzzer() = default;
+
+        Result run(const u8* data, const std::size_t size);
+        bool updateCoverage(); // Folds the edges of the last run into the global coverage, returns whether anything new was hit
+
+        [[nodiscard]] const std::array<u8, cCoverageSize>& getTrace() const { return mTrace; } // Hit counts of the last run
+        [[nodiscard]] u32 getCoveredEdgeCount() const { return mCoveredEdgeCount; }
+        [[nodiscard]] u32 getMaxInputSize() const { return mMaxInputSize; }
+        [[nodiscard]] u32 getFaultPc() const { return mFaultPc; }
+        [[nodiscard]] const std::string& getFaultMessage() const { return mFaultMessage; }
+
+    private:
+        void recordEdge(const u32 from, const u32 to);
+
+        cold::VirtualMachine mVM;
+        cold::VirtualMachine::Snapshot mBase;
+        u64 mInstructionBudget;
+        u32 mInputBegin;
+        u32 mMaxInputSize;
+
+        std::array<u8, cCoverageSize> mTrace;
+        std::array<u8, cCoverageSize> mCoverage; // Bucketed hit counts seen over all runs
+        std::vector<u32> mTouched; // Trace entries written by the last run, so only those need clearing
+        u32 mCoveredEdgeCount;
+
+        u32 mFaultPc;
+        std::string mFaultMessage;
+    };
+
+}
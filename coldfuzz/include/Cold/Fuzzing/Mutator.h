@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Cold/Common.h"
+
+#include <random>
+#include <vector>
+
+namespace cold::fuzzing {
+
+    // Stacked byte level mutations, in the spirit of AFL havoc
+    class Mutator {
+    public:
+        Mutator(const u64 seed);
+        ~Mutator() = default;
+
+        void mutate(std::vector<u8>& input, const std::vector<std::vector<u8>>& corpus, const u32 maxSize);
+
+    private:
+        [[nodiscard]] u32 below(const u32 limit) { return static_cast<u32>(mRandom() % limit); }
+
+        std::mt19937_64 mRandom;
+    };
+
+}
@@ -0,0 +1,86 @@
+newoption {
+    trigger = "libfuzzer",
+    description = "Build coldfuzz as a libFuzzer target (clang only)"
+}
+
+project "coldfuzz"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++20"
+    staticruntime "off"
+    vectorextensions "AVX2"
+
+    targetdir ("bin/%{prj.name}-%{cfg.buildcfg}/out")
+    objdir ("bin/%{prj.name}-%{cfg.buildcfg}/int")
+    debugdir "../workdir"
+
+    links {
+        
+    }
+
+    includedirs {
+        "include",
+        "../coldemu/include",
+
+        -- Libraries
+        "../vendor/argparse/include"
+    }
+
+    files {
+        "src/**.cpp",
+        "../coldemu/src/**.cpp",
+    }
+
+    removefiles {
+        "../coldemu/src/Main.cpp",
+    }
+
+    flags {
+        "MultiProcessorCompile",
+        "ShadowedVariables",
+        "FatalWarnings"
+    }
+
+    filter "options:libfuzzer"
+        defines {
+            "COLDFUZZ_LIBFUZZER"
+        }
+        buildoptions {
+            "-fsanitize=fuzzer"
+        }
+        linkoptions {
+            "-fsanitize=fuzzer"
+        }
+
+    filter "system:linux"
+        links {
+            "pthread",
+            "dl"
+        }
+
+    filter "system:windows"
+        systemversion "latest"
+        defines {
+            "_CRT_SECURE_NO_WARNINGS"
+        }
+    
+    filter "configurations:Debug"
+        runtime "Debug"
+        optimize "off"
+        symbols "on"
+    
+    filter "configurations:Release"
+        runtime "Release"
+        optimize "speed"
+        symbols "on"
+        flags {
+            "LinkTimeOptimization"
+        }
+    
+    filter "configurations:Dist"
+        runtime "Release"
+        optimize "speed"
+        symbols "off"
+        flags {
+            "LinkTimeOptimization"
+        }
@@ -0,0 +1,133 @@
+#include "Cold/Fuzzing/Fuzzer.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace coldfuzz = cold::fuzzing;
+
+namespace {
+
+    // Hit counts are compared in power of two buckets so loops do not flood the corpus
+    u8 bucket(const u8 count) {
+        if (count <= 2) return count;
+        if (count == 3) return 4;
+        if (count < 8) return 8;
+        if (count < 16) return 16;
+        if (count < 32) return 32;
+        if (count < 128) return 64;
+        return 128;
+    }
+
+}
+
+coldfuzz::Fuzzer::Fuzzer(const std::vector<cold::Instruction>& program, const u64 memorySize, const u64 instructionBudget)
+    : mVM(program, memorySize)
+    , mBase()
+    , mInstructionBudget(instructionBudget)
+    , mInputBegin(0)
+    , mMaxInputSize(0)
+    , mTrace()
+    , mCoverage()
+    , mTouched()
+    , mCoveredEdgeCount(0)
+    , mFaultPc(0)
+{
+    mVM.getProcessor().setOutput(nullptr);
+
+    const cold::Memory& memory = mVM.getMemory();
+    mInputBegin = memory.getDataEnd();
+    mMaxInputSize = static_cast<u32>(memory.getSize() - mInputBegin);
+
+    mBase = mVM.snapshot();
+}
+
+coldfuzz::Fuzzer::Result coldfuzz::Fuzzer::run(const u8* data, const std::size_t size) {
+    mVM.restore(mBase);
+
+    for (const u32 index : mTouched) {
+        mTrace[index] = 0;
+    }
+    mTouched.clear();
+
+    cold::Memory& memory = mVM.getMemory();
+    cold::Processor& processor = mVM.getProcessor();
+    cold::Processor::Registers& registers = processor.getRegisters();
+
+    const u32 inputSize = static_cast<u32>(std::min<std::size_t>(size, mMaxInputSize));
+    for (u32 i = 0; i < inputSize; i++) {
+        memory.writeRW(mInputBegin + i) = data[i];
+    }
+
+    // The base snapshot has not allocated yet, so the heap begins past this input
+    memory.setDataEnd(mInputBegin + inputSize);
+
+    registers.gpr[cInputAddressRegister] = mInputBegin;
+    registers.gpr[cInputLengthRegister] = inputSize;
+
+    try {
+        u64 executed = 0;
+
+        while (!processor.isFinished()) [[likely]] {
+            if (executed++ == mInstructionBudget) [[unlikely]] {
+                return Result::Timeout;
+            }
+
+            const u32 pc = registers.pc;
+            const cold::Instruction instr = memory.readX(pc * 4);
+
+            const u8 type = instr.getType();
+            if (type >= (int)cold::Instruction::Type::Count) [[unlikely]] {
+                throw std::runtime_error("Invalid instruction type");
+            }
+
+            const auto handler = cold::Processor::sInstructionHandlers[type];
+            (processor.*handler)(instr);
+
+            registers.pc++;
+
+            // Taken and fall-through outcomes of a branch land in different entries
+            if (instr.isBranch()) {
+                this->recordEdge(pc, registers.pc);
+            }
+        }
+    } catch (const std::exception& e) {
+        mFaultPc = registers.pc;
+        mFaultMessage = e.what();
+
+        return Result::Crash;
+    }
+
+    return Result::Ok;
+}
+
+bool coldfuzz::Fuzzer::updateCoverage() {
+    bool newCoverage = false;
+
+    for (const u32 index : mTouched) {
+        const u8 hits = bucket(mTrace[index]);
+
+        if (hits & ~mCoverage[index]) {
+            if (mCoverage[index] == 0) {
+                mCoveredEdgeCount++;
+            }
+
+            mCoverage[index] |= hits;
+            newCoverage = true;
+        }
+    }
+
+    return newCoverage;
+}
+
+void coldfuzz::Fuzzer::recordEdge(const u32 from, const u32 to) {
+    const u32 index = (from * 0x9E3779B1u ^ to * 0x85EBCA6Bu) >> 16;
+
+    u8& count = mTrace[index];
+    if (count == 0) {
+        mTouched.push_back(index);
+    }
+
+    if (count != 0xFF) {
+        count++;
+    }
+}
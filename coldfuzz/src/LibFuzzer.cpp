@@ -0,0 +1,70 @@
+#ifdef COLDFUZZ_LIBFUZZER
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Cold/Fuzzing/Fuzzer.h"
+
+namespace coldfuzz = cold::fuzzing;
+
+namespace {
+
+    // libFuzzer treats this section as additional coverage counters, which is how guest edges drive its mutations
+    __attribute__((used, section("__libfuzzer_extra_counters")))
+    u8 sExtraCounters[coldfuzz::Fuzzer::cCoverageSize];
+
+    std::unique_ptr<coldfuzz::Fuzzer> sFuzzer;
+
+    u64 environmentValue(const char* name, const u64 fallback) {
+        const char* value = std::getenv(name);
+        return value != nullptr ? static_cast<u64>(std::stoull(value, nullptr, 0)) : fallback;
+    }
+
+}
+
+// The guest image is configured through COLDFUZZ_PATH, COLDFUZZ_MEMORY and COLDFUZZ_BUDGET
+extern "C" int LLVMFuzzerInitialize(int*, char***) {
+    const char* path = std::getenv("COLDFUZZ_PATH");
+    if (path == nullptr) {
+        std::cerr << "COLDFUZZ_PATH is not set" << std::endl;
+        std::abort();
+    }
+
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file: " << path << std::endl;
+        std::abort();
+    }
+
+    const std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::vector<cold::Instruction> program(bytes.size() / sizeof(cold::Instruction));
+    std::memcpy(program.data(), bytes.data(), program.size() * sizeof(cold::Instruction));
+
+    sFuzzer = std::make_unique<coldfuzz::Fuzzer>(program, environmentValue("COLDFUZZ_MEMORY", 1024), environmentValue("COLDFUZZ_BUDGET", 100000));
+
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const u8* data, const std::size_t size) {
+    const coldfuzz::Fuzzer::Result result = sFuzzer->run(data, size);
+
+    const auto& trace = sFuzzer->getTrace();
+    std::copy(trace.begin(), trace.end(), sExtraCounters);
+
+    if (result == coldfuzz::Fuzzer::Result::Crash) {
+        std::cerr << "Guest crash at @" << sFuzzer->getFaultPc() << ": " << sFuzzer->getFaultMessage() << std::endl;
+        std::abort();
+    }
+
+    return 0;
+}
+
+#endif
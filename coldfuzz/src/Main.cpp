@@ -0,0 +1,190 @@
+#ifndef COLDFUZZ_LIBFUZZER // libFuzzer provides its own main
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <argparse/argparse.hpp>
+
+#include "Cold/Fuzzing/Fuzzer.h"
+#include "Cold/Fuzzing/Mutator.h"
+
+namespace coldfuzz = cold::fuzzing;
+
+namespace {
+
+    std::vector<u8> readFile(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file: " + path.string());
+        }
+
+        return std::vector<u8>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    // Inputs are named after their contents so saving one twice is harmless
+    std::string inputName(const std::vector<u8>& input) {
+        u64 hash = 0xCBF29CE484222325;
+        for (const u8 byte : input) {
+            hash = (hash ^ byte) * 0x100000001B3;
+        }
+
+        std::stringstream stream;
+        stream << std::hex << std::setw(16) << std::setfill('0') << hash;
+        return stream.str();
+    }
+
+    void saveInput(const std::filesystem::path& directory, const std::string& prefix, const std::vector<u8>& input) {
+        std::filesystem::create_directories(directory);
+
+        std::ofstream file(directory / (prefix + inputName(input)), std::ios::out | std::ios::binary);
+        file.write(reinterpret_cast<const char*>(input.data()), input.size());
+    }
+
+}
+
+std::vector<cold::Instruction> loadProgram(const std::string& inputFile) {
+    const std::vector<u8> bytes = readFile(inputFile);
+
+    std::vector<cold::Instruction> program(bytes.size() / sizeof(cold::Instruction));
+    std::memcpy(program.data(), bytes.data(), program.size() * sizeof(cold::Instruction));
+
+    return program;
+}
+
+int main(int argc, char** argv) {
+    argparse::ArgumentParser args("coldfuzz");
+    args.add_argument("-p", "--path")
+        .help("path to the program file")
+        .required();
+
+    args.add_argument("-m", "--memory")
+        .help("memory size in bytes, up to 4 GiB")
+        .default_value(static_cast<u64>(1024)) // 1 KB
+        .scan<'i', u64>();
+
+    args.add_argument("-c", "--corpus")
+        .help("directory of seed inputs, inputs reaching new coverage are added to it");
+
+    args.add_argument("--crashes")
+        .help("directory that crashing inputs are written to")
+        .default_value(std::string("crashes"));
+
+    args.add_argument("-n", "--runs")
+        .help("number of inputs to run, 0 runs forever")
+        .default_value(0)
+        .scan<'i', s32>();
+
+    args.add_argument("--max-len")
+        .help("maximum input length in bytes")
+        .default_value(4096)
+        .scan<'i', s32>();
+
+    args.add_argument("--budget")
+        .help("instructions per input before it counts as a timeout")
+        .default_value(100000)
+        .scan<'i', s32>();
+
+    args.add_argument("-s", "--seed")
+        .help("random seed")
+        .default_value(0)
+        .scan<'i', s32>();
+
+    try {
+        args.parse_args(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << args;
+        return 1;
+    }
+
+    try {
+        coldfuzz::Fuzzer fuzzer(loadProgram(args.get<std::string>("--path")), args.get<u64>("--memory"), args.get<s32>("--budget"));
+        coldfuzz::Mutator mutator(args.get<s32>("--seed"));
+
+        const u32 maxSize = std::min<u32>(args.get<s32>("--max-len"), fuzzer.getMaxInputSize());
+        const u64 runs = args.get<s32>("--runs");
+        const std::filesystem::path crashDirectory = args.get<std::string>("--crashes");
+        const auto corpusDirectory = args.present("--corpus");
+
+        std::vector<std::vector<u8>> corpus;
+        corpus.push_back({});
+
+        if (corpusDirectory.has_value() && std::filesystem::is_directory(*corpusDirectory)) {
+            for (const auto& entry : std::filesystem::directory_iterator(*corpusDirectory)) {
+                if (entry.is_regular_file()) {
+                    corpus.push_back(readFile(entry.path()));
+                }
+            }
+        }
+
+        // Seeds only count toward coverage, they are not mutated until they prove useful
+        std::vector<std::vector<u8>> queue;
+        for (const auto& seed : corpus) {
+            fuzzer.run(seed.data(), seed.size());
+            if (fuzzer.updateCoverage() || queue.empty()) {
+                queue.push_back(seed);
+            }
+        }
+        corpus = std::move(queue);
+
+        std::set<std::pair<u32, std::string>> faults;
+        u64 timeouts = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        auto lastReport = start;
+
+        std::vector<u8> input;
+        for (u64 run = 1; runs == 0 || run <= runs; run++) {
+            input = corpus[run % corpus.size()];
+            mutator.mutate(input, corpus, maxSize);
+
+            const coldfuzz::Fuzzer::Result result = fuzzer.run(input.data(), input.size());
+
+            if (result == coldfuzz::Fuzzer::Result::Crash) {
+                // Crashes are deduplicated by where and how the guest faulted
+                if (faults.emplace(fuzzer.getFaultPc(), fuzzer.getFaultMessage()).second) {
+                    std::cout << "Crash at @" << fuzzer.getFaultPc() << ": " << fuzzer.getFaultMessage() << std::endl;
+                    saveInput(crashDirectory, "crash-", input);
+                }
+            } else if (result == coldfuzz::Fuzzer::Result::Timeout) {
+                timeouts++;
+            }
+
+            if (fuzzer.updateCoverage()) {
+                corpus.push_back(input);
+
+                if (corpusDirectory.has_value()) {
+                    saveInput(*corpusDirectory, "", input);
+                }
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            if ((run & 0xFFF) == 0 && now - lastReport >= std::chrono::seconds(1)) {
+                const double seconds = std::chrono::duration<double>(now - start).count();
+
+                std::cout << "#" << run << " execs/s: " << static_cast<u64>(run / seconds) << " edges: " << fuzzer.getCoveredEdgeCount()
+                          << " corpus: " << corpus.size() << " crashes: " << faults.size() << " timeouts: " << timeouts << std::endl;
+
+                lastReport = now;
+            }
+        }
+
+        std::cout << "Done, edges: " << fuzzer.getCoveredEdgeCount() << " corpus: " << corpus.size() << " crashes: " << faults.size() << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+#endif
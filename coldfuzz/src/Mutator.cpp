@@ -0,0 +1,80 @@
+#include "Cold/Fuzzing/Mutator.h"
+
+#include <algorithm>
+
+namespace coldfuzz = cold::fuzzing;
+
+namespace {
+
+    constexpr u8 cInterestingBytes[] = { 0x00, 0x01, 0x7F, 0x80, 0xFF, '0', 'A', ' ', '\n' };
+
+}
+
+coldfuzz::Mutator::Mutator(const u64 seed)
+    : mRandom(seed)
+{ }
+
+void coldfuzz::Mutator::mutate(std::vector<u8>& input, const std::vector<std::vector<u8>>& corpus, const u32 maxSize) {
+    const u32 rounds = 1 << this->below(5);
+
+    for (u32 round = 0; round < rounds; round++) {
+        if (input.empty()) {
+            input.push_back(static_cast<u8>(mRandom()));
+            continue;
+        }
+
+        const u32 position = this->below(static_cast<u32>(input.size()));
+
+        switch (this->below(8)) {
+            case 0: // Flip a bit
+                input[position] ^= 1 << this->below(8);
+                break;
+
+            case 1: // Random byte
+                input[position] = static_cast<u8>(mRandom());
+                break;
+
+            case 2: // Interesting byte
+                input[position] = cInterestingBytes[this->below(sizeof(cInterestingBytes))];
+                break;
+
+            case 3: // Small arithmetic
+                input[position] += static_cast<u8>(this->below(35)) - 17;
+                break;
+
+            case 4: // Insert a byte
+                if (input.size() < maxSize) {
+                    input.insert(input.begin() + position, static_cast<u8>(mRandom()));
+                }
+                break;
+
+            case 5: // Erase a range
+                if (input.size() > 1) {
+                    const u32 length = 1 + this->below(std::min<u32>(static_cast<u32>(input.size()) - position, 16));
+                    input.erase(input.begin() + position, input.begin() + position + length);
+                }
+                break;
+
+            case 6: { // Copy a range within the input
+                const u32 source = this->below(static_cast<u32>(input.size()));
+                const u32 length = 1 + this->below(static_cast<u32>(input.size()) - std::max(source, position));
+                std::copy_n(std::vector<u8>(input.begin() + source, input.begin() + source + length).begin(), length, input.begin() + position);
+                break;
+            }
+
+            case 7: { // Splice in the tail of another corpus entry
+                const std::vector<u8>& other = corpus[this->below(static_cast<u32>(corpus.size()))];
+                if (!other.empty()) {
+                    const u32 split = this->below(static_cast<u32>(other.size()));
+                    input.resize(position);
+                    input.insert(input.end(), other.begin() + split, other.end());
+                }
+                break;
+            }
+        }
+    }
+
+    if (input.size() > maxSize) {
+        input.resize(maxSize);
+    }
+}
@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <argparse/argparse.hpp>
+
+#include "Cold/Disassembly/Disassembler.h"
+#include "Cold/TraceFormat.h"
+#include "Cold/TraceReader.h"
+
+namespace {
+
+    void printEntry(const cold::disassembly::Disassembler& disassembler, const cold::TraceReader::Entry& entry) {
+        std::cout << "#" << std::dec << entry.index << " @" << entry.pc << ": ";
+
+        if (!entry.fault.empty()) {
+            std::cout << "fault: " << entry.fault << "\n";
+            return;
+        }
+
+        std::cout << disassembler.disassemble(entry.instr);
+
+        if (entry.tags & cold::trace::Register) {
+            std::cout << "    ; r" << (u32)*entry.instr.getOutputRegister() << " = 0x" << std::hex << entry.value;
+        } else if ((entry.tags & cold::trace::Memory) && entry.instr.getType() == (u8)cold::Instruction::Type::SYSCALL) {
+            std::cout << "    ; [0x" << std::hex << entry.address << "] <- 0x" << entry.size << " bytes";
+        } else if (entry.tags & cold::trace::Memory) {
+            std::cout << "    ; [0x" << std::hex << entry.address << "] = 0x" << entry.value;
+        }
+
+        std::cout << "\n";
+    }
+
+}
+
+void printStats(cold::TraceReader& reader) {
+    cold::TraceReader::Entry entry;
+    u64 entries = 0;
+    u64 stores = 0;
+    u64 jumps = 0;
+
+    while (reader.next(entry)) {
+        entries++;
+        stores += (entry.tags & cold::trace::Memory) != 0;
+        jumps += (entry.tags & cold::trace::Jump) != 0;
+
+        if (!entry.fault.empty()) {
+            std::cout << "Fault at @" << entry.pc << ": " << entry.fault << "\n";
+        }
+    }
+
+    std::cout << "Entries: " << entries << "\n";
+    std::cout << "Stores: " << stores << "\n";
+    std::cout << "Taken branches: " << jumps << "\n";
+}
+
+void dump(cold::TraceReader& reader, const u64 from, const u64 count) {
+    std::vector<cold::Instruction> code = reader.getCode();
+    const cold::disassembly::Disassembler disassembler(code);
+
+    // Skip straight to the chunk holding the first entry
+    const std::vector<cold::trace::Chunk>& chunks = reader.getChunks();
+    const auto chunk = std::ranges::upper_bound(chunks, from, {}, &cold::trace::Chunk::firstEntry);
+    if (chunk != chunks.begin()) {
+        reader.seek(static_cast<std::size_t>(chunk - chunks.begin() - 1));
+    }
+
+    cold::TraceReader::Entry entry;
+    while (reader.next(entry) && entry.index < from + count) {
+        if (entry.index >= from) {
+            printEntry(disassembler, entry);
+        }
+    }
+}
+
+// Keeps the last store before entry end that covered the address
+std::optional<cold::TraceReader::Entry> scanForWrite(cold::TraceReader& reader, const u32 address, const u64 end) {
+    cold::TraceReader::Entry entry;
+    std::optional<cold::TraceReader::Entry> lastWrite;
+
+    while (reader.next(entry) && entry.index < end) {
+        if ((entry.tags & cold::trace::Memory) && address - entry.address < entry.size) {
+            lastWrite = entry;
+        }
+    }
+
+    return lastWrite;
+}
+
+// Walks the chunks from the end and only decodes the ones whose stores may cover the address
+void findLastWrite(cold::TraceReader& reader, const u32 address) {
+    std::vector<cold::Instruction> code = reader.getCode();
+    const cold::disassembly::Disassembler disassembler(code);
+
+    const std::vector<cold::trace::Chunk>& chunks = reader.getChunks();
+    std::optional<cold::TraceReader::Entry> lastWrite;
+
+    if (chunks.empty()) {
+        lastWrite = scanForWrite(reader, address, std::numeric_limits<u64>::max());
+    }
+
+    for (std::size_t i = chunks.size(); i-- > 0 && !lastWrite.has_value();) {
+        if (chunks[i].mayContain(address)) {
+            reader.seek(i);
+            lastWrite = scanForWrite(reader, address, i + 1 < chunks.size() ? chunks[i + 1].firstEntry : reader.getEntryCount());
+        }
+    }
+
+    if (!lastWrite.has_value()) {
+        std::cout << "0x" << std::hex << address << " is never written" << std::endl;
+        return;
+    }
+
+    printEntry(disassembler, *lastWrite);
+}
+
+int main(int argc, char** argv) {
+    argparse::ArgumentParser args("coldtrace");
+    args.add_argument("-i", "--input")
+        .help("trace file recorded with coldemu --trace")
+        .required();
+
+    args.add_argument("-w", "--last-write")
+        .help("find the last instruction that wrote this address");
+
+    args.add_argument("-d", "--dump")
+        .help("print the traced instructions")
+        .default_value(false)
+        .implicit_value(true);
+
+    args.add_argument("--from")
+        .help("first entry to dump")
+        .default_value(0)
+        .scan<'i', s32>();
+
+    args.add_argument("--count")
+        .help("number of entries to dump")
+        .default_value(100)
+        .scan<'i', s32>();
+
+    try {
+        args.parse_args(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << args;
+        return 1;
+    }
+
+    try {
+        cold::TraceReader reader(args.get<std::string>("--input"));
+
+        if (const auto address = args.present("--last-write")) {
+            findLastWrite(reader, static_cast<u32>(std::stoul(*address, nullptr, 0)));
+        } else if (args.get<bool>("--dump")) {
+            dump(reader, args.get<s32>("--from"), args.get<s32>("--count"));
+        } else {
+            printStats(reader);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
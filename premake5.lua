@@ -9,3 +9,9 @@ outputdir = "%{cfg.system}-%{cfg.architecture}-%{cfg.buildcfg}"
 include "coldemu"
 include "coldasm"
 include "colddsm"
+include "coldcfg"
+include "coldaot"
+include "coldbench"
+include "coldfuzz"
+include "coldtrace"
+include "colddbg"
@@ -0,0 +1,10 @@
+SETI r1, 5
+STW r1, r0, -8
+SETI r1, 0
+B skip
+SET r3, r3
+STW r1, r0, -8
+skip:
+LDW r1, r0, -8
+SYSCALL IPRINT, r1
+SYSCALL HALT
@@ -1,24 +1,25 @@
-SETI r3, 9
-BL 2
+.include "frame.inc"
+.equ FRAME, 24
+.equ N, 9
+SETI r3, N
+BL fib
 SYSCALL HALT
-STW r0, r0, -24
-SUBI r0, r0, 24
-STW r31, r0, 12
+fib:
+PROLOGUE FRAME
 SET r31, r3
 CMPI r3, 1
-BLE 13
+BLE done
 MFLR r1
 STW r1, r0, 20
 STW r30, r0, 8
 SUBI r3, r3, 1
-BL -10
+BL fib
 SET r30, r3
 SUBI r3, r31, 2
-BL -13
+BL fib
 ADD r3, r30, r3
 LDW r30, r0, 8
 LDW r1, r0, 20
 MTLR r1
-LDW r31, r0, 12
-ADDI r0, r0, 24
-BLR
+done:
+EPILOGUE FRAME